@@ -0,0 +1,165 @@
+// Solving a maze in-process through libmaze.
+//
+// The maze is read into memory by the caller and parsed from the
+// buffer; all library allocations go through a counting allocator,
+// which must be back to zero once the maze is freed. The maze is solved
+// twice on the same handle, and both solves must give the same path.
+//
+// build: make lib && cc -Iinclude examples/embed.c -L. -lmaze
+// usage: ./embed <maze_file>
+
+#include "libmaze.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  size_t live_bytes;
+  size_t peak_bytes;
+} Counter;
+
+static void* count_alloc(void* ctx, size_t size) {
+  Counter* c = ctx;
+  void* ptr = malloc(size);
+
+  if (ptr) {
+    c->live_bytes += size;
+    if (c->live_bytes > c->peak_bytes) {
+      c->peak_bytes = c->live_bytes;
+    }
+  }
+  return ptr;
+}
+
+static void* count_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+  Counter* c = ctx;
+  void* grown = realloc(ptr, new_size);
+
+  if (grown) {
+    c->live_bytes += new_size - old_size;
+    if (c->live_bytes > c->peak_bytes) {
+      c->peak_bytes = c->live_bytes;
+    }
+  }
+  return grown;
+}
+
+static void count_free(void* ctx, void* ptr, size_t size) {
+  Counter* c = ctx;
+
+  c->live_bytes -= size;
+  free(ptr);
+}
+
+static char* read_file(const char* filename, size_t* size) {
+  FILE* fp = fopen(filename, "rb");
+  char* data;
+  long len;
+
+  if (!fp) {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  data = malloc(len > 0 ? (size_t)len : 1);
+  if (data && fread(data, 1, (size_t)len, fp) != (size_t)len) {
+    free(data);
+    data = NULL;
+  }
+  fclose(fp);
+  *size = (size_t)len;
+  return data;
+}
+
+int main(int argc, char* argv[]) {
+  Counter counter = { 0, 0 };
+  MazeAllocator alloc = { count_alloc, count_realloc, count_free, &counter };
+  MazeStatus status, again;
+  Maze* maze;
+  const int* path;
+  char* grid;
+  char* data;
+  size_t size;
+  int* first = NULL;
+  int length, first_length = 0;
+  int i, x, y;
+
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <maze_file>\n", argv[0]);
+    return 1;
+  }
+
+  data = read_file(argv[1], &size);
+  if (!data) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  status = maze_load_buffer(data, size, &alloc, &maze);
+  free(data);
+  if (status != MAZE_OK) {
+    fprintf(stderr, "load: %s\n", maze_strerror(status));
+    return 1;
+  }
+
+  status = maze_validate(maze);
+  if (status == MAZE_OK) {
+    status = maze_solve(maze, MAZE_ALGO_ASTAR, NULL, NULL);
+  }
+  if (status == MAZE_OK) {
+    path = maze_path(maze, &first_length);
+    first = malloc((size_t)first_length * sizeof(int));
+    if (!first) {
+      fprintf(stderr, "out of memory\n");
+      maze_free(maze);
+      return 1;
+    }
+    memcpy(first, path, (size_t)first_length * sizeof(int));
+  }
+
+  // the grid is left as loaded, so a second solve must find the same path
+  if (status == MAZE_OK || status == MAZE_NO_PATH) {
+    again = maze_solve(maze, MAZE_ALGO_ASTAR, NULL, NULL);
+    path = maze_path(maze, &length);
+    if (again != status || length != first_length
+        || (length && memcmp(path, first, (size_t)length * sizeof(int)) != 0)) {
+      fprintf(stderr, "second solve differs: %s\n", maze_strerror(again));
+      free(first);
+      maze_free(maze);
+      return 1;
+    }
+  }
+
+  if (status == MAZE_OK) {
+    // overlay the path on a copy of the grid
+    grid = malloc((size_t)maze_width(maze) * maze_height(maze));
+    if (!grid) {
+      fprintf(stderr, "out of memory\n");
+      free(first);
+      maze_free(maze);
+      return 1;
+    }
+    memcpy(grid, maze_grid(maze), (size_t)maze_width(maze) * maze_height(maze));
+    for (i = 0; i < first_length; i++) {
+      grid[first[i]] = 'o';
+    }
+    for (y = 0; y < maze_height(maze); y++) {
+      for (x = 0; x < maze_width(maze); x++) {
+        putchar(grid[y * maze_width(maze) + x]);
+      }
+      putchar('\n');
+    }
+    free(grid);
+  } else {
+    printf("no solution found\n");
+  }
+
+  free(first);
+  maze_free(maze);
+  if (counter.live_bytes != 0) {
+    fprintf(stderr, "leaked %zu bytes\n", counter.live_bytes);
+    return 1;
+  }
+  return 0;
+}
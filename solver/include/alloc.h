@@ -0,0 +1,24 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include "libmaze.h"
+
+// Internal allocation helpers: every allocation goes through a
+// MazeAllocator (NULL = default malloc-based one).
+
+// malloc-backed? (NULL or a copy of the default allocator)
+bool mem_is_default(const MazeAllocator* a);
+
+// allocate size bytes
+void* mem_alloc(const MazeAllocator* a, size_t size);
+
+// allocate size zeroed bytes (calloc for the default allocator)
+void* mem_zalloc(const MazeAllocator* a, size_t size);
+
+// resize, contents up to min(old_size, new_size) are kept
+void* mem_realloc(const MazeAllocator* a, void* ptr, size_t old_size, size_t new_size);
+
+// release ptr (size = size it was allocated with)
+void mem_free(const MazeAllocator* a, void* ptr, size_t size);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "libmaze.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Per-solve arena: one region reserved up front, handed out as aligned
+// sub-arrays and released in one call.
+//
+// With the default allocator large arenas are mmap'd directly, so fresh
+// pages are already zero. On request they are backed by huge pages:
+// explicit ones (MAP_HUGETLB) when the system has some reserved, else a
+// 2 MB aligned mapping advised with MADV_HUGEPAGE, and W*H search arrays
+// then cost a fraction of the TLB entries. With a custom allocator the
+// region is a single block from it.
+
+// alignment of every sub-array (a cache line)
+#define ARENA_ALIGN 64
+
+// bytes to reserve for n sub-arrays totalling size bytes
+#define ARENA_SIZE(size, n) ((size) + (size_t)(n) * ARENA_ALIGN)
+
+typedef struct {
+  char* base;                   // aligned start of the region
+  size_t size;                  // usable bytes
+  size_t used;                  // bytes handed out
+  void* map;                    // mapping to unmap (NULL: block from alloc)
+  size_t map_size;
+  bool zeroed;                  // unused bytes are known to be zero
+  const MazeAllocator* alloc;   // source of the block when not mapped
+} Arena;
+
+// reserve size bytes (huge_pages: back a mapped region with huge pages)
+bool arena_init(Arena* arena, size_t size, const MazeAllocator* alloc, bool huge_pages);
+
+// next ARENA_ALIGN-aligned sub-array, NULL when the reservation is exhausted
+void* arena_push(Arena* arena, size_t size);
+
+// same, zero-filled (free for fresh mappings)
+void* arena_push_zero(Arena* arena, size_t size);
+
+// allocator view handing out sub-arrays (free is a no-op), for
+// structures that take a MazeAllocator
+MazeAllocator arena_allocator(Arena* arena);
+
+// release the whole region
+void arena_release(Arena* arena);
+
+#endif
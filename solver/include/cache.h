@@ -0,0 +1,91 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "solver.h"
+#include <stdint.h>
+
+// Result cache (CLI only): solutions keyed by the content hash the
+// loader computes (Maze.hash), the dimensions and the solver setup. A
+// hit hands back the stored path, or "no path", without any search.
+//
+// Entries are held in an in-memory table (directory runs) and, with a
+// cache directory, in one file per entry that later runs map back in:
+//   DIR/<hash>_<width>x<height>_a<algo>_f<flags>_l<landmarks>.mzc
+//   CacheFileHeader, then length cells (u32, row-major), native byte
+//   order (a cache directory belongs to one machine)
+// Files are written under a temporary name and renamed into place, so
+// concurrent runs sharing a directory never see a torn entry.
+
+#define CACHE_MAGIC "MZC1"
+
+// bytes of in-memory paths in directory runs
+#define CACHE_MEM_DEFAULT ((size_t)64 << 20)
+
+// key flags
+#define CACHE_DIAGONAL 1
+#define CACHE_ALT      2  // A* with landmark bounds (ties may break differently)
+
+// what a solution depends on besides the grid
+typedef struct {
+  uint64_t hash;  // Maze.hash
+  int width;
+  int height;
+  int algo;       // MazeAlgorithm as asked for (AUTO picks the same every time)
+  int flags;      // CACHE_*
+  int landmarks;  // ALT landmark count (0 without CACHE_ALT): ties break by it
+} CacheKey;
+
+typedef struct {
+  char magic[4];
+  uint32_t status;  // MAZE_OK or MAZE_NO_PATH
+  uint64_t hash;
+  uint32_t width, height;
+  uint32_t algo, flags;
+  uint32_t length;  // path cells (0 without a path)
+  uint32_t landmarks;
+  double cost;      // terrain cost of the path
+} CacheFileHeader;
+
+typedef struct {
+  CacheKey key;
+  MazeStatus status;
+  int length;
+  double cost;
+  int* cells;
+  bool used;
+} CacheEntry;
+
+typedef struct {
+  const char* dir;     // entry files (NULL = memory only)
+  size_t mem_limit;    // in-memory budget (0 = no table)
+  size_t mem_used;
+  CacheEntry* table;   // open addressing, capacity a power of two
+  int capacity;
+  int count;
+  int hits;
+  int misses;
+} ResultCache;
+
+// cache over dir (NULL = memory only, else created when missing) with
+// up to mem_limit bytes of entries in memory; MAZE_ERR_IO when dir
+// cannot be created
+MazeStatus cache_open(const char* dir, size_t mem_limit, ResultCache** out);
+
+void cache_close(ResultCache* cache);
+
+// key of maze solved with algo and opts (landmarks: ALT landmark count,
+// 0 = plain search)
+CacheKey cache_key(const Maze* maze, MazeAlgorithm algo, const SolverOptions* opts, int landmarks);
+
+// stored result of key: true on a hit with *status MAZE_OK (the path put
+// on maze, its terrain cost in *cost) or MAZE_NO_PATH
+bool cache_lookup(ResultCache* cache, const CacheKey* key, Maze* maze, MazeStatus* status,
+                  double* cost);
+
+// remember status (MAZE_OK with maze's path, or MAZE_NO_PATH) for key;
+// call before the grid is marked. MAZE_ERR_IO if the entry file could
+// not be written (the in-memory entry is kept)
+MazeStatus cache_store(ResultCache* cache, const CacheKey* key, const Maze* maze,
+                       MazeStatus status);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "solver.h"
+#include <stdint.h>
+
+// ALT (A*, Landmarks, Triangle inequality): exact distances from a few
+// landmark cells bound the distance between any two cells,
+//   d(v, goal) >= |d(L, goal) - d(L, v)|
+// which is far tighter than Manhattan distance in winding mazes.
+// Uniform terrain only: the bound needs d(a, b) == d(b, a).
+
+// landmarks per maze
+#define LANDMARKS_MAX     16
+#define LANDMARKS_DEFAULT 8
+
+// distance of a cell the landmark cannot reach
+#define LANDMARK_INF UINT32_MAX
+
+struct Landmarks {
+  int count;
+  bool diagonal;             // distances in COST_STRAIGHT/COST_DIAGONAL units
+  int cells[LANDMARKS_MAX];  // landmark positions
+  uint32_t* dist;            // dist[cell * count + i], interleaved per cell
+  uint64_t grid_hash;        // Maze.hash of the grid the tables were built for
+};
+
+// pick count landmarks by farthest-point selection and build their
+// distance tables (BFS, or octile-cost Dijkstra when diagonal)
+MazeStatus build_landmarks(Maze* maze, bool diagonal, int count);
+
+// load tables saved for this exact grid, mode and count
+// (MAZE_ERR_IO when the file is missing or was built for something else)
+MazeStatus load_landmarks(Maze* maze, bool diagonal, int count, const char* filename);
+
+// save the tables next to their grid hash
+MazeStatus save_landmarks(const Maze* maze, const char* filename);
+
+// drop the tables (the grid changed)
+void free_landmarks(Maze* maze);
+
+// tables built for this movement mode? (never on weighted terrain)
+static inline bool landmarks_match(const Maze* maze, bool diagonal) {
+  return maze->landmarks && !maze->weighted && maze->landmarks->diagonal == diagonal;
+}
+
+// best triangle-inequality bound on the distance from cell to the goal
+// (goal_dist[i] = d(landmark i, goal))
+static inline uint32_t landmark_bound(const Landmarks* lm, const uint32_t* goal_dist, int cell) {
+  const uint32_t* d = lm->dist + (size_t)cell * lm->count;
+  uint32_t best = 0;
+  uint32_t diff;
+  int i;
+
+  for (i = 0; i < lm->count; i++) {
+    if (d[i] == LANDMARK_INF || goal_dist[i] == LANDMARK_INF) {
+      continue;
+    }
+    diff = d[i] > goal_dist[i] ? d[i] - goal_dist[i] : goal_dist[i] - d[i];
+    if (diff > best) {
+      best = diff;
+    }
+  }
+  return best;
+}
+
+#endif
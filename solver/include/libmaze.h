@@ -0,0 +1,178 @@
+#ifndef LIBMAZE_H
+#define LIBMAZE_H
+
+// Embeddable maze solver (libmaze.a / libmaze.so)
+//
+// Reentrant: no global state and no output. Every call reports a
+// MazeStatus, and every allocation made for a maze goes through the
+// allocator it was loaded with, so callers can plug in their own arenas.
+// Different mazes may be used from different threads concurrently.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// exported from libmaze.so (everything else stays internal)
+#define MAZE_API __attribute__((visibility("default")))
+
+// ======== TYPES ===========
+
+// largest width and height of a maze (both parsers and validation)
+#define MAZE_MAX_SIZE 10000
+
+// Result of every library call
+typedef enum {
+  MAZE_OK = 0,          // success (for solvers: a path was found)
+  MAZE_NO_PATH,         // valid maze without a path (incl. blocked start/finish)
+  MAZE_ERR_ARG,         // NULL or out-of-range argument
+  MAZE_ERR_NOMEM,       // allocator returned NULL
+  MAZE_ERR_IO,          // file could not be opened or read
+  MAZE_ERR_EMPTY,       // empty input or empty first line
+  MAZE_ERR_SHORT_LINE,  // a row is shorter than the first one
+  MAZE_ERR_SIZE,        // width or height outside 1-10000
+  MAZE_ERR_CHAR,        // character other than '*', '1'-'9', 'E' or 'X'
+  MAZE_CANCELLED,       // search stopped through SolverOptions.cancel
+  MAZE_TIMEOUT          // deadline passed before any path was found
+} MazeStatus;
+
+// Allocator vtable; sizes are passed back on realloc/free so arenas
+// and pools need no headers. alloc and realloc are required, free may
+// be NULL (memory released by the owner of ctx, e.g. an arena reset).
+typedef struct {
+  void* (*alloc)(void* ctx, size_t size);
+  void* (*realloc)(void* ctx, void* ptr, size_t old_size, size_t new_size);
+  void (*free)(void* ctx, void* ptr, size_t size);
+  void* ctx;
+} MazeAllocator;
+
+// Opaque maze (grid, dimensions and per-maze caches)
+typedef struct Maze Maze;
+
+// Opaque search trace file (see maze_trace_open)
+typedef struct MazeTrace MazeTrace;
+
+// Search algorithm
+typedef enum {
+  MAZE_ALGO_BFS,
+  MAZE_ALGO_ASTAR,
+  MAZE_ALGO_DIJKSTRA,
+  MAZE_ALGO_JPS,
+  MAZE_ALGO_AUTO,     // pick one of the above from a quick sample of the grid
+  MAZE_ALGO_ANYTIME,  // weighted A*, tightened until optimal or the deadline
+  MAZE_ALGO_FRINGE    // optimal like A*, solver state capped at opts->mem_limit
+} MazeAlgorithm;
+
+// Search options (NULL = defaults: 4-directional movement)
+typedef struct {
+  bool diagonal;            // 8-directional movement, no corner cutting
+  bool huge_pages;          // back solver state with huge pages (large mazes)
+  size_t mem_limit;         // memory budget in bytes for bounded modes (0 = 256 MB, FRINGE >= 64 KB)
+  const atomic_bool* cancel; // set from another thread to stop the search (NULL = never)
+  unsigned timeout_ms;      // deadline of MAZE_ALGO_ANYTIME, from the call (0 = none)
+  MazeTrace* trace;         // log BFS, A* and Dijkstra expansions here (NULL = off)
+} SolverOptions;
+
+// One start/goal pair of a query batch (cell coordinates)
+typedef struct {
+  int start_x, start_y;
+  int goal_x, goal_y;
+} MazeQuery;
+
+// Performance statistics
+typedef struct {
+  double time_ms;           // execution time in milliseconds
+  int cells_visited;        // number of cells explored
+  int path_length;          // length of solution path (0 if no solution)
+  double path_cost;         // terrain cost of solution path (0 if no solution)
+  double bound;             // path_cost <= bound * optimal cost (1 = optimal)
+  const char* algorithm;    // "BFS", "A*", "A* (ALT)", "Dijkstra", "JPS", ...
+} SolverStats;
+
+// ======== FUNCTIONS ==========
+
+// malloc-based allocator used when NULL is passed
+MAZE_API const MazeAllocator* maze_default_allocator(void);
+
+// parse a maze from memory (rows separated by '\n', need not be
+// NUL-terminated, or run-length text starting with "MZR1 ", see
+// maze-rle); alloc NULL = default allocator
+MAZE_API MazeStatus maze_load_buffer(const char* data, size_t size, const MazeAllocator* alloc,
+                                     Maze** out);
+
+// load a maze file (either format)
+MAZE_API MazeStatus maze_load_file(const char* filename, const MazeAllocator* alloc, Maze** out);
+
+// check dimensions, characters and that start/finish are passable
+MAZE_API MazeStatus maze_validate(const Maze* maze);
+
+// label connected components so unsolvable mazes are answered instantly
+MAZE_API MazeStatus maze_precheck(Maze* maze);
+
+// build count ALT landmark tables (1-16) for opts' movement mode; A*
+// then uses them on every later solve of this maze. With cache_file the
+// tables are loaded from it when they match the grid, else built and
+// saved there. Uniform terrain only (MAZE_ERR_ARG on weighted mazes).
+MAZE_API MazeStatus maze_landmarks(Maze* maze, const SolverOptions* opts, int count,
+                                   const char* cache_file);
+
+// search for the nearest of several exits instead of the bottom-right
+// corner: the count cells given (row-major indices) plus, with
+// grid_exits, every 'E' of the grid. Later solves stop at the cheapest
+// exit (BFS, A*, Dijkstra and AUTO only, others give MAZE_ERR_ARG); an
+// empty set goes back to the corner. MAZE_ERR_ARG on out-of-range cells
+MAZE_API MazeStatus maze_set_exits(Maze* maze, const int* cells, int count, bool grid_exits);
+
+// exit cell the last solve ended at (-1 without exits or without a path)
+MAZE_API int maze_exit_reached(const Maze* maze);
+
+// solve; on MAZE_OK the path is kept on the maze for maze_path. The grid
+// is never marked, so the same maze can be solved again (stats may be
+// NULL, the stats-free build of the kernel is used then)
+MAZE_API MazeStatus maze_solve(Maze* maze, MazeAlgorithm algo, const SolverOptions* opts,
+                               SolverStats* stats);
+
+// open filename for search traces (alloc NULL = default allocator): each
+// BFS, A* or Dijkstra solve with opts->trace set appends the expansion
+// order, g/f at each pop and the frontier size (format in trace.h). One
+// solve at a time per trace
+MAZE_API MazeStatus maze_trace_open(const char* filename, const MazeAllocator* alloc,
+                                    MazeTrace** out);
+
+// write out the buffered records and close; MAZE_ERR_IO if any write failed
+MAZE_API MazeStatus maze_trace_close(MazeTrace* trace);
+
+// BFS distances (steps; 8-directional with opts->diagonal) for count
+// start/goal pairs: up to 64 searches advance together in one sweep over
+// the grid, one bit each per cell. distances[i] = -1 when query i has no
+// path. Coordinates outside the maze give MAZE_ERR_ARG (stats may be NULL)
+MAZE_API MazeStatus maze_solve_batch(Maze* maze, const SolverOptions* opts,
+                                     const MazeQuery* queries, int count, int* distances,
+                                     SolverStats* stats);
+
+// BFS path of a single query, kept on the maze for maze_path (the grid is
+// never marked); MAZE_NO_PATH when start or goal is blocked
+MAZE_API MazeStatus maze_solve_query(Maze* maze, const SolverOptions* opts,
+                                     const MazeQuery* query, SolverStats* stats);
+
+// dimensions and row-major grid (width * height chars, no newlines)
+MAZE_API int maze_width(const Maze* maze);
+MAZE_API int maze_height(const Maze* maze);
+MAZE_API const char* maze_grid(const Maze* maze);
+
+// 64-bit hash of the grid and dimensions, computed by the parser while
+// it copies the rows (no extra pass). Equal mazes hash equal, so callers
+// can key result caches on it; path marks and later edits leave it be
+MAZE_API uint64_t maze_content_hash(const Maze* maze);
+
+// cells of the last solution as row-major indices (y * width + x), start
+// to finish; NULL with *length = 0 when the last solve found no path
+MAZE_API const int* maze_path(const Maze* maze, int* length);
+
+// free the maze and everything allocated for it
+MAZE_API void maze_free(Maze* maze);
+
+// static description of a status code
+MAZE_API const char* maze_strerror(MazeStatus status);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef LPA_H
+#define LPA_H
+
+#include "solver.h"
+#include "priority_queue.h"
+#include "arena.h"
+#include <stdint.h>
+
+// Lifelong Planning A*: keeps g/rhs between wall updates and only
+// repairs the part of the search tree an edit touches.
+
+// Incremental planner state
+typedef struct {
+  Maze* maze;            // maze being planned on (grid edited in place)
+  bool diagonal;         // 8-directional movement
+  uint32_t* g;           // settled cost from start
+  uint32_t* rhs;         // one-step lookahead cost
+  unsigned long long* open_key; // key of the live open set entry per cell
+  unsigned char* in_open;
+  PriorityQueue* open_set;
+  int start_idx;
+  int finish_idx;
+  int expanded;          // cells expanded by the last lpa_compute
+  bool broken;           // a push failed: the open set misses a cell for good
+  Arena arena;           // backs g, rhs, open_key and in_open
+} LpaPlanner;
+
+// create planner for maze (does not search yet), NULL if out of memory;
+// state comes from the maze's allocator
+LpaPlanner* lpa_create(Maze* maze, const SolverOptions* opts);
+
+// (re)plan after the initial setup or any edits: MAZE_OK if a path
+// exists, else MAZE_NO_PATH. MAZE_ERR_NOMEM once the open set could not
+// grow; the plan is incomplete then and every later call fails the same way
+MazeStatus lpa_compute(LpaPlanner* lpa);
+
+// change cell (x, y) to c ('X', '*' or '1'-'9') and queue repairs
+// (MAZE_ERR_ARG outside the maze, MAZE_ERR_CHAR for other characters,
+// MAZE_ERR_NOMEM if a repair could not be queued)
+MazeStatus lpa_set_cell(LpaPlanner* lpa, int x, int y, char c);
+
+// store the current path in maze->path, returns its length
+// (0 = none or out of memory)
+int lpa_store_path(LpaPlanner* lpa, double* path_cost);
+
+// free planner (not the maze)
+void lpa_free(LpaPlanner* lpa);
+
+#endif
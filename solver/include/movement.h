@@ -0,0 +1,45 @@
+#ifndef MOVEMENT_H
+#define MOVEMENT_H
+
+#include "solver.h"
+
+// number of directions per movement mode
+#define DIRS_ORTHOGONAL 4
+#define DIRS_DIAGONAL   8
+
+// step costs in diagonal mode (5:7 ~ 1:sqrt(2), octile distance)
+#define COST_STRAIGHT 5
+#define COST_DIAGONAL 7
+
+// movement offsets: 4 orthogonal first (up, down, left, right), then diagonals
+static const int dir_dx[DIRS_DIAGONAL] = {0, 0, -1, 1, -1, 1, -1, 1};
+static const int dir_dy[DIRS_DIAGONAL] = {-1, 1, 0, 0, -1, -1, 1, 1};
+
+// check that (x, y) is inside the maze and passable
+static inline bool is_open(const Maze* maze, int x, int y) {
+  return IS_VALID_POS(x, y, maze->width, maze->height)
+      && IS_PASSABLE(maze->grid[IDX(x, y, maze->width)]);
+}
+
+// can we step from (x, y) in direction d?
+// diagonal steps may not cut corners: both orthogonal cells must be open
+static inline bool can_move(const Maze* maze, int x, int y, int d) {
+  if (!is_open(maze, x + dir_dx[d], y + dir_dy[d])) {
+    return false;
+  }
+  if (d < DIRS_ORTHOGONAL) {
+    return true;
+  }
+  return is_open(maze, x + dir_dx[d], y) && is_open(maze, x, y + dir_dy[d]);
+}
+
+// octile distance in COST_STRAIGHT / COST_DIAGONAL units
+static inline int octile_distance(int x, int y, int goal_x, int goal_y) {
+  int dist_x = (x > goal_x) ? (x - goal_x) : (goal_x - x);
+  int dist_y = (y > goal_y) ? (y - goal_y) : (goal_y - y);
+  int lo = dist_x < dist_y ? dist_x : dist_y;
+  int hi = dist_x < dist_y ? dist_y : dist_x;
+  return COST_STRAIGHT * hi + (COST_DIAGONAL - COST_STRAIGHT) * lo;
+}
+
+#endif
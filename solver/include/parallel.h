@@ -0,0 +1,18 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+// upper bound on worker threads
+#define PARALLEL_MAX_THREADS 64
+
+// worker count for up to `units` independent pieces of work:
+// online cores, capped at PARALLEL_MAX_THREADS and units (at least 1)
+int parallel_threads(long units);
+
+// run fn on each of the n tasks (an array of task_size records),
+// task 0 on the calling thread; a task whose thread cannot be
+// started runs inline
+void run_parallel(void* tasks, size_t task_size, int n, void* (*fn)(void*));
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "solver.h"
+
+// Directory runs (CLI only): the mazes of a directory go through three
+// stages on their own threads, reading, parsing + validation and
+// solving, so disk reads of the next mazes overlap with the solve of
+// the current one.
+
+// mazes in flight between two stages
+#define PIPELINE_DEPTH 8
+
+// solve every regular file of dir in name order with algo; one line per
+// maze on stdout ("file: N" cells on the path, "no solution found" or
+// an error), followed by the path in format unless it is PATH_GRID, and
+// stage timings on stderr with show_stats. precheck labels components in
+// the parse stage. Repeated mazes are answered from an in-memory result
+// cache, kept in cache_dir across runs when given (see cache.h). Returns
+// the exit code of the CLI
+int run_pipeline(const char* dir, MazeAlgorithm algo, const SolverOptions* opts,
+                 PathFormat format, bool precheck, const char* cache_dir, bool show_stats);
+
+#endif
@@ -2,11 +2,12 @@
 #define PRIORITY_QUEUE_H
 
 #include <stdbool.h>
+#include "libmaze.h"
 
 // Node for priority queue
 typedef struct {
-  int index;      // maze cell index
-  int priority;   // fscore for A*
+  int index;                    // maze cell index
+  unsigned long long priority;  // search key (two-part keys packed in 64 bits)
 } PQNode;
 
 // Priority Queue (min-heap)
@@ -14,13 +15,17 @@ typedef struct {
   PQNode* nodes;
   int size;
   int capacity;
+  const MazeAllocator* alloc;
 } PriorityQueue;
 
 // Create priority queue
-PriorityQueue* create_pq(int capacity);
+PriorityQueue* create_pq(int capacity, const MazeAllocator* alloc);
 
-// Insert with priority
-void pq_push(PriorityQueue* pq, int index, int priority);
+// Insert with priority (grows the heap when full)
+bool pq_push(PriorityQueue* pq, int index, unsigned long long priority);
+
+// Look at minimum priority element without removing it
+bool pq_peek(const PriorityQueue* pq, int* index, unsigned long long* priority);
 
 // Remove and return minimum priority element
 bool pq_pop(PriorityQueue* pq, int* index);
@@ -3,6 +3,7 @@
 
 // standard lib 
 #include <stdbool.h>
+#include "libmaze.h"
 
 // ======== STRUCT ========
 
@@ -12,11 +13,12 @@ typedef struct {
   int rear;       
   int capacity;   
   int size;       
+  const MazeAllocator* alloc;
 } Queue;
 
 // ======= FUNCTIONS ===========
 
-Queue* create_queue(int capacity);
+Queue* create_queue(int capacity, const MazeAllocator* alloc);
 
 bool enqueue(Queue* queue, int value);
 
@@ -0,0 +1,47 @@
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include <stdbool.h>
+#include "libmaze.h"
+
+// number of buckets: one for key == last plus one per key bit
+#define RADIX_BUCKETS 33
+
+// Node for radix heap
+typedef struct {
+  int index;           // maze cell index
+  unsigned int key;    // g for Dijkstra, f for A*
+} RadixNode;
+
+// Bucket of nodes sharing the same highest bit differing from last
+typedef struct {
+  RadixNode* nodes;
+  int size;
+  int capacity;
+} RadixBucket;
+
+// Monotone radix heap: pushed keys must never be below the last popped key
+typedef struct {
+  RadixBucket buckets[RADIX_BUCKETS];
+  unsigned int last;   // last popped key
+  int size;
+  const MazeAllocator* alloc;
+} RadixHeap;
+
+// Create radix heap (capacity = initial size of the first bucket)
+RadixHeap* create_radix_heap(int capacity, const MazeAllocator* alloc);
+
+// Insert with key (key >= last popped key)
+bool rh_push(RadixHeap* rh, int index, unsigned int key);
+
+// Remove and return an element with minimum key; false when empty, or
+// when moving nodes down runs out of memory (the heap is left unchanged)
+bool rh_pop(RadixHeap* rh, int* index, unsigned int* key);
+
+// Check if empty
+bool rh_is_empty(const RadixHeap* rh);
+
+// Free memory
+void free_radix_heap(RadixHeap* rh);
+
+#endif
@@ -6,8 +6,13 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
 
+// Public types (Maze, SolverOptions, SolverStats, MazeStatus)
+#include "libmaze.h"
+#include "alloc.h"
+
 // ======== STRUCTS ===========
 
 // Positions
@@ -16,20 +21,44 @@ typedef struct {
   int y;
 }  Position;
 
-// Maze
+// Cheap grid features sampled for --auto
 typedef struct {
-  char *grid; // (* = free, X = wall, O = path)
+  double wall_density;     // walls / sampled cells
+  double corridor_length;  // mean open run, the longer of rows and columns
+  double junction_ratio;   // open cells with 3+ open neighbors / open cells
+  int rows_sampled;
+} MazeFeatures;
+
+// How a solution is written
+typedef enum {
+  PATH_GRID,    // the whole maze with the path marked 'o'
+  PATH_COORDS,  // "x y" per path cell
+  PATH_MOVES,   // one letter per move: U D L R (Q E Z C diagonals)
+  PATH_RLE,     // run-length moves, e.g. "3RD2R"
+  PATH_BINARY   // packed record, see path.c
+} PathFormat;
+
+// ALT landmark distance tables (see landmarks.h)
+typedef struct Landmarks Landmarks;
+
+// exits of multi-target search (see targets.h)
+typedef struct Targets Targets;
+
+// Maze (opaque to libmaze users)
+struct Maze {
+  char *grid; // (* = free, 1-9 = weighted terrain, E = exit, X = wall, o = path)
   int width;
   int height;
-} Maze;
-
-// Performance statistics
-typedef struct {
-  double time_ms;           // execution time in milliseconds
-  int cells_visited;        // number of cells explored
-  int path_length;          // length of solution path (0 if no solution)
-  const char* algorithm;    // "BFS" or "A*"
-} SolverStats;
+  bool weighted; // grid contains terrain digits
+  bool checked;  // loader saw only '*', '1'-'9', 'E' and 'X' (validate skips its scan)
+  uint64_t hash; // content hash of the grid and dimensions as loaded (see maze.c)
+  int *labels;   // connected component per cell, -1 = wall (NULL until labeled)
+  int *path;     // cells of the last solution, start to finish (NULL if none)
+  int path_length;
+  Landmarks *landmarks; // ALT distance tables (NULL until built)
+  Targets *targets;     // nearest-exit goal set (NULL = bottom-right corner)
+  MazeAllocator alloc; // everything owned by the maze comes from here
+};
 
 // ========= MACROS ===========
 
@@ -39,37 +68,180 @@ typedef struct {
 // check and verify maze positions
 #define IS_VALID_POS(x, y, w, h) ((x) >= 0 && (x) < (w) && (y) >= 0 && (y) <(h))
 
+// passable cell: free space, an exit or weighted terrain
+#define IS_PASSABLE(c) ((c) == '*' || ((c) >= '1' && (c) <= '9') || (c) == 'E')
+
+// cost of entering a passable cell ('*' and 'E' = 1, digits = their value)
+#define CELL_COST(c) ((c) >= '1' && (c) <= '9' ? (c) - '0' : 1)
+
+// mazes this small on both sides are searched with stack-only state:
+// bitboard rows (one 64-bit word each) and no allocation but the path
+#define SMALL_MAZE_MAX 64
+#define IS_SMALL_MAZE(maze) ((maze)->width <= SMALL_MAZE_MAX && (maze)->height <= SMALL_MAZE_MAX)
+
+// force inlining so each caller gets its own specialized copy of a kernel
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+// SolverOptions.mem_limit when none is given (--external, --fringe)
+#define DEFAULT_MEM_LIMIT ((size_t)256 << 20)
+
+// smallest --fringe budget (a table of 1024 sets); below it nearly every
+// cell is evicted before it is met again
+#define FRINGE_MIN_MEM ((size_t)64 << 10)
+
+// expansions between two looks at the cancel flag (power of two)
+#define CANCEL_POLL 1024
+
+// cancel flag of opts (NULL = search cannot be cancelled)
+#define CANCEL_FLAG(opts) ((opts) ? (opts)->cancel : NULL)
+
+// true every CANCEL_POLL calls once the flag is set; a relaxed load is
+// enough, the flag carries no data
+static inline bool poll_cancel(const atomic_bool* cancel, unsigned* polls) {
+  return cancel && (++*polls & (CANCEL_POLL - 1)) == 0
+      && atomic_load_explicit(cancel, memory_order_relaxed);
+}
+
 // ======== FUNCTIONS ==========
 
+// Run-length maze text, told apart from ASCII by its first line:
+//   MZR1 <width> <height>
+//   runs "[count]symbol" in row-major order: symbol '*', 'E', 'X', or
+//   '#' and a terrain digit ('#3' = one cell of cost 3); no count = 1
+// Whitespace between runs is ignored and runs may go past a row end, so
+// "MZR1 3 2\n4*X*" is the maze "***" over "*X*". The grid is decoded
+// into memory, so width and height have the ASCII limit (MAZE_MAX_SIZE):
+// the format makes big maps small on disk, not bigger than ASCII ones.
+// maze-rle converts both ways.
+#define RLE_MAGIC "MZR1"
+
+// parse maze from memory (ASCII rows or run-length text)
+MazeStatus parse_maze(const char* data, size_t size, const MazeAllocator* alloc, Maze** out);
+
+// check one file row: bad |= invalid character, weighted |= terrain digit
+void scan_maze_row(const char* row, int width, bool* bad, bool* weighted);
+
 // load maze from file
-Maze* load_maze(const char* filename);
+MazeStatus load_maze(const char* filename, const MazeAllocator* alloc, Maze** out);
 
 // free memory
 void free_maze(Maze* maze);
 
-// print maze
-void print_maze(const Maze* maze);
-
 // validate maze
-bool validate_maze(const Maze* maze);
+MazeStatus validate_maze(const Maze* maze);
+
+// ======= PATH FUNCTIONS ==========
+
+// replace maze->path with room for length cells (NULL if out of memory)
+int* path_reserve(Maze* maze, int length);
+
+// drop the stored path
+void path_clear(Maze* maze);
+
+// mark the stored path with 'o' in the grid
+void mark_path(Maze* maze);
+
+// write cells in a compact format (not PATH_GRID); moves and rle leave
+// out the first cell, coords and binary keep it
+MazeStatus write_path(FILE* out, PathFormat format, const int* cells, int length, int width,
+                      int height);
+
+// same for a path given as its start cell and a direction index per move,
+// for mazes whose cell indices need not fit an int (MAZE_ERR_SIZE if a
+// binary record cannot count the moves)
+MazeStatus write_moves(FILE* out, PathFormat format, int start_x, int start_y,
+                       const unsigned char* dirs, size_t moves, int width, int height);
 
 // ======= ALGO FUNCTIONS ==========
+// MAZE_OK = path found and stored in maze->path (grid untouched),
+// MAZE_NO_PATH, or an error
 
 // solve bfs
-bool solve_bfs(Maze* maze);
+MazeStatus solve_bfs(Maze* maze, const SolverOptions* opts);
 
 // solve bfs with stats
-bool solve_bfs_stats(Maze* maze, SolverStats* stats);
+MazeStatus solve_bfs_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats);
+
+// bfs from cell start to cell finish (stats may be NULL)
+MazeStatus solve_bfs_between(Maze* maze, const SolverOptions* opts, int start, int finish,
+                             SolverStats* stats);
+
+// multi-source bfs: distances of count queries, 64 searches per sweep
+// over the grid (-1 = no path, stats may be NULL)
+MazeStatus solve_bfs_batch(Maze* maze, const SolverOptions* opts, const MazeQuery* queries,
+                           int count, int* distances, SolverStats* stats);
 
 // solve astar
-bool solve_astar(Maze* maze);
+MazeStatus solve_astar(Maze* maze, const SolverOptions* opts);
 
 // solve astar with stats
-bool solve_astar_stats(Maze* maze, SolverStats* stats);
+MazeStatus solve_astar_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats);
+
+// solve dijkstra
+MazeStatus solve_dijkstra(Maze* maze, const SolverOptions* opts);
+
+// solve dijkstra with stats
+MazeStatus solve_dijkstra_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats);
+
+// solve jump point search (always 8-directional, uniform terrain only)
+MazeStatus solve_jps(Maze* maze, const SolverOptions* opts);
+
+// solve jump point search with stats
+MazeStatus solve_jps_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats);
+
+// anytime weighted A*: w from 5 down to 1 until opts->timeout_ms, the
+// best path is kept (MAZE_TIMEOUT if the deadline beat the first one)
+MazeStatus solve_anytime(Maze* maze, const SolverOptions* opts);
+
+// anytime weighted A* with stats (stats->bound = suboptimality bound)
+MazeStatus solve_anytime_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats);
+
+// optimal Fringe Search with a transposition table of about
+// opts->mem_limit bytes instead of per-cell arrays (cells dropped from
+// the full table are searched again); MAZE_ERR_ARG below FRINGE_MIN_MEM,
+// MAZE_ERR_NOMEM once re-expansion shows the table thrashing
+MazeStatus solve_fringe(Maze* maze, const SolverOptions* opts);
+
+// fringe search with stats
+MazeStatus solve_fringe_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats);
 
-// ======= UTILITY FUNCTIONS ==========
+// measure features on a strided sample of rows
+void sample_features(const Maze* maze, MazeFeatures* features);
+
+// solver picked by the rule table for these features and options
+MazeAlgorithm choose_algorithm(const Maze* maze, const SolverOptions* opts,
+                               const MazeFeatures* features);
+
+// race the solvers sharing an objective for this maze (bfs/A* on uniform
+// terrain, A*/JPS diagonally, A*/Dijkstra on weighted terrain) on
+// threads, the first answer cancels the others; stats may be NULL
+MazeStatus solve_race(Maze* maze, const SolverOptions* opts, SolverStats* stats);
+
+// out-of-core bfs straight from a maze file within opts->mem_limit bytes,
+// the solution is written to out in format (same path as solve_bfs).
+// Sides need only fit an int (MAZE_ERR_SIZE past that, not MAZE_MAX_SIZE);
+// ASCII rows only, run-length text gives MAZE_ERR_ARG; a blocked start or
+// finish gives MAZE_NO_PATH before the search, with cells_visited 0
+MazeStatus solve_bfs_external(const char* filename, const SolverOptions* opts, PathFormat format,
+                              FILE* out, SolverStats* stats);
+
+// ======= COMPONENT FUNCTIONS ==========
+
+// label connected components in parallel, cached in maze->labels
+MazeStatus label_components(Maze* maze);
+
+// cells a and b in the same component? (true while labels are unknown)
+bool same_component(const Maze* maze, int a, int b);
+
+// ======= CLI FUNCTIONS (output.c, not part of libmaze) ==========
+
+// print maze
+void print_maze(const Maze* maze);
 
 // print statistics
 void print_stats(const SolverStats* stats);
 
-#endif
\ No newline at end of file
+// print the features --auto measured and the solver it chose
+void print_features(const MazeFeatures* features, MazeAlgorithm algo);
+
+#endif
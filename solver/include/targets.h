@@ -0,0 +1,49 @@
+#ifndef TARGETS_H
+#define TARGETS_H
+
+#include "solver.h"
+#include <stdint.h>
+
+// Multi-target search: solvers stop at the nearest of several exits
+// instead of the bottom-right corner. The exits are binned into square
+// buckets that keep the bounding box of their exits, so the A* heuristic
+// only looks at the boxes around a cell instead of at every exit.
+
+// bounding box of the exits of one bucket (min_x > max_x when empty)
+typedef struct {
+  int min_x, min_y;
+  int max_x, max_y;
+} TargetBox;
+
+struct Targets {
+  int count;
+  int bucket_size;     // bucket side in cells
+  int buckets_x;
+  int buckets_y;
+  TargetBox* boxes;    // buckets_x * buckets_y, row-major
+  TargetBox* filled;   // the non-empty boxes, packed
+  int filled_count;
+  uint64_t* bits;      // one bit per grid cell: is an exit
+  int reached;         // exit the last solve ended at (-1 = none)
+};
+
+// exits = the count cells given plus, with grid_exits, every 'E' of the
+// grid (an empty set drops multi-target mode)
+MazeStatus set_targets(Maze* maze, const int* cells, int count, bool grid_exits);
+
+// leave multi-target mode
+void free_targets(Maze* maze);
+
+// is cell one of the exits?
+static inline bool is_target(const Targets* targets, int cell) {
+  return (targets->bits[cell >> 6] >> (cell & 63)) & 1;
+}
+
+// lower bound on the distance from (x, y) to the nearest exit, ignoring
+// walls: the distance to the nearest box, in steps or COST_STRAIGHT /
+// COST_DIAGONAL units when diagonal. Exact when every box holds one exit
+// and consistent either way (distances to a set change by at most one
+// step per move)
+int nearest_target(const Targets* targets, int x, int y, bool diagonal);
+
+#endif
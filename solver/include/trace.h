@@ -0,0 +1,94 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "solver.h"
+#include <stdint.h>
+
+// Search traces: the stats builds of the BFS and A*/Dijkstra kernels log
+// every expansion to opts->trace. Records go to a buffer that is written
+// out when full, so a traced search costs a few stores per expansion and
+// one write per TRACE_BUFFER bytes.
+//
+// File layout (integers little-endian, varints LEB128):
+//   "MZT1"
+//   per search:
+//     width, height (u32), kind (u8: TraceKind), flags (u8: TRACE_*)
+//     per expansion, in pop order:
+//       varint zigzag(cell - previous cell)   (previous starts at -1)
+//       varint g, varint f - g, varint frontier size after the pop
+//     varint 0 (a cell is never expanded twice in a row), then varint
+//     status (MazeStatus) and varint expansion count
+// g and f are the kernel's own: BFS level (f = g), A*/Dijkstra cost in
+// COST_STRAIGHT units when diagonal. The frontier of A*/Dijkstra counts
+// open-set entries, stale duplicates included.
+
+#define TRACE_MAGIC "MZT1"
+
+// buffered bytes before a write
+#define TRACE_BUFFER (64 << 10)
+
+// longest expansion record: four 5-byte varints
+#define TRACE_RECORD_MAX 20
+
+typedef enum { TRACE_BFS, TRACE_ASTAR, TRACE_DIJKSTRA } TraceKind;
+
+// search flags
+#define TRACE_DIAGONAL  1
+#define TRACE_MULTI     2  // nearest of several exits
+#define TRACE_LANDMARKS 4  // A* with the ALT bound
+
+struct MazeTrace {
+  FILE* file;
+  MazeAllocator alloc;
+  unsigned char* buf;  // TRACE_BUFFER bytes
+  size_t used;
+  int prev;            // cell of the last record
+  uint32_t steps;      // expansions of the current search
+  MazeStatus error;    // first failed write (MAZE_OK = none)
+};
+
+// open filename and write the magic (alloc NULL = default allocator)
+MazeStatus trace_open(const char* filename, const MazeAllocator* alloc, MazeTrace** out);
+
+// flush, close and free; MAZE_ERR_IO if any write failed
+MazeStatus trace_close(MazeTrace* trace);
+
+// write out the buffer
+void trace_flush(MazeTrace* trace);
+
+// start the block of one search
+void trace_begin(MazeTrace* trace, const Maze* maze, TraceKind kind, int flags);
+
+// close the block of the current search
+void trace_end(MazeTrace* trace, MazeStatus status);
+
+// append v as a LEB128 varint at p, returns the byte after it
+static inline unsigned char* trace_varint(unsigned char* p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (unsigned char)v;
+  return p;
+}
+
+// log one expansion
+static inline void trace_step(MazeTrace* trace, int cell, uint32_t g, uint32_t f,
+                              uint32_t frontier) {
+  int32_t delta = cell - trace->prev;
+  unsigned char* p;
+
+  if (trace->used > TRACE_BUFFER - TRACE_RECORD_MAX) {
+    trace_flush(trace);
+  }
+  p = trace->buf + trace->used;
+  p = trace_varint(p, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+  p = trace_varint(p, g);
+  p = trace_varint(p, f > g ? f - g : 0);
+  p = trace_varint(p, frontier);
+  trace->used = (size_t)(p - trace->buf);
+  trace->prev = cell;
+  trace->steps++;
+}
+
+#endif
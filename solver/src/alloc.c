@@ -0,0 +1,73 @@
+#include "alloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* default_alloc(void* ctx, size_t size) {
+  (void)ctx;
+  return malloc(size);
+}
+
+static void* default_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+  (void)ctx;
+  (void)old_size;
+  return realloc(ptr, new_size);
+}
+
+static void default_free(void* ctx, void* ptr, size_t size) {
+  (void)ctx;
+  (void)size;
+  free(ptr);
+}
+
+static const MazeAllocator default_allocator = {
+  default_alloc, default_realloc, default_free, NULL
+};
+
+const MazeAllocator* maze_default_allocator(void) {
+  return &default_allocator;
+}
+
+bool mem_is_default(const MazeAllocator* a) {
+  return !a || a->alloc == default_alloc;
+}
+
+void* mem_alloc(const MazeAllocator* a, size_t size) {
+  if (!a) {
+    a = &default_allocator;
+  }
+  return a->alloc(a->ctx, size);
+}
+
+void* mem_zalloc(const MazeAllocator* a, size_t size) {
+  void* ptr;
+
+  // calloc gets lazily zeroed pages from the kernel, keep that path
+  if (mem_is_default(a)) {
+    return calloc(1, size);
+  }
+
+  ptr = a->alloc(a->ctx, size);
+  if (ptr) {
+    memset(ptr, 0, size);
+  }
+  return ptr;
+}
+
+void* mem_realloc(const MazeAllocator* a, void* ptr, size_t old_size, size_t new_size) {
+  if (!a) {
+    a = &default_allocator;
+  }
+  if (!ptr) {
+    return a->alloc(a->ctx, new_size);
+  }
+  return a->realloc(a->ctx, ptr, old_size, new_size);
+}
+
+void mem_free(const MazeAllocator* a, void* ptr, size_t size) {
+  if (!a) {
+    a = &default_allocator;
+  }
+  if (ptr && a->free) {
+    a->free(a->ctx, ptr, size);
+  }
+}
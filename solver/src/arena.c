@@ -0,0 +1,135 @@
+#include "arena.h"
+#include "alloc.h"
+#include <string.h>
+#include <sys/mman.h>
+
+// smaller arenas come from malloc, a mapping is not worth a syscall
+#define ARENA_MAP_MIN (1 << 20)
+
+// transparent / explicit huge page size on x86-64 and arm64
+#define HUGE_PAGE (2 << 20)
+
+#define ROUND_UP(v, a) (((v) + (a) - 1) / (a) * (a))
+
+// explicit huge pages, fails cleanly when none are reserved
+static bool map_hugetlb(Arena* arena, size_t size) {
+#ifdef MAP_HUGETLB
+  size_t map_size = ROUND_UP(size, HUGE_PAGE);
+  void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  arena->map = map;
+  arena->map_size = map_size;
+  arena->base = map;
+  return true;
+#else
+  (void)arena;
+  (void)size;
+  return false;
+#endif
+}
+
+// regular pages; for transparent huge pages the region is 2 MB aligned
+// so every whole 2 MB range can be promoted
+static bool map_pages(Arena* arena, size_t size, bool huge_pages) {
+  size_t map_size = huge_pages ? ROUND_UP(size, HUGE_PAGE) + HUGE_PAGE : size;
+  char* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  arena->map = map;
+  arena->map_size = map_size;
+  arena->base = map;
+#ifdef MADV_HUGEPAGE
+  if (huge_pages) {
+    arena->base = (char*)ROUND_UP((size_t)map, HUGE_PAGE);
+    madvise(arena->base, ROUND_UP(size, HUGE_PAGE), MADV_HUGEPAGE);
+  }
+#endif
+  return true;
+}
+
+bool arena_init(Arena* arena, size_t size, const MazeAllocator* alloc, bool huge_pages) {
+  arena->size = size;
+  arena->used = 0;
+  arena->map = NULL;
+  arena->map_size = 0;
+  arena->alloc = alloc;
+
+  // fresh anonymous mappings read as zero
+  if (mem_is_default(alloc) && size >= ARENA_MAP_MIN &&
+      ((huge_pages && map_hugetlb(arena, size)) || map_pages(arena, size, huge_pages))) {
+    arena->zeroed = true;
+    return true;
+  }
+
+  // one block, sub-arrays are aligned within it
+  arena->zeroed = false;
+  arena->base = mem_alloc(alloc, size + ARENA_ALIGN);
+  return arena->base != NULL;
+}
+
+void* arena_push(Arena* arena, size_t size) {
+  size_t offset = ROUND_UP((size_t)arena->base + arena->used, ARENA_ALIGN) - (size_t)arena->base;
+  size_t limit = arena->map ? arena->size : arena->size + ARENA_ALIGN;
+
+  if (offset + size > limit) {
+    return NULL;
+  }
+  arena->used = offset + size;
+  return arena->base + offset;
+}
+
+void* arena_push_zero(Arena* arena, size_t size) {
+  void* ptr = arena_push(arena, size);
+
+  if (ptr && !arena->zeroed) {
+    memset(ptr, 0, size);
+  }
+  return ptr;
+}
+
+static void* arena_alloc_fn(void* ctx, size_t size) {
+  return arena_push(ctx, size);
+}
+
+static void* arena_realloc_fn(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+  Arena* arena = ctx;
+  void* grown;
+
+  // the last sub-array grows in place
+  if ((char*)ptr + old_size == arena->base + arena->used &&
+      (size_t)((char*)ptr - arena->base) + new_size <= arena->size) {
+    arena->used += new_size - old_size;
+    return ptr;
+  }
+
+  grown = arena_push(arena, new_size);
+  if (grown) {
+    memcpy(grown, ptr, old_size < new_size ? old_size : new_size);
+  }
+  return grown;
+}
+
+MazeAllocator arena_allocator(Arena* arena) {
+  MazeAllocator alloc = { arena_alloc_fn, arena_realloc_fn, NULL, arena };
+
+  return alloc;
+}
+
+void arena_release(Arena* arena) {
+  if (arena->map) {
+    munmap(arena->map, arena->map_size);
+  } else {
+    mem_free(arena->alloc, arena->base, arena->size + ARENA_ALIGN);
+  }
+  arena->base = NULL;
+  arena->map = NULL;
+  arena->size = 0;
+  arena->used = 0;
+}
@@ -0,0 +1,139 @@
+#include "solver.h"
+
+// Automatic solver choice: a strided pass over a few rows measures how
+// the maze looks, and the first matching rule of a table tuned on the
+// benchmark families picks the solver.
+
+// rows sampled at most
+#define SAMPLE_LINES 64
+
+// movement/terrain a rule applies to
+typedef enum {
+  RULE_ORTHOGONAL,  // uniform terrain, 4 directions
+  RULE_DIAGONAL,    // uniform terrain, 8 directions
+  RULE_WEIGHTED     // terrain digits, either movement
+} RuleMode;
+
+// a rule matches when every feature is inside its range
+typedef struct {
+  RuleMode mode;
+  double min_density, max_density;
+  double min_junctions;
+  double max_corridor;
+  MazeAlgorithm algo;
+} AutoRule;
+
+// Best solver per family, min of 3 runs (ms, 2000x2000 unless noted):
+//
+//                     bfs   A*  dijk  A*diag   jps
+//   open floor         98    7   113       7    22
+//   random 10% walls  112   14   155      67   120
+//   random 25% walls  149   17   175     175   190
+//   random 30% (4000) 748  815   857    1761  1566
+//   rooms and doors    94    8   109      21     6
+//   serpentine        135  133   132     199    20
+//   perfect maze       53   47    57      75    42
+//   braided 10%       124   87   129     174   120
+//   weighted, random  169* 260   256     508     -
+//
+// 4-directional A* loses by at most ~10% (dense random noise) but BFS
+// loses up to 10x when the heuristic helps, so A* always runs there.
+// Weighted terrain: A* and Dijkstra tie (*bfs ignores the weights).
+// Diagonally JPS wins on any structure (rooms, corridors, mazes) and
+// A* on open floor and sparse random noise, where jumps stop constantly.
+static const AutoRule rules[] = {
+  { RULE_WEIGHTED,   0.00, 1.00, 0.00, 1e9, MAZE_ALGO_ASTAR },
+  { RULE_ORTHOGONAL, 0.00, 1.00, 0.00, 1e9, MAZE_ALGO_ASTAR },
+  { RULE_DIAGONAL,   0.00, 0.01, 0.00, 1e9, MAZE_ALGO_ASTAR },
+  { RULE_DIAGONAL,   0.01, 0.27, 0.70, 16,  MAZE_ALGO_ASTAR },
+  { RULE_DIAGONAL,   0.00, 1.00, 0.00, 1e9, MAZE_ALGO_JPS },
+};
+
+// odd stride so both parities of a carved maze's lattice are seen
+static int sample_stride(int length) {
+  int stride = length / SAMPLE_LINES;
+  return stride > 1 ? stride | 1 : 1;
+}
+
+void sample_features(const Maze* maze, MazeFeatures* features) {
+  const char* grid = maze->grid;
+  int width = maze->width;
+  int height = maze->height;
+  int stride = sample_stride(height);
+  long cells = 0, walls = 0, open = 0, junctions = 0, runs = 0, continued = 0;
+  double row_corridor, col_corridor;
+  bool in_run, up, down;
+  int x, y, n;
+
+  features->rows_sampled = 0;
+
+  // each sampled row is read with its neighbors above and below, all
+  // sequentially (walking columns would miss the cache on every cell)
+  for (y = 0; y < height; y += stride) {
+    in_run = false;
+    for (x = 0; x < width; x++) {
+      cells++;
+      if (!IS_PASSABLE(grid[IDX(x, y, width)])) {
+        walls++;
+        in_run = false;
+        continue;
+      }
+      open++;
+      if (!in_run) {
+        runs++;
+        in_run = true;
+      }
+      up = y > 0 && IS_PASSABLE(grid[IDX(x, y - 1, width)]);
+      down = y < height - 1 && IS_PASSABLE(grid[IDX(x, y + 1, width)]);
+      n = (x > 0 && IS_PASSABLE(grid[IDX(x - 1, y, width)]))
+        + (x < width - 1 && IS_PASSABLE(grid[IDX(x + 1, y, width)]))
+        + up + down;
+      if (n >= 3) {
+        junctions++;
+      }
+      if (down) {
+        continued++;
+      }
+    }
+    features->rows_sampled++;
+  }
+
+  // rows give horizontal runs directly; vertical runs are estimated
+  // from how often an open cell continues downwards (mean 1 / (1 - p))
+  row_corridor = runs ? (double)open / runs : 0.0;
+  col_corridor = open > continued ? (double)open / (open - continued) : height;
+  if (col_corridor > height) {
+    col_corridor = height;
+  }
+
+  features->wall_density = cells ? (double)walls / cells : 0.0;
+  features->corridor_length = row_corridor > col_corridor ? row_corridor : col_corridor;
+  features->junction_ratio = open ? (double)junctions / open : 0.0;
+}
+
+MazeAlgorithm choose_algorithm(const Maze* maze, const SolverOptions* opts,
+                               const MazeFeatures* features) {
+  RuleMode mode;
+  const AutoRule* rule;
+  size_t i;
+
+  if (maze->weighted) {
+    mode = RULE_WEIGHTED;
+  } else if (opts && opts->diagonal) {
+    mode = RULE_DIAGONAL;
+  } else {
+    mode = RULE_ORTHOGONAL;
+  }
+
+  for (i = 0; i < sizeof(rules) / sizeof(rules[0]); i++) {
+    rule = &rules[i];
+    if (rule->mode == mode
+        && features->wall_density >= rule->min_density
+        && features->wall_density <= rule->max_density
+        && features->junction_ratio >= rule->min_junctions
+        && features->corridor_length <= rule->max_corridor) {
+      return rule->algo;
+    }
+  }
+  return MAZE_ALGO_ASTAR;
+}
@@ -0,0 +1,333 @@
+#include "cache.h"
+#include "movement.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Result cache: an open-addressing table in memory in front of an
+// optional directory of entry files (layout in cache.h). Lookups try the
+// table first, then the file; a file hit is copied into the table so a
+// repeat within the run stays in memory.
+
+// first table capacity (grows at half load)
+#define CACHE_SLOTS 64
+
+// room past "DIR" for "/" + 16 hex digits + "_WxH_aN_fN_lN.mzc"
+#define CACHE_NAME_MAX 96
+
+static bool same_key(const CacheKey* a, const CacheKey* b) {
+  return a->hash == b->hash && a->width == b->width && a->height == b->height
+      && a->algo == b->algo && a->flags == b->flags && a->landmarks == b->landmarks;
+}
+
+static size_t slot_of(const CacheKey* key, int capacity) {
+  uint64_t h = key->hash
+             ^ ((uint64_t)key->landmarks << 16 | (uint64_t)key->algo << 8 | (uint64_t)key->flags)
+               * 0x9E3779B97F4A7C15ULL;
+
+  return (size_t)(h ^ h >> 32) & (size_t)(capacity - 1);
+}
+
+// terrain cost of the stored path, counted like the solvers do
+static double path_cost(const Maze* maze, bool diagonal) {
+  long units = 0;
+  int i, cell, prev;
+  bool diagonal_step;
+
+  for (i = 1; i < maze->path_length; i++) {
+    cell = maze->path[i];
+    prev = maze->path[i - 1];
+    diagonal_step = cell % maze->width != prev % maze->width
+                 && cell / maze->width != prev / maze->width;
+    units += (long)CELL_COST(maze->grid[cell])
+           * (diagonal ? (diagonal_step ? COST_DIAGONAL : COST_STRAIGHT) : 1);
+  }
+  return (double)units / (diagonal ? COST_STRAIGHT : 1);
+}
+
+// ======= MEMORY ======
+
+static CacheEntry* table_find(const ResultCache* cache, const CacheKey* key) {
+  size_t mask, i;
+
+  if (!cache->table) {
+    return NULL;
+  }
+  mask = (size_t)cache->capacity - 1;
+  for (i = slot_of(key, cache->capacity); cache->table[i].used; i = (i + 1) & mask) {
+    if (same_key(&cache->table[i].key, key)) {
+      return &cache->table[i];
+    }
+  }
+  return NULL;
+}
+
+static bool table_grow(ResultCache* cache) {
+  int capacity = cache->capacity ? cache->capacity * 2 : CACHE_SLOTS;
+  size_t bytes = (size_t)capacity * sizeof(CacheEntry);
+  CacheEntry* old = cache->table;
+  CacheEntry* table;
+  size_t mask = (size_t)capacity - 1;
+  size_t j;
+  int i;
+
+  if (cache->mem_used + bytes > cache->mem_limit) {
+    return false;
+  }
+  table = calloc((size_t)capacity, sizeof(CacheEntry));
+  if (!table) {
+    return false;
+  }
+  for (i = 0; i < cache->capacity; i++) {
+    if (old[i].used) {
+      for (j = slot_of(&old[i].key, capacity); table[j].used; j = (j + 1) & mask) {
+      }
+      table[j] = old[i];
+    }
+  }
+  cache->mem_used += bytes - (size_t)cache->capacity * sizeof(CacheEntry);
+  cache->table = table;
+  cache->capacity = capacity;
+  free(old);
+  return true;
+}
+
+// copy an entry into the table; silently skipped once the budget is spent
+static void table_insert(ResultCache* cache, const CacheKey* key, MazeStatus status,
+                         const int* cells, int length, double cost) {
+  size_t bytes = (size_t)length * sizeof(int);
+  CacheEntry* entry;
+  size_t mask, i;
+
+  if (!cache->mem_limit || table_find(cache, key)) {
+    return;
+  }
+  if ((cache->count + 1) * 2 > cache->capacity && !table_grow(cache)) {
+    return;
+  }
+  if (cache->mem_used + bytes > cache->mem_limit) {
+    return;
+  }
+  mask = (size_t)cache->capacity - 1;
+  for (i = slot_of(key, cache->capacity); cache->table[i].used; i = (i + 1) & mask) {
+  }
+  entry = &cache->table[i];
+  entry->cells = NULL;
+  if (length && !(entry->cells = malloc(bytes))) {
+    return;
+  }
+  if (length) {
+    memcpy(entry->cells, cells, bytes);
+  }
+  entry->key = *key;
+  entry->status = status;
+  entry->length = length;
+  entry->cost = cost;
+  entry->used = true;
+  cache->mem_used += bytes;
+  cache->count++;
+}
+
+// ======= FILES ======
+
+static void entry_name(char* name, const ResultCache* cache, const CacheKey* key) {
+  snprintf(name, PATH_MAX, "%s/%016" PRIx64 "_%dx%d_a%d_f%d_l%d.mzc", cache->dir, key->hash,
+           key->width, key->height, key->algo, key->flags, key->landmarks);
+}
+
+// map the entry file of key; false when missing or not a valid entry
+static bool file_lookup(ResultCache* cache, const CacheKey* key, Maze* maze, MazeStatus* status,
+                        double* cost) {
+  char name[PATH_MAX];
+  const CacheFileHeader* header;
+  const uint32_t* cells;
+  struct stat st;
+  size_t cell_count = (size_t)key->width * key->height;
+  void* data;
+  int* path;
+  bool ok;
+  uint32_t i;
+  int fd;
+
+  entry_name(name, cache, key);
+  fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CacheFileHeader)) {
+    close(fd);
+    return false;
+  }
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  header = data;
+  cells = (const uint32_t*)(header + 1);
+  ok = memcmp(header->magic, CACHE_MAGIC, 4) == 0 && header->hash == key->hash
+    && header->width == (uint32_t)key->width && header->height == (uint32_t)key->height
+    && header->algo == (uint32_t)key->algo && header->flags == (uint32_t)key->flags
+    && header->landmarks == (uint32_t)key->landmarks
+    && (size_t)st.st_size == sizeof(CacheFileHeader) + (size_t)header->length * sizeof(uint32_t)
+    && (header->status == MAZE_OK ? header->length > 0
+                                  : header->status == MAZE_NO_PATH && header->length == 0);
+  for (i = 0; ok && i < header->length; i++) {
+    ok = cells[i] < cell_count;
+  }
+
+  if (ok && header->status == MAZE_OK) {
+    path = path_reserve(maze, (int)header->length);
+    if (path) {
+      for (i = 0; i < header->length; i++) {
+        path[i] = (int)cells[i];
+      }
+    }
+    ok = path != NULL;
+  }
+  if (ok) {
+    *status = (MazeStatus)header->status;
+    *cost = header->cost;
+  }
+  munmap(data, (size_t)st.st_size);
+  return ok;
+}
+
+// write the entry file of key under a temporary name, then rename it
+static MazeStatus file_store(const ResultCache* cache, const CacheKey* key, const Maze* maze,
+                             MazeStatus status, double cost) {
+  char name[PATH_MAX];
+  char temp[PATH_MAX + 32];
+  CacheFileHeader header;
+  uint32_t cell;
+  FILE* fp;
+  bool ok;
+  int i;
+
+  entry_name(name, cache, key);
+  snprintf(temp, sizeof(temp), "%s.%ld.tmp", name, (long)getpid());
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHE_MAGIC, 4);
+  header.status = (uint32_t)status;
+  header.hash = key->hash;
+  header.width = (uint32_t)key->width;
+  header.height = (uint32_t)key->height;
+  header.algo = (uint32_t)key->algo;
+  header.flags = (uint32_t)key->flags;
+  header.landmarks = (uint32_t)key->landmarks;
+  header.length = status == MAZE_OK ? (uint32_t)maze->path_length : 0;
+  header.cost = cost;
+
+  fp = fopen(temp, "wb");
+  if (!fp) {
+    return MAZE_ERR_IO;
+  }
+  ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+  for (i = 0; ok && i < (int)header.length; i++) {
+    cell = (uint32_t)maze->path[i];
+    ok = fwrite(&cell, sizeof(cell), 1, fp) == 1;
+  }
+  ok &= fclose(fp) == 0;
+  if (!ok || rename(temp, name) != 0) {
+    unlink(temp);
+    return MAZE_ERR_IO;
+  }
+  return MAZE_OK;
+}
+
+// ======= MAIN FUNCTIONS ======
+
+MazeStatus cache_open(const char* dir, size_t mem_limit, ResultCache** out) {
+  ResultCache* cache;
+  struct stat st;
+
+  *out = NULL;
+  if (dir && strlen(dir) + CACHE_NAME_MAX > PATH_MAX) {
+    return MAZE_ERR_ARG;
+  }
+  if (dir && mkdir(dir, 0777) != 0
+      && (errno != EEXIST || stat(dir, &st) != 0 || !S_ISDIR(st.st_mode))) {
+    return MAZE_ERR_IO;
+  }
+  cache = calloc(1, sizeof(ResultCache));
+  if (!cache) {
+    return MAZE_ERR_NOMEM;
+  }
+  cache->dir = dir;
+  cache->mem_limit = mem_limit;
+  *out = cache;
+  return MAZE_OK;
+}
+
+void cache_close(ResultCache* cache) {
+  int i;
+
+  if (!cache) {
+    return;
+  }
+  for (i = 0; i < cache->capacity; i++) {
+    free(cache->table[i].cells);
+  }
+  free(cache->table);
+  free(cache);
+}
+
+CacheKey cache_key(const Maze* maze, MazeAlgorithm algo, const SolverOptions* opts, int landmarks) {
+  CacheKey key = {
+    .hash = maze->hash,
+    .width = maze->width,
+    .height = maze->height,
+    .algo = (int)algo,
+    .flags = (opts && opts->diagonal ? CACHE_DIAGONAL : 0) | (landmarks ? CACHE_ALT : 0),
+    .landmarks = landmarks
+  };
+
+  return key;
+}
+
+bool cache_lookup(ResultCache* cache, const CacheKey* key, Maze* maze, MazeStatus* status,
+                  double* cost) {
+  CacheEntry* entry = table_find(cache, key);
+  int* path;
+
+  path_clear(maze);
+  if (entry) {
+    if (entry->length) {
+      path = path_reserve(maze, entry->length);
+      if (!path) {
+        cache->misses++;
+        return false;
+      }
+      memcpy(path, entry->cells, (size_t)entry->length * sizeof(int));
+    }
+    *status = entry->status;
+    *cost = entry->cost;
+    cache->hits++;
+    return true;
+  }
+  if (cache->dir && file_lookup(cache, key, maze, status, cost)) {
+    table_insert(cache, key, *status, maze->path, maze->path_length, *cost);
+    cache->hits++;
+    return true;
+  }
+  cache->misses++;
+  return false;
+}
+
+MazeStatus cache_store(ResultCache* cache, const CacheKey* key, const Maze* maze,
+                       MazeStatus status) {
+  double cost;
+
+  if (status != MAZE_OK && status != MAZE_NO_PATH) {
+    return MAZE_OK;
+  }
+  cost = status == MAZE_OK ? path_cost(maze, key->flags & CACHE_DIAGONAL) : 0;
+  table_insert(cache, key, status, maze->path, status == MAZE_OK ? maze->path_length : 0, cost);
+  return cache->dir ? file_store(cache, key, maze, status, cost) : MAZE_OK;
+}
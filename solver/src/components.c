@@ -0,0 +1,180 @@
+#include "solver.h"
+#include "parallel.h"
+
+// Connected-component labeling with union-find over row stripes.
+//
+// Links always point to a smaller index, so every root is the first
+// cell (row-major) of its set and a forward pass flattens the forest.
+// 4-connectivity gives the same components as 8-directional movement:
+// a diagonal step needs both orthogonal cells open anyway.
+//
+// 1. each thread labels its stripe on its own (no shared writes)
+// 2. stripes are stitched along their top rows, sequentially; only
+//    local roots get relinked and those are resolved right away
+// 3. each thread resolves its stripe to final roots, reading nothing
+//    outside its own rows
+
+typedef struct {
+  Maze* maze;
+  int* labels;
+  int row_begin;
+  int row_end;
+} Stripe;
+
+// find root with path halving (keeps parent < child)
+static int find_root(int* labels, int i) {
+  while (labels[i] != i) {
+    labels[i] = labels[labels[i]];
+    i = labels[i];
+  }
+  return i;
+}
+
+// merge two sets, smaller index wins
+static void unite(int* labels, int a, int b) {
+  a = find_root(labels, a);
+  b = find_root(labels, b);
+  if (a < b) {
+    labels[b] = a;
+  } else if (b < a) {
+    labels[a] = b;
+  }
+}
+
+// phase 1: label one stripe and flatten it to local roots
+static void* label_stripe(void* arg) {
+  Stripe* s = arg;
+  int width = s->maze->width;
+  int begin = IDX(0, s->row_begin, width);
+  int end = IDX(0, s->row_end, width);
+  int i;
+
+  for (i = begin; i < end; i++) {
+    if (!IS_PASSABLE(s->maze->grid[i])) {
+      s->labels[i] = -1;
+      continue;
+    }
+    s->labels[i] = i;
+
+    if (i % width > 0 && s->labels[i - 1] >= 0) {
+      unite(s->labels, i, i - 1);
+    }
+    if (i - width >= begin && s->labels[i - width] >= 0) {
+      unite(s->labels, i, i - width);
+    }
+  }
+
+  for (i = begin; i < end; i++) {
+    if (s->labels[i] >= 0) {
+      s->labels[i] = s->labels[s->labels[i]];
+    }
+  }
+  return NULL;
+}
+
+// phase 3: resolve every cell through its local root
+// (labels already pointing above the stripe are final)
+static void* resolve_stripe(void* arg) {
+  Stripe* s = arg;
+  int width = s->maze->width;
+  int begin = IDX(0, s->row_begin, width);
+  int end = IDX(0, s->row_end, width);
+  int i;
+
+  for (i = begin; i < end; i++) {
+    if (s->labels[i] >= begin) {
+      s->labels[i] = s->labels[s->labels[i]];
+    }
+  }
+  return NULL;
+}
+
+static int compare_int(const void* a, const void* b) {
+  return *(const int*)a - *(const int*)b;
+}
+
+MazeStatus label_components(Maze* maze) {
+  Stripe stripes[PARALLEL_MAX_THREADS];
+  int* labels;
+  int* linked;
+  int n_linked = 0;
+  int n, t, x, i;
+  int a, b;
+  int width;
+  size_t linked_size;
+
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
+  }
+
+  // cached
+  if (maze->labels) {
+    return MAZE_OK;
+  }
+
+  width = maze->width;
+  labels = mem_alloc(&maze->alloc, (size_t)maze->width * maze->height * sizeof(int));
+  if (!labels) {
+    return MAZE_ERR_NOMEM;
+  }
+
+  n = parallel_threads(maze->height);
+
+  for (t = 0; t < n; t++) {
+    stripes[t].maze = maze;
+    stripes[t].labels = labels;
+    stripes[t].row_begin = (int)((long)maze->height * t / n);
+    stripes[t].row_end = (int)((long)maze->height * (t + 1) / n);
+  }
+
+  // every stitch relinks at most one root
+  linked_size = ((size_t)(n - 1) * width + 1) * sizeof(int);
+  linked = mem_alloc(&maze->alloc, linked_size);
+  if (!linked) {
+    mem_free(&maze->alloc, labels, (size_t)maze->width * maze->height * sizeof(int));
+    return MAZE_ERR_NOMEM;
+  }
+
+  run_parallel(stripes, sizeof(Stripe), n, label_stripe);
+
+  // phase 2: stitch each stripe to the one above, starting each find at
+  // the local root so that only roots are ever rewritten
+  for (t = 1; t < n; t++) {
+    for (x = 0; x < width; x++) {
+      i = IDX(x, stripes[t].row_begin, width);
+      if (labels[i] < 0 || labels[i - width] < 0) {
+        continue;
+      }
+      a = find_root(labels, labels[i]);
+      b = find_root(labels, labels[i - width]);
+      if (a != b) {
+        if (a < b) {
+          labels[b] = a;
+          linked[n_linked++] = b;
+        } else {
+          labels[a] = b;
+          linked[n_linked++] = a;
+        }
+      }
+    }
+  }
+
+  // resolve relinked roots in index order: parents come first
+  qsort(linked, n_linked, sizeof(int), compare_int);
+  for (i = 0; i < n_linked; i++) {
+    labels[linked[i]] = labels[labels[linked[i]]];
+  }
+  mem_free(&maze->alloc, linked, linked_size);
+
+  run_parallel(stripes, sizeof(Stripe), n, resolve_stripe);
+
+  maze->labels = labels;
+  return MAZE_OK;
+}
+
+bool same_component(const Maze* maze, int a, int b) {
+  if (!maze->labels) {
+    return true;  // unknown, let the search decide
+  }
+  return maze->labels[a] >= 0 && maze->labels[a] == maze->labels[b];
+}
@@ -0,0 +1,277 @@
+#include "landmarks.h"
+#include "movement.h"
+#include "radix_heap.h"
+#include "arena.h"
+
+// Landmark selection and distance tables for the ALT heuristic.
+//
+// Farthest-point selection: the first landmark is the reachable cell
+// farthest from start, each next one the cell farthest from all chosen
+// so far. Every pick needs the previous table, so the tables are built
+// one after the other (and double as the selection state).
+
+// magic of a saved table file (2: tied to the loader's content hash)
+#define LANDMARK_MAGIC "MZL2"
+
+// distances from source into out[cell * stride]: BFS steps, or
+// COST_STRAIGHT/COST_DIAGONAL units by Dijkstra when diagonal
+static MazeStatus landmark_search(const Maze* maze, bool diagonal, int source, uint32_t* out,
+                                  int stride, int* queue) {
+  size_t cells = (size_t)maze->width * maze->height;
+  RadixHeap* heap;
+  int head = 0, tail = 0;
+  int current, next, x, y, d;
+  unsigned int key;
+  uint32_t cost;
+  MazeStatus status;
+  size_t i;
+
+  for (i = 0; i < cells; i++) {
+    out[i * stride] = LANDMARK_INF;
+  }
+  out[(size_t)source * stride] = 0;
+
+  if (!diagonal) {
+    // plain BFS, every cell enters the queue once
+    queue[tail++] = source;
+    while (head < tail) {
+      current = queue[head++];
+      x = current % maze->width;
+      y = current / maze->width;
+      for (d = 0; d < DIRS_ORTHOGONAL; d++) {
+        if (!is_open(maze, x + dir_dx[d], y + dir_dy[d])) {
+          continue;
+        }
+        next = IDX(x + dir_dx[d], y + dir_dy[d], maze->width);
+        if (out[(size_t)next * stride] == LANDMARK_INF) {
+          out[(size_t)next * stride] = out[(size_t)current * stride] + 1;
+          queue[tail++] = next;
+        }
+      }
+    }
+    return MAZE_OK;
+  }
+
+  heap = create_radix_heap(maze->width + maze->height, &maze->alloc);
+  if (!heap) {
+    return MAZE_ERR_NOMEM;
+  }
+  if (!rh_push(heap, source, 0)) {
+    free_radix_heap(heap);
+    return MAZE_ERR_NOMEM;
+  }
+
+  while (rh_pop(heap, &current, &key)) {
+    if (key != out[(size_t)current * stride]) {
+      continue;  // stale entry
+    }
+    x = current % maze->width;
+    y = current / maze->width;
+    for (d = 0; d < DIRS_DIAGONAL; d++) {
+      if (!can_move(maze, x, y, d)) {
+        continue;
+      }
+      next = IDX(x + dir_dx[d], y + dir_dy[d], maze->width);
+      cost = key + (d < DIRS_ORTHOGONAL ? COST_STRAIGHT : COST_DIAGONAL);
+      if (cost < out[(size_t)next * stride]) {
+        out[(size_t)next * stride] = cost;
+        if (!rh_push(heap, next, cost)) {
+          free_radix_heap(heap);
+          return MAZE_ERR_NOMEM;
+        }
+      }
+    }
+  }
+
+  // a pop only fails on a non-empty heap when it runs out of memory
+  status = rh_is_empty(heap) ? MAZE_OK : MAZE_ERR_NOMEM;
+  free_radix_heap(heap);
+  return status;
+}
+
+// allocate an empty table set for count landmarks
+static Landmarks* landmarks_alloc(Maze* maze, bool diagonal, int count) {
+  size_t cells = (size_t)maze->width * maze->height;
+  Landmarks* lm = mem_alloc(&maze->alloc, sizeof(Landmarks));
+
+  if (!lm) {
+    return NULL;
+  }
+  lm->dist = mem_alloc(&maze->alloc, cells * count * sizeof(uint32_t));
+  if (!lm->dist) {
+    mem_free(&maze->alloc, lm, sizeof(Landmarks));
+    return NULL;
+  }
+  lm->count = count;
+  lm->diagonal = diagonal;
+  return lm;
+}
+
+MazeStatus build_landmarks(Maze* maze, bool diagonal, int count) {
+  size_t cells;
+  Landmarks* lm;
+  Arena arena;
+  uint32_t* nearest;  // distance to the closest pick so far (start at first)
+  int* queue;
+  uint32_t far, d;
+  size_t v;
+  int i;
+  MazeStatus status;
+
+  if (!maze || !maze->grid || maze->weighted || count < 1 || count > LANDMARKS_MAX) {
+    return MAZE_ERR_ARG;
+  }
+  cells = (size_t)maze->width * maze->height;
+
+  if (!arena_init(&arena, ARENA_SIZE(cells * (sizeof(uint32_t) + sizeof(int)), 2), &maze->alloc,
+                  false)) {
+    return MAZE_ERR_NOMEM;
+  }
+  nearest = arena_push(&arena, cells * sizeof(uint32_t));
+  queue = arena_push(&arena, cells * sizeof(int));
+
+  lm = landmarks_alloc(maze, diagonal, count);
+  if (!lm) {
+    arena_release(&arena);
+    return MAZE_ERR_NOMEM;
+  }
+
+  // only start's component matters: cells it cannot reach stay INF
+  status = landmark_search(maze, diagonal, 0, nearest, 1, queue);
+
+  for (i = 0; i < count && status == MAZE_OK; i++) {
+    // farthest reachable cell from every pick so far
+    lm->cells[i] = 0;
+    far = 0;
+    for (v = 0; v < cells; v++) {
+      if (nearest[v] != LANDMARK_INF && nearest[v] > far) {
+        far = nearest[v];
+        lm->cells[i] = (int)v;
+      }
+    }
+
+    status = landmark_search(maze, diagonal, lm->cells[i], lm->dist + i, count, queue);
+
+    for (v = 0; v < cells && status == MAZE_OK; v++) {
+      d = lm->dist[v * count + i];
+      if (d < nearest[v]) {
+        nearest[v] = d;
+      }
+    }
+  }
+  arena_release(&arena);
+
+  if (status != MAZE_OK) {
+    mem_free(&maze->alloc, lm->dist, cells * count * sizeof(uint32_t));
+    mem_free(&maze->alloc, lm, sizeof(Landmarks));
+    return status;
+  }
+
+  lm->grid_hash = maze->hash;
+  free_landmarks(maze);
+  maze->landmarks = lm;
+  return MAZE_OK;
+}
+
+// File layout (native byte order, it is a local cache):
+// "MZL2", width, height, count, diagonal (u32 each), Maze.hash (u64),
+// landmark cells (count u32), then the interleaved table.
+
+MazeStatus load_landmarks(Maze* maze, bool diagonal, int count, const char* filename) {
+  size_t cells;
+  Landmarks* lm;
+  FILE* fp;
+  char magic[4];
+  uint32_t header[4];
+  uint32_t landmark_cells[LANDMARKS_MAX];
+  uint64_t hash;
+  int i;
+
+  if (!maze || !maze->grid || maze->weighted || count < 1 || count > LANDMARKS_MAX || !filename) {
+    return MAZE_ERR_ARG;
+  }
+  cells = (size_t)maze->width * maze->height;
+
+  fp = fopen(filename, "rb");
+  if (!fp) {
+    return MAZE_ERR_IO;
+  }
+  if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, LANDMARK_MAGIC, 4) != 0
+      || fread(header, sizeof(uint32_t), 4, fp) != 4
+      || header[0] != (uint32_t)maze->width || header[1] != (uint32_t)maze->height
+      || header[2] != (uint32_t)count || header[3] != (uint32_t)diagonal
+      || fread(&hash, sizeof(hash), 1, fp) != 1 || hash != maze->hash
+      || fread(landmark_cells, sizeof(uint32_t), count, fp) != (size_t)count) {
+    fclose(fp);
+    return MAZE_ERR_IO;
+  }
+
+  lm = landmarks_alloc(maze, diagonal, count);
+  if (!lm) {
+    fclose(fp);
+    return MAZE_ERR_NOMEM;
+  }
+  if (fread(lm->dist, sizeof(uint32_t) * count, cells, fp) != cells) {
+    fclose(fp);
+    mem_free(&maze->alloc, lm->dist, cells * count * sizeof(uint32_t));
+    mem_free(&maze->alloc, lm, sizeof(Landmarks));
+    return MAZE_ERR_IO;
+  }
+  fclose(fp);
+
+  for (i = 0; i < count; i++) {
+    lm->cells[i] = (int)landmark_cells[i];
+  }
+  lm->grid_hash = hash;
+  free_landmarks(maze);
+  maze->landmarks = lm;
+  return MAZE_OK;
+}
+
+MazeStatus save_landmarks(const Maze* maze, const char* filename) {
+  const Landmarks* lm = maze ? maze->landmarks : NULL;
+  size_t cells;
+  FILE* fp;
+  uint32_t header[4];
+  uint32_t landmark_cells[LANDMARKS_MAX];
+  bool ok;
+  int i;
+
+  if (!lm || !filename) {
+    return MAZE_ERR_ARG;
+  }
+  cells = (size_t)maze->width * maze->height;
+  header[0] = (uint32_t)maze->width;
+  header[1] = (uint32_t)maze->height;
+  header[2] = (uint32_t)lm->count;
+  header[3] = (uint32_t)lm->diagonal;
+  for (i = 0; i < lm->count; i++) {
+    landmark_cells[i] = (uint32_t)lm->cells[i];
+  }
+
+  fp = fopen(filename, "wb");
+  if (!fp) {
+    return MAZE_ERR_IO;
+  }
+  ok = fwrite(LANDMARK_MAGIC, 1, 4, fp) == 4
+    && fwrite(header, sizeof(uint32_t), 4, fp) == 4
+    && fwrite(&lm->grid_hash, sizeof(lm->grid_hash), 1, fp) == 1
+    && fwrite(landmark_cells, sizeof(uint32_t), lm->count, fp) == (size_t)lm->count
+    && fwrite(lm->dist, sizeof(uint32_t) * lm->count, cells, fp) == cells;
+  if (fclose(fp) != 0) {
+    ok = false;
+  }
+  return ok ? MAZE_OK : MAZE_ERR_IO;
+}
+
+void free_landmarks(Maze* maze) {
+  Landmarks* lm = maze->landmarks;
+
+  if (!lm) {
+    return;
+  }
+  mem_free(&maze->alloc, lm->dist,
+           (size_t)maze->width * maze->height * lm->count * sizeof(uint32_t));
+  mem_free(&maze->alloc, lm, sizeof(Landmarks));
+  maze->landmarks = NULL;
+}
@@ -0,0 +1,173 @@
+#include "solver.h"
+#include "landmarks.h"
+#include "targets.h"
+#include "trace.h"
+
+// Public libmaze entry points: thin wrappers over the internal API,
+// which already reports status codes and allocates through the maze.
+
+MazeStatus maze_load_buffer(const char* data, size_t size, const MazeAllocator* alloc,
+                            Maze** out) {
+  return parse_maze(data, size, alloc, out);
+}
+
+MazeStatus maze_load_file(const char* filename, const MazeAllocator* alloc, Maze** out) {
+  return load_maze(filename, alloc, out);
+}
+
+MazeStatus maze_validate(const Maze* maze) {
+  return validate_maze(maze);
+}
+
+MazeStatus maze_precheck(Maze* maze) {
+  return label_components(maze);
+}
+
+MazeStatus maze_landmarks(Maze* maze, const SolverOptions* opts, int count,
+                          const char* cache_file) {
+  bool diagonal = opts && opts->diagonal;
+  MazeStatus status;
+
+  if (cache_file && load_landmarks(maze, diagonal, count, cache_file) == MAZE_OK) {
+    return MAZE_OK;
+  }
+  status = build_landmarks(maze, diagonal, count);
+  if (status == MAZE_OK && cache_file) {
+    status = save_landmarks(maze, cache_file);
+  }
+  return status;
+}
+
+MazeStatus maze_set_exits(Maze* maze, const int* cells, int count, bool grid_exits) {
+  return set_targets(maze, cells, count, grid_exits);
+}
+
+int maze_exit_reached(const Maze* maze) {
+  return maze && maze->targets ? maze->targets->reached : -1;
+}
+
+MazeStatus maze_solve(Maze* maze, MazeAlgorithm algo, const SolverOptions* opts,
+                      SolverStats* stats) {
+  MazeFeatures features;
+  MazeStatus status;
+
+  if (!maze) {
+    return MAZE_ERR_ARG;
+  }
+  path_clear(maze);
+
+  if (algo == MAZE_ALGO_AUTO && maze->grid) {
+    sample_features(maze, &features);
+    algo = choose_algorithm(maze, opts, &features);
+    // JPS has no multi-target mode; A* expands the same cells it would
+    if (maze->targets && algo == MAZE_ALGO_JPS) {
+      algo = MAZE_ALGO_ASTAR;
+    }
+  }
+  // nearest-exit search is built into the BFS and A* kernels only
+  if (maze->targets && algo != MAZE_ALGO_BFS && algo != MAZE_ALGO_ASTAR &&
+      algo != MAZE_ALGO_DIJKSTRA) {
+    return MAZE_ERR_ARG;
+  }
+
+  switch (algo) {
+    case MAZE_ALGO_BFS:
+      status = stats ? solve_bfs_stats(maze, opts, stats) : solve_bfs(maze, opts);
+      break;
+    case MAZE_ALGO_ASTAR:
+      status = stats ? solve_astar_stats(maze, opts, stats) : solve_astar(maze, opts);
+      break;
+    case MAZE_ALGO_DIJKSTRA:
+      status = stats ? solve_dijkstra_stats(maze, opts, stats) : solve_dijkstra(maze, opts);
+      break;
+    case MAZE_ALGO_JPS:
+      status = stats ? solve_jps_stats(maze, opts, stats) : solve_jps(maze, opts);
+      break;
+    case MAZE_ALGO_ANYTIME:
+      status = stats ? solve_anytime_stats(maze, opts, stats) : solve_anytime(maze, opts);
+      break;
+    case MAZE_ALGO_FRINGE:
+      status = stats ? solve_fringe_stats(maze, opts, stats) : solve_fringe(maze, opts);
+      break;
+    default:
+      return MAZE_ERR_ARG;
+  }
+  return status;
+}
+
+MazeStatus maze_trace_open(const char* filename, const MazeAllocator* alloc, MazeTrace** out) {
+  return trace_open(filename, alloc, out);
+}
+
+MazeStatus maze_trace_close(MazeTrace* trace) {
+  return trace_close(trace);
+}
+
+MazeStatus maze_solve_batch(Maze* maze, const SolverOptions* opts, const MazeQuery* queries,
+                            int count, int* distances, SolverStats* stats) {
+  return solve_bfs_batch(maze, opts, queries, count, distances, stats);
+}
+
+MazeStatus maze_solve_query(Maze* maze, const SolverOptions* opts, const MazeQuery* query,
+                            SolverStats* stats) {
+  int start, goal;
+
+  if (!maze || !maze->grid || !query
+      || !IS_VALID_POS(query->start_x, query->start_y, maze->width, maze->height)
+      || !IS_VALID_POS(query->goal_x, query->goal_y, maze->width, maze->height)) {
+    return MAZE_ERR_ARG;
+  }
+  path_clear(maze);
+
+  start = IDX(query->start_x, query->start_y, maze->width);
+  goal = IDX(query->goal_x, query->goal_y, maze->width);
+  if (!IS_PASSABLE(maze->grid[start]) || !IS_PASSABLE(maze->grid[goal])) {
+    return MAZE_NO_PATH;
+  }
+  return solve_bfs_between(maze, opts, start, goal, stats);
+}
+
+int maze_width(const Maze* maze) {
+  return maze ? maze->width : 0;
+}
+
+int maze_height(const Maze* maze) {
+  return maze ? maze->height : 0;
+}
+
+const char* maze_grid(const Maze* maze) {
+  return maze ? maze->grid : NULL;
+}
+
+uint64_t maze_content_hash(const Maze* maze) {
+  return maze ? maze->hash : 0;
+}
+
+const int* maze_path(const Maze* maze, int* length) {
+  if (length) {
+    *length = maze ? maze->path_length : 0;
+  }
+  return maze ? maze->path : NULL;
+}
+
+void maze_free(Maze* maze) {
+  free_maze(maze);
+}
+
+const char* maze_strerror(MazeStatus status) {
+  switch (status) {
+    case MAZE_OK:             return "success";
+    case MAZE_NO_PATH:        return "no solution found";
+    case MAZE_ERR_ARG:        return "invalid argument";
+    case MAZE_ERR_NOMEM:      return "out of memory";
+    case MAZE_ERR_IO:         return "cannot read maze file";
+    case MAZE_ERR_EMPTY:      return "empty file or invalid maze";
+    case MAZE_ERR_SHORT_LINE: return "line shorter than the first one";
+    case MAZE_ERR_SIZE:       return "dimensions out of range (must be 1-10000)";
+    case MAZE_ERR_CHAR:
+      return "invalid character (valid: '*' free, '1'-'9' terrain cost, 'E' exit, 'X' wall)";
+    case MAZE_CANCELLED:      return "search cancelled";
+    case MAZE_TIMEOUT:        return "deadline passed before a path was found";
+  }
+  return "unknown error";
+}
@@ -1,26 +1,478 @@
 #include "solver.h"
+#include "lpa.h"
+#include "landmarks.h"
+#include "targets.h"
+#include "pipeline.h"
+#include "cache.h"
+#include <limits.h>
+#include <sys/stat.h>
 
 typedef enum {
   ALGO_BFS,
-  ALGO_ASTAR
+  ALGO_ASTAR,
+  ALGO_DIJKSTRA,
+  ALGO_JPS,
+  ALGO_RACE,
+  ALGO_AUTO,
+  ALGO_ANYTIME,
+  ALGO_FRINGE
 } Algorithm;
 
 void print_usage(const char* program_name) {
   fprintf(stderr, "Usage: %s <maze_file> [OPTIONS]\n", program_name);
+  fprintf(stderr, "       %s <directory> [OPTIONS]  (one result line per maze, pipelined)\n",
+          program_name);
   fprintf(stderr, "Options:\n");
   fprintf(stderr, "  --bfs       Use BFS algorithm (default)\n");
   fprintf(stderr, "  --astar     Use A* algorithm\n");
+  fprintf(stderr, "  --dijkstra  Use Dijkstra algorithm (terrain costs, no heuristic)\n");
+  fprintf(stderr, "  --jps       Use Jump Point Search (implies --diag)\n");
+  fprintf(stderr, "  --auto      Pick the solver from a quick sample of the maze\n");
+  fprintf(stderr, "  --race      Run the matching solvers on threads, first answer wins\n");
+  fprintf(stderr, "  --fringe    Optimal Fringe Search in bounded memory (see --mem-limit)\n");
+  fprintf(stderr, "  --anytime   Weighted A* (w = 5 down to 1), keeps the best path so far\n");
+  fprintf(stderr, "  --timeout-ms=N  Deadline in ms for --anytime (implies it), best path wins\n");
+  fprintf(stderr, "  --alt[=FILE]  A* with ALT landmark bounds (tables cached in FILE when given)\n");
+  fprintf(stderr, "  --landmarks=K  Landmarks for --alt, 1-%d (default %d)\n", LANDMARKS_MAX,
+          LANDMARKS_DEFAULT);
+  fprintf(stderr, "  --diag      8-directional movement (no corner cutting)\n");
+  fprintf(stderr, "  --updates=FILE  Replan incrementally (LPA*) after each 'x y X|*' line of FILE (- = stdin)\n");
+  fprintf(stderr, "  --queries=FILE  BFS distances for 'sx sy gx gy' lines of FILE, 64 per sweep (- = stdin)\n");
+  fprintf(stderr, "  --exits[=FILE]  Stop at the nearest exit: 'E' cells plus 'x y' lines of FILE\n");
+  fprintf(stderr, "  --precheck  Label connected components first (instant unsolvable detection)\n");
+  fprintf(stderr, "  --external  Out-of-core BFS: stream the file in row bands, state on disk\n");
+  fprintf(stderr, "  --mem-limit=N[K|M|G]  Memory budget for --external/--fringe (unit M, default 256M,\n");
+  fprintf(stderr, "                        --fringe needs 64K; it fails when the table thrashes)\n");
+  fprintf(stderr, "  --huge-pages  Back solver state with huge pages (large, densely searched mazes)\n");
+  fprintf(stderr, "  --output=FORMAT  grid (default), coords, moves, rle or binary (path only)\n");
+  fprintf(stderr, "  --trace=FILE  Log every expansion of --bfs/--astar/--dijkstra to FILE (see maze-trace)\n");
+  fprintf(stderr, "  --cache=DIR  Keep results in DIR by maze content, repeats skip the search\n");
   fprintf(stderr, "  --stats     Show performance statistics\n");
   fprintf(stderr, "  --help      Show this help message\n");
 }
 
+// print the stored solution: the marked maze, or only the path
+static void print_solution(Maze* maze, PathFormat format) {
+  if (format == PATH_GRID) {
+    mark_path(maze);
+    print_maze(maze);
+  } else {
+    write_path(stdout, format, maze->path, maze->path_length, maze->width, maze->height);
+  }
+}
+
+// library name of a CLI solver (race has none)
+static MazeAlgorithm library_algorithm(Algorithm algo) {
+  return algo == ALGO_BFS        ? MAZE_ALGO_BFS
+       : algo == ALGO_DIJKSTRA   ? MAZE_ALGO_DIJKSTRA
+       : algo == ALGO_JPS        ? MAZE_ALGO_JPS
+       : algo == ALGO_AUTO       ? MAZE_ALGO_AUTO
+       : algo == ALGO_ANYTIME    ? MAZE_ALGO_ANYTIME
+       : algo == ALGO_FRINGE     ? MAZE_ALGO_FRINGE
+       : MAZE_ALGO_ASTAR;
+}
+
+// --cache: print the stored result of key like a solve would; false on
+// a miss
+static bool print_cached(ResultCache* cache, const CacheKey* key, Maze* maze, PathFormat format,
+                         bool show_stats) {
+  clock_t start_time = clock();
+  SolverStats stats = { .algorithm = "cache", .bound = 1.0 };
+  MazeStatus status;
+
+  if (!cache_lookup(cache, key, maze, &status, &stats.path_cost)) {
+    return false;
+  }
+  stats.path_length = maze->path_length;
+  stats.time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  if (status == MAZE_OK) {
+    print_solution(maze, format);
+  } else {
+    printf("no solution found\n");
+  }
+  if (show_stats) {
+    print_stats(&stats);
+  }
+  return true;
+}
+
+// --output= values
+static bool parse_format(const char* text, PathFormat* out) {
+  static const char* const names[] = {"grid", "coords", "moves", "rle", "binary"};
+  int i;
+
+  for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+    if (strcmp(text, names[i]) == 0) {
+      *out = (PathFormat)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// "path found (N cells, cost C)" or "no path" for the plan's current state
+static void print_plan(LpaPlanner* lpa, bool solved) {
+  double cost = 0;
+  int length = solved ? lpa_store_path(lpa, &cost) : 0;
+
+  if (length > 0) {
+    fprintf(stderr, "path found (%d cells, cost %g)\n", length, cost);
+  } else {
+    fprintf(stderr, "no path\n");
+  }
+}
+
+// incremental mode: plan once, then repair the plan after every edit
+static int run_incremental(Maze* maze, const SolverOptions* opts, const char* updates_file,
+                           PathFormat format, bool show_stats) {
+  LpaPlanner* lpa;
+  FILE* fp;
+  SolverStats stats;
+  clock_t start_time;
+  MazeStatus solved;
+  MazeStatus status;
+  int x, y;
+  char c;
+  int update = 0;
+
+  fp = strcmp(updates_file, "-") == 0 ? stdin : fopen(updates_file, "r");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]: cannot open updates file %s\n", updates_file);
+    return 1;
+  }
+
+  lpa = lpa_create(maze, opts);
+  if (!lpa) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(MAZE_ERR_NOMEM));
+    if (fp != stdin) {
+      fclose(fp);
+    }
+    return 1;
+  }
+
+  stats.algorithm = "LPA*";
+  stats.path_length = 0;
+  stats.path_cost = 0;
+  stats.bound = 1.0;
+  start_time = clock();
+
+  solved = lpa_compute(lpa);
+  stats.cells_visited = lpa->expanded;
+  if (show_stats && solved != MAZE_ERR_NOMEM) {
+    fprintf(stderr, "initial plan: expanded %d, ", lpa->expanded);
+    print_plan(lpa, solved == MAZE_OK);
+  }
+
+  while (solved != MAZE_ERR_NOMEM && fscanf(fp, "%d %d %c", &x, &y, &c) == 3) {
+    update++;
+    status = lpa_set_cell(lpa, x, y, c);
+    if (status == MAZE_ERR_NOMEM) {
+      solved = status;
+      break;
+    }
+    if (status != MAZE_OK) {
+      fprintf(stderr, "Error: update %d (%d, %d) -> '%c': %s\n", update, x, y, c,
+              maze_strerror(status));
+      continue;
+    }
+    solved = lpa_compute(lpa);
+    stats.cells_visited += lpa->expanded;
+    if (show_stats && solved != MAZE_ERR_NOMEM) {
+      fprintf(stderr, "update %d: (%d, %d) -> %c: expanded %d, ", update, x, y, c,
+              lpa->expanded);
+      print_plan(lpa, solved == MAZE_OK);
+    }
+  }
+  if (fp != stdin) {
+    fclose(fp);
+  }
+
+  // an incomplete plan has no answer to print, not even "no solution"
+  if (solved == MAZE_ERR_NOMEM) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(solved));
+    lpa_free(lpa);
+    return 1;
+  }
+
+  if (solved == MAZE_OK) {
+    stats.path_length = lpa_store_path(lpa, &stats.path_cost);
+    print_solution(maze, format);
+  } else {
+    printf("no solution found\n");
+  }
+
+  stats.time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  if (show_stats) {
+    print_stats(&stats);
+  }
+
+  lpa_free(lpa);
+  return 0;
+}
+
+// read 'sx sy gx gy' lines into a growing array, NULL on a bad line
+static MazeQuery* read_queries(FILE* fp, int* count) {
+  MazeQuery* queries = NULL;
+  MazeQuery* grown;
+  MazeQuery q;
+  int capacity = 0;
+  int n = 0;
+  int fields;
+
+  while ((fields = fscanf(fp, "%d %d %d %d", &q.start_x, &q.start_y, &q.goal_x, &q.goal_y)) == 4) {
+    if (n == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      grown = realloc(queries, (size_t)capacity * sizeof(MazeQuery));
+      if (!grown) {
+        free(queries);
+        return NULL;
+      }
+      queries = grown;
+    }
+    queries[n++] = q;
+  }
+  if (fields != EOF) {
+    fprintf(stderr, "[ERROR]: query %d: expected 'sx sy gx gy'\n", n + 1);
+    free(queries);
+    return NULL;
+  }
+  *count = n;
+  return queries ? queries : malloc(sizeof(MazeQuery));
+}
+
+// batch mode: every distance from one multi-source sweep per 64 starts,
+// then a bfs path per query when a path format is asked for
+static int run_queries(Maze* maze, const SolverOptions* opts, const char* queries_file,
+                       PathFormat format, bool show_stats) {
+  MazeQuery* queries;
+  int* distances;
+  FILE* fp;
+  SolverStats stats;
+  MazeStatus status;
+  int count = 0;
+  int i;
+
+  fp = strcmp(queries_file, "-") == 0 ? stdin : fopen(queries_file, "r");
+  if (!fp) {
+    fprintf(stderr, "[ERROR]: cannot open queries file %s\n", queries_file);
+    return 1;
+  }
+  queries = read_queries(fp, &count);
+  if (fp != stdin) {
+    fclose(fp);
+  }
+  if (!queries) {
+    return 1;
+  }
+
+  distances = malloc((size_t)(count ? count : 1) * sizeof(int));
+  status = distances ? solve_bfs_batch(maze, opts, queries, count, distances, &stats)
+                     : MAZE_ERR_NOMEM;
+  if (status != MAZE_OK) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(status));
+    free(distances);
+    free(queries);
+    return 1;
+  }
+
+  for (i = 0; i < count; i++) {
+    printf("%d %d -> %d %d: ", queries[i].start_x, queries[i].start_y, queries[i].goal_x,
+           queries[i].goal_y);
+    if (distances[i] < 0) {
+      printf("no path\n");
+      continue;
+    }
+    printf("%d\n", distances[i]);
+    if (format != PATH_GRID
+        && solve_bfs_between(maze, opts, IDX(queries[i].start_x, queries[i].start_y, maze->width),
+                             IDX(queries[i].goal_x, queries[i].goal_y, maze->width),
+                             NULL) == MAZE_OK) {
+      write_path(stdout, format, maze->path, maze->path_length, maze->width, maze->height);
+    }
+  }
+
+  if (show_stats) {
+    print_stats(&stats);
+  }
+  free(distances);
+  free(queries);
+  return 0;
+}
+
+// exits for --exits: 'x y' lines of exits_file (when given) plus every
+// 'E' of the grid; false after printing the error
+static bool prepare_exits(Maze* maze, const char* exits_file) {
+  int* cells = NULL;
+  int* grown;
+  FILE* fp;
+  MazeStatus status;
+  int capacity = 0;
+  int count = 0;
+  int fields = EOF;
+  int x, y;
+
+  if (exits_file) {
+    fp = strcmp(exits_file, "-") == 0 ? stdin : fopen(exits_file, "r");
+    if (!fp) {
+      fprintf(stderr, "[ERROR]: cannot open exits file %s\n", exits_file);
+      return false;
+    }
+    while ((fields = fscanf(fp, "%d %d", &x, &y)) == 2) {
+      if (x < 0 || x >= maze->width || y < 0 || y >= maze->height) {
+        break;
+      }
+      if (count == capacity) {
+        capacity = capacity ? capacity * 2 : 64;
+        grown = realloc(cells, (size_t)capacity * sizeof(int));
+        if (!grown) {
+          fields = 0;
+          break;
+        }
+        cells = grown;
+      }
+      cells[count++] = IDX(x, y, maze->width);
+    }
+    if (fp != stdin) {
+      fclose(fp);
+    }
+    if (fields != EOF) {
+      fprintf(stderr, "[ERROR]: exit %d: expected 'x y' inside the maze\n", count + 1);
+      free(cells);
+      return false;
+    }
+  }
+
+  status = set_targets(maze, cells, count, true);
+  free(cells);
+  if (status != MAZE_OK) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(status));
+    return false;
+  }
+  if (!maze->targets) {
+    fprintf(stderr, "Error: --exits: no exits ('E' cells or FILE lines)\n");
+    return false;
+  }
+  return true;
+}
+
+// parse a byte count: N with optional K, M or G suffix (plain N = megabytes)
+static bool parse_size(const char* text, size_t* out) {
+  char* end;
+  unsigned long long n = strtoull(text, &end, 10);
+
+  if (end == text || n == 0) {
+    return false;
+  }
+  if (*end == 'K' || *end == 'k') {
+    n <<= 10;
+  } else if (*end == 'G' || *end == 'g') {
+    n <<= 30;
+  } else if (*end == 'M' || *end == 'm' || *end == '\0') {
+    n <<= 20;
+  } else {
+    return false;
+  }
+  if (*end != '\0' && end[1] != '\0') {
+    return false;
+  }
+  *out = (size_t)n;
+  return true;
+}
+
+// ALT: load the tables cached for this grid, or build (and cache) them
+static MazeStatus prepare_landmarks(Maze* maze, const SolverOptions* opts, int count,
+                                    const char* cache_file, bool show_stats) {
+  clock_t start_time = clock();
+  MazeStatus status;
+
+  if (cache_file && load_landmarks(maze, opts->diagonal, count, cache_file) == MAZE_OK) {
+    if (show_stats) {
+      fprintf(stderr, "landmarks: %d loaded from %s in %.2f ms\n", count, cache_file,
+              ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0);
+    }
+    return MAZE_OK;
+  }
+
+  status = build_landmarks(maze, opts->diagonal, count);
+  if (status == MAZE_OK && cache_file) {
+    status = save_landmarks(maze, cache_file);
+  }
+  if (status == MAZE_OK && show_stats) {
+    fprintf(stderr, "landmarks: %d built in %.2f ms%s%s\n", count,
+            ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0,
+            cache_file ? ", saved to " : "", cache_file ? cache_file : "");
+  }
+  return status;
+}
+
+// external mode: the maze is never loaded, solver streams it from disk
+static int run_external(const char* maze_file, const SolverOptions* opts, PathFormat format,
+                        bool show_stats) {
+  SolverStats stats;
+  MazeStatus status;
+
+  status = solve_bfs_external(maze_file, opts, format, stdout, &stats);
+  if (status == MAZE_ERR_ARG) {
+    fprintf(stderr, "Error: --external reads ASCII mazes only (maze-rle decodes %s)\n", maze_file);
+    return 1;
+  }
+  // the in-memory 1-10000 range does not apply here, only int coordinates
+  if (status == MAZE_ERR_SIZE) {
+    fprintf(stderr, "Error: --external maze sides must be 1-%d\n", INT_MAX);
+    printf("no solution found\n");
+    return 0;
+  }
+  if (status == MAZE_ERR_CHAR) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(status));
+    printf("no solution found\n");
+    return 0;
+  }
+  if (status != MAZE_OK && status != MAZE_NO_PATH) {
+    fprintf(stderr, "[ERROR]: %s: %s\n", maze_file, maze_strerror(status));
+    return 1;
+  }
+
+  if (status == MAZE_NO_PATH) {
+    printf("no solution found\n");
+  }
+  // a blocked corner ends before the search, as validate_maze does for
+  // bfs: no stats block then, a search always counts the start cell
+  if (show_stats && stats.cells_visited > 0) {
+    print_stats(&stats);
+  }
+  return 0;
+}
+
 int main(int argc, char* argv[]) {
   Maze* maze;
-  bool solved;
+  MazeStatus solved;
   Algorithm algo = ALGO_BFS;
   bool show_stats = false;
+  bool precheck = false;
+  bool external = false;
+  PathFormat format = PATH_GRID;
   const char* maze_file = NULL;
+  const char* updates_file = NULL;
+  const char* queries_file = NULL;
+  bool exits = false;
+  const char* exits_file = NULL;
+  bool alt = false;
+  const char* alt_file = NULL;
+  const char* trace_file = NULL;
+  MazeStatus trace_status;
+  const char* cache_dir = NULL;
+  ResultCache* cache = NULL;
+  CacheKey key;
+  int landmarks = LANDMARKS_DEFAULT;
+  char* end;
+  long timeout;
+  MazeStatus status;
+  int exit_code;
   SolverStats stats;
+  MazeFeatures features;
+  MazeAlgorithm chosen;
+  struct stat st;
+  SolverOptions opts = { .diagonal = false, .huge_pages = false, .mem_limit = 0 };
   int i;
 
   // parse arguments
@@ -38,6 +490,67 @@ int main(int argc, char* argv[]) {
       algo = ALGO_BFS;
     } else if (strcmp(argv[i], "--astar") == 0) {
       algo = ALGO_ASTAR;
+    } else if (strcmp(argv[i], "--dijkstra") == 0) {
+      algo = ALGO_DIJKSTRA;
+    } else if (strcmp(argv[i], "--jps") == 0) {
+      algo = ALGO_JPS;
+      opts.diagonal = true;
+    } else if (strcmp(argv[i], "--auto") == 0) {
+      algo = ALGO_AUTO;
+    } else if (strcmp(argv[i], "--race") == 0) {
+      algo = ALGO_RACE;
+    } else if (strcmp(argv[i], "--fringe") == 0) {
+      algo = ALGO_FRINGE;
+    } else if (strcmp(argv[i], "--anytime") == 0) {
+      algo = ALGO_ANYTIME;
+    } else if (strncmp(argv[i], "--timeout-ms=", 13) == 0) {
+      timeout = strtol(argv[i] + 13, &end, 10);
+      if (end == argv[i] + 13 || *end || timeout < 1 || timeout > INT_MAX) {
+        fprintf(stderr, "Invalid timeout: %s\n", argv[i] + 13);
+        return 1;
+      }
+      opts.timeout_ms = (unsigned)timeout;
+      algo = ALGO_ANYTIME;
+    } else if (strcmp(argv[i], "--alt") == 0 || strncmp(argv[i], "--alt=", 6) == 0) {
+      algo = ALGO_ASTAR;
+      alt = true;
+      alt_file = argv[i][5] == '=' ? argv[i] + 6 : NULL;
+    } else if (strncmp(argv[i], "--landmarks=", 12) == 0) {
+      landmarks = (int)strtol(argv[i] + 12, &end, 10);
+      if (end == argv[i] + 12 || *end || landmarks < 1 || landmarks > LANDMARKS_MAX) {
+        fprintf(stderr, "Invalid landmark count: %s (1-%d)\n", argv[i] + 12, LANDMARKS_MAX);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--diag") == 0) {
+      opts.diagonal = true;
+    } else if (strcmp(argv[i], "--huge-pages") == 0) {
+      opts.huge_pages = true;
+    } else if (strcmp(argv[i], "--external") == 0) {
+      external = true;
+    } else if (strncmp(argv[i], "--mem-limit=", 12) == 0) {
+      if (!parse_size(argv[i] + 12, &opts.mem_limit)) {
+        fprintf(stderr, "Invalid memory limit: %s\n", argv[i] + 12);
+        return 1;
+      }
+    } else if (strncmp(argv[i], "--output=", 9) == 0) {
+      if (!parse_format(argv[i] + 9, &format)) {
+        fprintf(stderr, "Unknown output format: %s\n", argv[i] + 9);
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strncmp(argv[i], "--updates=", 10) == 0) {
+      updates_file = argv[i] + 10;
+    } else if (strncmp(argv[i], "--queries=", 10) == 0) {
+      queries_file = argv[i] + 10;
+    } else if (strcmp(argv[i], "--exits") == 0 || strncmp(argv[i], "--exits=", 8) == 0) {
+      exits = true;
+      exits_file = argv[i][7] == '=' ? argv[i] + 8 : NULL;
+    } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+      trace_file = argv[i] + 8;
+    } else if (strncmp(argv[i], "--cache=", 8) == 0) {
+      cache_dir = argv[i] + 8;
+    } else if (strcmp(argv[i], "--precheck") == 0) {
+      precheck = true;
     } else if (strcmp(argv[i], "--stats") == 0) {
       show_stats = true;
     } else if (strcmp(argv[i], "--help") == 0) {
@@ -50,52 +563,236 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  // a smaller fringe table evicts nearly every cell before it is met again
+  if (algo == ALGO_FRINGE && opts.mem_limit && opts.mem_limit < FRINGE_MIN_MEM) {
+    fprintf(stderr, "Error: --fringe needs --mem-limit=%zuK or more\n", FRINGE_MIN_MEM >> 10);
+    return 1;
+  }
+
+  // nearest-exit search is built into the BFS and A* kernels only
+  if (exits && (external || updates_file || queries_file || alt
+                || (algo != ALGO_BFS && algo != ALGO_ASTAR && algo != ALGO_DIJKSTRA
+                    && algo != ALGO_AUTO))) {
+    fprintf(stderr, "Error: --exits works with --bfs, --astar, --dijkstra and --auto only\n");
+    return 1;
+  }
+
+  // only the BFS and A*/Dijkstra kernels log their expansions
+  if (trace_file && (external || updates_file || queries_file || !*trace_file
+                     || (algo != ALGO_BFS && algo != ALGO_ASTAR && algo != ALGO_DIJKSTRA
+                         && algo != ALGO_AUTO))) {
+    fprintf(stderr, "Error: --trace=FILE works with --bfs, --astar, --dijkstra and --auto only\n");
+    return 1;
+  }
+
+  // query paths start anywhere: moves and rle would not say where
+  if (queries_file && (format == PATH_MOVES || format == PATH_RLE)) {
+    fprintf(stderr, "Error: --queries writes paths as grid, coords or binary only\n");
+    return 1;
+  }
+
+  // results are keyed by the maze and solver alone: no edits, extra
+  // goals or side outputs, and no deadline deciding the answer
+  if (cache_dir && (external || updates_file || queries_file || exits || trace_file
+                    || !*cache_dir || algo == ALGO_RACE || opts.timeout_ms)) {
+    fprintf(stderr, "Error: --cache=DIR works with plain solves by a single solver only\n");
+    return 1;
+  }
+
+  // directory: pipelined run over every maze in it
+  if (stat(maze_file, &st) == 0 && S_ISDIR(st.st_mode)) {
+    if (external || updates_file || queries_file || exits || alt || trace_file
+        || algo == ALGO_RACE) {
+      fprintf(stderr, "Error: directory runs take a single solver and plain solves only\n");
+      return 1;
+    }
+    return run_pipeline(maze_file, library_algorithm(algo), &opts, format, precheck, cache_dir,
+                        show_stats);
+  }
+
+  if (external) {
+    return run_external(maze_file, &opts, format, show_stats);
+  }
+
   // load maze from file
-  maze = load_maze(maze_file);
-  if (!maze) {
+  status = load_maze(maze_file, NULL, &maze);
+  // out-of-range dimensions are a maze without a solution, as validation says
+  if (status == MAZE_ERR_SIZE) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(status));
+    printf("no solution found\n");
+    return 0;
+  }
+  if (status != MAZE_OK) {
+    fprintf(stderr, "[ERROR]: %s: %s\n", maze_file, maze_strerror(status));
     return 1;
   }
 
-  // validate maze structure
-  if (!validate_maze(maze)) {
+  // exits replace the bottom-right corner as the goal
+  if (exits && !prepare_exits(maze, exits_file)) {
+    free_maze(maze);
+    return 1;
+  }
+
+  // validate maze structure (queries have their own start and goal cells,
+  // blocked corners do not matter to them)
+  status = validate_maze(maze);
+  if (status != MAZE_OK && !(status == MAZE_NO_PATH && queries_file)) {
+    if (status != MAZE_NO_PATH) {
+      fprintf(stderr, "Error: %s\n", maze_strerror(status));
+    }
     printf("no solution found\n");
     free_maze(maze);
     return 0;
   }
 
+  // a stored result answers without a search (or any preparation)
+  if (cache_dir) {
+    status = cache_open(cache_dir, 0, &cache);
+    if (status != MAZE_OK) {
+      fprintf(stderr, "Error: cache %s: %s\n", cache_dir,
+              status == MAZE_ERR_IO ? "cannot create directory" : maze_strerror(status));
+      free_maze(maze);
+      return 1;
+    }
+    key = cache_key(maze, library_algorithm(algo), &opts, alt && !maze->weighted ? landmarks : 0);
+    if (print_cached(cache, &key, maze, format, show_stats)) {
+      cache_close(cache);
+      free_maze(maze);
+      return 0;
+    }
+  }
+
+  // reachability pre-pass: solvers answer "no path" from the labels
+  if (precheck) {
+    status = label_components(maze);
+    if (status != MAZE_OK) {
+      fprintf(stderr, "Error: %s\n", maze_strerror(status));
+      cache_close(cache);
+      free_maze(maze);
+      return 1;
+    }
+  }
+
+  if (updates_file) {
+    exit_code = run_incremental(maze, &opts, updates_file, format, show_stats);
+    free_maze(maze);
+    return exit_code;
+  }
+
+  if (queries_file) {
+    exit_code = run_queries(maze, &opts, queries_file, format, show_stats);
+    free_maze(maze);
+    return exit_code;
+  }
+
+  // sample the grid and let the rule table pick
+  if (algo == ALGO_AUTO) {
+    sample_features(maze, &features);
+    chosen = choose_algorithm(maze, &opts, &features);
+    algo = chosen == MAZE_ALGO_BFS      ? ALGO_BFS
+         : chosen == MAZE_ALGO_DIJKSTRA ? ALGO_DIJKSTRA
+         : chosen == MAZE_ALGO_JPS && !exits && !trace_file ? ALGO_JPS
+         : ALGO_ASTAR;
+    if (show_stats) {
+      print_features(&features, chosen);
+    }
+  }
+
+  // landmark tables for A*; terrain costs break the symmetric distances
+  // the bound relies on, so weighted mazes keep the plain heuristic
+  if (alt && maze->weighted) {
+    fprintf(stderr, "Note: --alt needs uniform terrain, using plain A*\n");
+  } else if (alt) {
+    status = prepare_landmarks(maze, &opts, landmarks, alt_file, show_stats);
+    if (status != MAZE_OK) {
+      fprintf(stderr, "Error: landmarks: %s\n", maze_strerror(status));
+      cache_close(cache);
+      free_maze(maze);
+      return 1;
+    }
+  }
+
+  if (trace_file) {
+    status = maze_trace_open(trace_file, NULL, &opts.trace);
+    if (status != MAZE_OK) {
+      fprintf(stderr, "Error: trace %s: %s\n", trace_file,
+              status == MAZE_ERR_IO ? "cannot create file" : maze_strerror(status));
+      free_maze(maze);
+      return 1;
+    }
+  }
+
   // solve maze with selected algorithm
   if (show_stats) {
     // solve with statistics
     if (algo == ALGO_BFS) {
-      solved = solve_bfs_stats(maze, &stats);
+      solved = solve_bfs_stats(maze, &opts, &stats);
+    } else if (algo == ALGO_DIJKSTRA) {
+      solved = solve_dijkstra_stats(maze, &opts, &stats);
+    } else if (algo == ALGO_JPS) {
+      solved = solve_jps_stats(maze, &opts, &stats);
+    } else if (algo == ALGO_RACE) {
+      solved = solve_race(maze, &opts, &stats);
+    } else if (algo == ALGO_ANYTIME) {
+      solved = solve_anytime_stats(maze, &opts, &stats);
+    } else if (algo == ALGO_FRINGE) {
+      solved = solve_fringe_stats(maze, &opts, &stats);
     } else {
-      solved = solve_astar_stats(maze, &stats);
-    }
-
-    // print result
-    if (solved) {
-      print_maze(maze);
-      print_stats(&stats);
-    } else {
-      printf("no solution found\n");
-      print_stats(&stats);
+      solved = solve_astar_stats(maze, &opts, &stats);
     }
   } else {
     // solve without statistics
     if (algo == ALGO_BFS) {
-      solved = solve_bfs(maze);
+      solved = solve_bfs(maze, &opts);
+    } else if (algo == ALGO_DIJKSTRA) {
+      solved = solve_dijkstra(maze, &opts);
+    } else if (algo == ALGO_JPS) {
+      solved = solve_jps(maze, &opts);
+    } else if (algo == ALGO_RACE) {
+      solved = solve_race(maze, &opts, NULL);
+    } else if (algo == ALGO_ANYTIME) {
+      solved = solve_anytime(maze, &opts);
+    } else if (algo == ALGO_FRINGE) {
+      solved = solve_fringe(maze, &opts);
     } else {
-      solved = solve_astar(maze);
+      solved = solve_astar(maze, &opts);
     }
+  }
 
-    // print result
-    if (solved) {
-      print_maze(maze);
-    } else {
-      printf("no solution found\n");
-    }
+  // stored before printing, the grid is still unmarked
+  if (cache && cache_store(cache, &key, maze, solved) != MAZE_OK) {
+    fprintf(stderr, "Note: cache %s: result could not be written\n", cache_dir);
+  }
+  cache_close(cache);
+
+  // print result
+  if (solved == MAZE_OK) {
+    print_solution(maze, format);
+  } else if (solved == MAZE_NO_PATH) {
+    printf("no solution found\n");
+  }
+  if (show_stats && (solved == MAZE_OK || solved == MAZE_NO_PATH)) {
+    print_stats(&stats);
+  }
+
+  if (exits && solved == MAZE_OK) {
+    fprintf(stderr, "exit reached: %d %d\n", maze->targets->reached % maze->width,
+            maze->targets->reached / maze->width);
   }
 
   free_maze(maze);
+  trace_status = opts.trace ? maze_trace_close(opts.trace) : MAZE_OK;
+  if (solved == MAZE_ERR_NOMEM && algo == ALGO_FRINGE) {
+    fprintf(stderr, "Error: --fringe: the --mem-limit table thrashes on this maze, raise it\n");
+    return 1;
+  }
+  if (solved != MAZE_OK && solved != MAZE_NO_PATH) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(solved));
+    return 1;
+  }
+  if (trace_status != MAZE_OK) {
+    fprintf(stderr, "Error: trace %s: write failed\n", trace_file);
+    return 1;
+  }
   return 0;
 }
@@ -1,176 +1,514 @@
 #include "solver.h"
+#include "landmarks.h"
+#include "targets.h"
+#include "parallel.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // ======= HELPER FUNCTIONS ========
 
 // Get line length
-static int get_line_length(FILE *fp) {
-  int count = 0;
-  int c;
+static size_t get_line_length(const char* data, size_t size) {
+  const char* nl = memchr(data, '\n', size);
 
-  while ((c = fgetc(fp)) != EOF) {
-    if (c == '\n') {
-      break;
-    }
-    count++;
-  }
-  return count;
+  return nl ? (size_t)(nl - data) : size;
 }
 
 // Count numbers of lines
-static int count_lines(FILE *fp) {
-  int lines = 0;
-  int c;
-  int last_char = '\n';
+static size_t count_lines(const char* data, size_t size) {
+  size_t lines = 0;
+  size_t i;
 
-  while((c = fgetc(fp)) != EOF) {
-    if (c == '\n') {
+  for (i = 0; i < size; i++) {
+    if (data[i] == '\n') {
       lines++;
     }
-    last_char = c;
   }
 
-  if (last_char != '\n' && last_char != EOF) {
+  if (size > 0 && data[size - 1] != '\n') {
     lines++;
   }
 
   return lines;
 }
 
-// ========= MAIN FUNCTIONS =========
+// character classes ('*', '1'-'9', 'E' and 'X' are valid, all else is 0)
+#define CHAR_VALID 0x01
+#define CHAR_DIGIT 0x02
+
+static const unsigned char char_class[256] = {
+  ['*'] = CHAR_VALID,
+  ['E'] = CHAR_VALID,
+  ['X'] = CHAR_VALID,
+  ['1' ... '9'] = CHAR_VALID | CHAR_DIGIT
+};
+
+// scan one row (also used by the external solver): bad = a character
+// other than '*', '1'-'9', 'E' or 'X', weighted = terrain digits present
+// (branch-free over the row)
+void scan_maze_row(const char* row, int width, bool* bad, bool* weighted) {
+  unsigned char all = CHAR_VALID;
+  unsigned char any = 0;
+  unsigned char cls;
+  int x;
+
+  for (x = 0; x < width; x++) {
+    cls = char_class[(unsigned char)row[x]];
+    all &= cls;
+    any |= cls;
+  }
+  *bad |= !(all & CHAR_VALID);
+  *weighted |= (any & CHAR_DIGIT) != 0;
+}
 
-Maze *load_maze(const char *filename) {
-  FILE *fp;
-  Maze *maze;
-  int width, height;
-  int x, y;
-  int c;
-  
-  // open file
-  fp = fopen(filename, "r");
-  if (!fp) {
-    return NULL;
+// Content hash (Maze.hash): each row is hashed on its own, four 8-byte
+// lanes at a time, and the row hashes are summed. A sum does not care
+// in which order or on which thread the rows were done, so the parser
+// threads hash their chunks while copying them and any split of the
+// file gives the same hash. The row number seeds each row, so swapped
+// rows hash differently.
+
+#define HASH_P1 0x9E3779B185EBCA87ULL
+#define HASH_P2 0xC2B2AE3D27D4EB4FULL
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t word) {
+  acc += word * HASH_P2;
+  acc = (acc << 31) | (acc >> 33);
+  return acc * HASH_P1;
+}
+
+// murmur3 finalizer: every input bit reaches every output bit
+static inline uint64_t hash_mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t hash_row(const char* row, int width, int y) {
+  uint64_t lane[4] = { HASH_P1, HASH_P2, (uint64_t)y, ~(uint64_t)y };
+  uint64_t word, h;
+  int x = 0;
+  int k;
+
+  for (; x + 32 <= width; x += 32) {
+    for (k = 0; k < 4; k++) {
+      memcpy(&word, row + x + 8 * k, 8);
+      lane[k] = hash_round(lane[k], word);
+    }
+  }
+  h = lane[0] + ((lane[1] << 7) | (lane[1] >> 57)) + ((lane[2] << 12) | (lane[2] >> 52))
+    + ((lane[3] << 18) | (lane[3] >> 46));
+  for (; x + 8 <= width; x += 8) {
+    memcpy(&word, row + x, 8);
+    h = hash_round(h, word);
   }
+  for (; x < width; x++) {
+    h = hash_round(h, (unsigned char)row[x]);
+  }
+  return hash_mix(h ^ (uint64_t)y * HASH_P1);
+}
 
-  // detect width
-  width = get_line_length(fp);
+// final hash from the sum of the row hashes and the dimensions
+static uint64_t hash_finish(uint64_t rows, int width, int height) {
+  return hash_mix(hash_round(rows, (uint64_t)width << 32 | (uint32_t)height));
+}
 
-  if (width == 0) {
-    fprintf(stderr, "[ERROR]: Empty file or invalid maze...\n");
-    fclose(fp);
-    return NULL;
+// Rows of fixed length sit at known offsets, so the file splits into
+// row-aligned chunks that threads copy and check independently.
+
+// below this many bytes per thread, threads cost more than they save
+#define PARSE_CHUNK_MIN (1 << 20)
+
+typedef struct {
+  const char* data;   // first row of the chunk in the input
+  char* grid;         // first row of the chunk in the grid
+  size_t size;        // input bytes from data to the end of input
+  size_t stride;      // input bytes per row (width + newline)
+  int width;
+  int first;          // row number of the first row
+  int rows;
+  uint64_t hash;      // sum of the row hashes
+  bool layout_ok;     // every row ended where expected
+  bool bad;           // invalid character seen
+  bool weighted;      // terrain digits seen
+} ParseChunk;
+
+static void* parse_chunk(void* arg) {
+  ParseChunk* c = arg;
+  const char* row;
+  int y;
+
+  c->layout_ok = true;
+  c->bad = false;
+  c->weighted = false;
+  c->hash = 0;
+
+  for (y = 0; y < c->rows; y++) {
+    row = c->data + y * c->stride;
+
+    // the last row may lack its newline
+    if ((size_t)(row - c->data) + c->width < c->size && row[c->width] != '\n') {
+      c->layout_ok = false;
+      return NULL;
+    }
+    memcpy(c->grid + (size_t)y * c->width, row, c->width);
+    scan_maze_row(row, c->width, &c->bad, &c->weighted);
+    c->hash += hash_row(row, c->width, c->first + y);
+
+    // a newline inside the row: rows differ in length after all
+    if (c->bad && memchr(row, '\n', c->width)) {
+      c->layout_ok = false;
+      return NULL;
+    }
   }
+  return NULL;
+}
 
-  // detect height
-  rewind(fp);
-  height = count_lines(fp);
+// parse fixed-length rows in parallel; false if the rows are not
+// all width long (the caller falls back to the line-by-line parser)
+static bool parse_fixed(Maze* maze, const char* data, size_t size) {
+  ParseChunk chunks[PARALLEL_MAX_THREADS];
+  size_t stride = (size_t)maze->width + 1;
+  uint64_t rows;
+  int n, t, row_begin, row_end;
+
+  n = parallel_threads((long)(size / PARSE_CHUNK_MIN));
+  if (n > maze->height) {
+    n = maze->height;
+  }
 
-  if (height == 0) {
-    fprintf(stderr, "[ERROR]: dimensions out of \n");
-    fprintf(stderr, "Got: width = %d, height = %d\n", width, height);
-    fclose(fp);
-    return NULL;
+  for (t = 0; t < n; t++) {
+    row_begin = (int)((long)maze->height * t / n);
+    row_end = (int)((long)maze->height * (t + 1) / n);
+    chunks[t].data = data + row_begin * stride;
+    chunks[t].grid = maze->grid + (size_t)row_begin * maze->width;
+    chunks[t].size = size - row_begin * stride;
+    chunks[t].stride = stride;
+    chunks[t].width = maze->width;
+    chunks[t].first = row_begin;
+    chunks[t].rows = row_end - row_begin;
   }
 
-  // allocate maze
-  maze = malloc(sizeof(Maze));
+  run_parallel(chunks, sizeof(ParseChunk), n, parse_chunk);
+
+  maze->checked = true;
+  rows = 0;
+  for (t = 0; t < n; t++) {
+    if (!chunks[t].layout_ok) {
+      return false;
+    }
+    maze->checked &= !chunks[t].bad;
+    maze->weighted |= chunks[t].weighted;
+    rows += chunks[t].hash;
+  }
+  maze->hash = hash_finish(rows, maze->width, maze->height);
+  return true;
+}
+
+// line-by-line parser for rows of differing lengths: extra characters
+// past the first line's width are ignored, shorter rows are an error
+static MazeStatus parse_lines(Maze* maze, const char* data, size_t size) {
+  const char* line = data;
+  const char* end = data + size;
+  size_t line_len;
+  uint64_t rows = 0;
+  bool bad = false;
+  int y;
+
+  for (y = 0; y < maze -> height; y++) {
+    line_len = get_line_length(line, end - line);
+    if (line_len < (size_t)maze -> width) {
+      return MAZE_ERR_SHORT_LINE;
+    }
+    memcpy(maze -> grid + IDX(0, y, (size_t)maze -> width), line, maze -> width);
+    scan_maze_row(line, maze -> width, &bad, &maze -> weighted);
+    rows += hash_row(line, maze -> width, y);
+    line += line_len + 1;
+  }
+  maze -> checked = !bad;
+  maze -> hash = hash_finish(rows, maze -> width, maze -> height);
+  return MAZE_OK;
+}
+
+// empty maze with an uninitialized width x height grid, NULL when out of memory
+static Maze* new_maze(const MazeAllocator* alloc, size_t width, size_t height) {
+  Maze* maze;
+
+  maze = mem_alloc(alloc, sizeof(Maze));
   if (!maze) {
-    fprintf(stderr, "[ERROR]: memory allocation failed in maze\n");
-    fclose(fp);
     return NULL;
   }
 
-  // allocate grid
-  maze -> grid = malloc(width * height * sizeof(char));
+  maze -> alloc = *alloc;
+  maze -> width = (int)width;
+  maze -> height = (int)height;
+  maze -> weighted = false;
+  maze -> checked = false;
+  maze -> hash = 0;
+  maze -> labels = NULL;
+  maze -> path = NULL;
+  maze -> path_length = 0;
+  maze -> landmarks = NULL;
+  maze -> targets = NULL;
+
+  maze -> grid = mem_alloc(alloc, width * height);
   if (!maze -> grid) {
-    fprintf(stderr, "[ERROR]: memory allocation failed in grid\n");
-    free(maze);
-    fclose(fp);
+    mem_free(alloc, maze, sizeof(Maze));
     return NULL;
   }
+  return maze;
+}
+
+// Run-length input (format in solver.h): one pass over the runs, each
+// one a memset into the grid, so the ASCII text never exists. A row is
+// hashed as soon as its last cell is in, while it is still in cache;
+// the hash comes out the same as for the ASCII file of the same maze.
 
-  maze -> width = width;
-  maze -> height = height;
-
-  // read maze data into grid
-  rewind(fp);
-
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < width; x++) {
-      c = fgetc(fp);
-
-      if (c == EOF || c == '\n') {
-        if (x < width - 1) {
-          fprintf(stderr, "[ERROR]: line %d is shorter than expected\n", y+1);
-          free_maze(maze);
-          fclose(fp);
-          return NULL;
-        }
-
-        if (c == '\n' && x == width - 1) {
-          c = fgetc(fp);
-          if (c == EOF) {
-            fprintf(stderr, "[ERROR]: unexpected EOF\n");
-            free_maze(maze);
-            fclose(fp);
-            return NULL;
-          }
-        }
+static bool is_blank(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// decimal at *p (at most 11 digits), false if there is none
+static bool read_count(const char** p, const char* end, size_t* out) {
+  const char* start = *p;
+  size_t n = 0;
+
+  while (*p < end && **p >= '0' && **p <= '9' && *p - start < 11) {
+    n = n * 10 + (size_t)(**p - '0');
+    (*p)++;
+  }
+  *out = n;
+  return *p > start && (*p == end || **p < '0' || **p > '9');
+}
+
+static MazeStatus parse_rle(const char* data, size_t size, const MazeAllocator* alloc, Maze** out) {
+  const char* p = data + 5;
+  const char* end = data + size;
+  size_t width, height, cells, count;
+  size_t cell = 0;
+  size_t row_end;  // first cell past the row being filled
+  uint64_t rows = 0;
+  int row = 0;
+  char symbol;
+  Maze* maze;
+
+  // header: "MZR1 <width> <height>\n"
+  if (!read_count(&p, end, &width) || p == end || *p++ != ' ' || !read_count(&p, end, &height)
+      || p == end || *p++ != '\n' || width < 1 || width > MAZE_MAX_SIZE || height < 1
+      || height > MAZE_MAX_SIZE) {
+    return MAZE_ERR_SIZE;
+  }
+  cells = width * height;
+  row_end = width;
+
+  maze = new_maze(alloc, width, height);
+  if (!maze) {
+    return MAZE_ERR_NOMEM;
+  }
+
+  while (p < end) {
+    symbol = *p++;
+    count = 1;
+
+    // lone cells (no count) are the common run of a busy map
+    if (symbol != '*' && symbol != 'X' && symbol != 'E') {
+      if (is_blank(symbol)) {
+        continue;
+      }
+      p--;
+      if (*p >= '0' && *p <= '9' && (!read_count(&p, end, &count) || count == 0 || p == end)) {
+        free_maze(maze);
+        return MAZE_ERR_CHAR;
       }
-      maze -> grid[IDX(x, y, width)] = (char)c;
+      symbol = *p++;
+      if (symbol == '#' && p < end && *p >= '1' && *p <= '9') {
+        symbol = *p++;
+        maze -> weighted = true;
+      } else if (symbol != '*' && symbol != 'X' && symbol != 'E') {
+        free_maze(maze);
+        return MAZE_ERR_CHAR;
+      }
+    }
+    if (count > cells - cell) {
+      free_maze(maze);
+      return MAZE_ERR_SIZE;
+    }
+    if (count == 1) {
+      maze -> grid[cell] = symbol;
+    } else {
+      memset(maze -> grid + cell, symbol, count);
+    }
+    cell += count;
+    for (; cell >= row_end; row_end += width) {
+      rows += hash_row(maze -> grid + row_end - width, (int)width, row++);
     }
+  }
+  if (cell < cells) {
+    free_maze(maze);
+    return MAZE_ERR_SHORT_LINE;
+  }
+
+  maze -> checked = true;
+  maze -> hash = hash_finish(rows, (int)width, (int)height);
+  *out = maze;
+  return MAZE_OK;
+}
+
+// ========= MAIN FUNCTIONS =========
+
+MazeStatus parse_maze(const char* data, size_t size, const MazeAllocator* alloc, Maze** out) {
+  size_t width, height;
+  bool fixed;
+  Maze* maze;
+  MazeStatus status;
+
+  if (!data || !out) {
+    return MAZE_ERR_ARG;
+  }
+  *out = NULL;
+  if (!alloc) {
+    alloc = maze_default_allocator();
+  }
+
+  if (size > 5 && memcmp(data, RLE_MAGIC " ", 5) == 0) {
+    return parse_rle(data, size, alloc, out);
+  }
+
+  // detect width
+  width = get_line_length(data, size);
+  if (width == 0) {
+    return MAZE_ERR_EMPTY;
+  }
+
+  // fixed-length rows give the height from the size alone, with or
+  // without a final newline; anything else needs a counting pass
+  if (size % (width + 1) == 0) {
+    height = size / (width + 1);
+    fixed = true;
+  } else if ((size + 1) % (width + 1) == 0 && data[size - 1] != '\n') {
+    height = (size + 1) / (width + 1);
+    fixed = true;
+  } else {
+    height = count_lines(data, size);
+    fixed = false;
+  }
+  // limits are checked before the grid is allocated, so a huge file
+  // fails fast (a guess past them is recounted: long rows shrink it)
+  if (fixed && height > MAZE_MAX_SIZE) {
+    height = count_lines(data, size);
+    fixed = false;
+  }
+  if (width > MAZE_MAX_SIZE || height > MAZE_MAX_SIZE) {
+    return MAZE_ERR_SIZE;
+  }
+
+  maze = new_maze(alloc, width, height);
+  if (!maze) {
+    return MAZE_ERR_NOMEM;
+  }
 
-    if (y < height -1) {
-      while ((c = fgetc(fp)) != EOF && c != '\n') {
-        // skip to end of line
+  if (!fixed || !parse_fixed(maze, data, size)) {
+    // a fixed-size guess can be wrong (e.g. a long row making up for
+    // a short one): recount and go line by line
+    if (fixed) {
+      mem_free(alloc, maze -> grid, width * height);
+      height = count_lines(data, size);
+      if (height > MAZE_MAX_SIZE) {
+        mem_free(alloc, maze, sizeof(Maze));
+        return MAZE_ERR_SIZE;
       }
+      maze -> height = (int)height;
+      maze -> weighted = false;
+      maze -> grid = mem_alloc(alloc, width * height);
+      if (!maze -> grid) {
+        mem_free(alloc, maze, sizeof(Maze));
+        return MAZE_ERR_NOMEM;
+      }
+    }
+    status = parse_lines(maze, data, size);
+    if (status != MAZE_OK) {
+      free_maze(maze);
+      return status;
     }
   }
-  fclose(fp);
-  return maze;
+
+  *out = maze;
+  return MAZE_OK;
 }
 
-// ======= FREE FUNCTIONS ======
+MazeStatus load_maze(const char* filename, const MazeAllocator* alloc, Maze** out) {
+  struct stat st;
+  void* data;
+  int fd;
+  MazeStatus status;
 
-void free_maze(Maze *maze) {
-  if (!maze){
-    return;
+  if (!filename || !out) {
+    return MAZE_ERR_ARG;
   }
+  *out = NULL;
 
-  if (maze->grid) {
-    free(maze->grid);
+  // open file
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return MAZE_ERR_IO;
   }
 
-  free(maze);
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return MAZE_ERR_IO;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return MAZE_ERR_EMPTY;
+  }
+
+  // map it, parser threads read their chunks straight from the page cache
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return MAZE_ERR_IO;
+  }
+  madvise(data, (size_t)st.st_size, MADV_WILLNEED);
+
+  status = parse_maze(data, (size_t)st.st_size, alloc, out);
+  munmap(data, (size_t)st.st_size);
+  return status;
 }
 
-// ====== PRINT FUNCTION ========
+// ======= FREE FUNCTIONS ======
 
-void print_maze(const Maze *maze) {
-  int x, y;
+void free_maze(Maze *maze) {
+  MazeAllocator alloc;
+  size_t cells;
 
-  if (!maze || !maze -> grid) {
+  if (!maze){
     return;
   }
 
-  for (y = 0; y < maze -> height; y++) {
-    for (x = 0; x < maze -> width; x++) {
-      printf("%c", maze -> grid[IDX(x, y, maze -> width)]);
-    }
-    printf("\n");
+  // the maze holds its own allocator, copy it before releasing the maze
+  alloc = maze->alloc;
+  cells = (size_t)maze->width * maze->height;
+
+  if (maze->grid) {
+    mem_free(&alloc, maze->grid, cells);
   }
-}
 
-// ====== STATS FUNCTION ========
+  if (maze->labels) {
+    mem_free(&alloc, maze->labels, cells * sizeof(int));
+  }
 
-void print_stats(const SolverStats* stats) {
-  if (!stats) {
-    return;
+  if (maze->path) {
+    mem_free(&alloc, maze->path, (size_t)maze->path_length * sizeof(int));
   }
 
-  fprintf(stderr, "\n========== Performance Statistics ==========\n");
-  fprintf(stderr, "Algorithm:       %s\n", stats->algorithm);
-  fprintf(stderr, "Time:            %.3f ms\n", stats->time_ms);
-  fprintf(stderr, "Cells visited:   %d\n", stats->cells_visited);
-  fprintf(stderr, "Path length:     %d\n", stats->path_length);
-  fprintf(stderr, "============================================\n\n");
-}
\ No newline at end of file
+  free_landmarks(maze);
+  free_targets(maze);
+
+  mem_free(&alloc, maze, sizeof(Maze));
+}
@@ -0,0 +1,52 @@
+#include "solver.h"
+
+// CLI output, kept out of libmaze (the library never prints)
+
+// ====== PRINT FUNCTION ========
+
+void print_maze(const Maze *maze) {
+  int y;
+
+  if (!maze || !maze -> grid) {
+    return;
+  }
+
+  // one write per row instead of one printf per cell
+  for (y = 0; y < maze -> height; y++) {
+    fwrite(maze -> grid + IDX(0, y, maze -> width), 1, maze -> width, stdout);
+    putchar('\n');
+  }
+}
+
+// ====== AUTO FUNCTION ========
+
+void print_features(const MazeFeatures* features, MazeAlgorithm algo) {
+  static const char* const names[] = {"BFS", "A*", "Dijkstra", "JPS"};
+
+  fprintf(stderr, "\n=============== Auto Selection =============\n");
+  fprintf(stderr, "Sampled rows:    %d\n", features->rows_sampled);
+  fprintf(stderr, "Wall density:    %.3f\n", features->wall_density);
+  fprintf(stderr, "Corridor length: %.1f\n", features->corridor_length);
+  fprintf(stderr, "Junction ratio:  %.3f\n", features->junction_ratio);
+  fprintf(stderr, "Chosen:          %s\n", names[algo]);
+  fprintf(stderr, "============================================\n");
+}
+
+// ====== STATS FUNCTION ========
+
+void print_stats(const SolverStats* stats) {
+  if (!stats) {
+    return;
+  }
+
+  fprintf(stderr, "\n========== Performance Statistics ==========\n");
+  fprintf(stderr, "Algorithm:       %s\n", stats->algorithm);
+  fprintf(stderr, "Time:            %.3f ms\n", stats->time_ms);
+  fprintf(stderr, "Cells visited:   %d\n", stats->cells_visited);
+  fprintf(stderr, "Path length:     %d\n", stats->path_length);
+  fprintf(stderr, "Path cost:       %g\n", stats->path_cost);
+  if (stats->bound > 1.0) {
+    fprintf(stderr, "Bound:           <= %.3f x optimal\n", stats->bound);
+  }
+  fprintf(stderr, "============================================\n\n");
+}
@@ -0,0 +1,37 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+int parallel_threads(long units) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  long n = cpus > 0 ? cpus : 1;
+
+  if (n > PARALLEL_MAX_THREADS) {
+    n = PARALLEL_MAX_THREADS;
+  }
+  if (n > units) {
+    n = units;
+  }
+  return n > 0 ? (int)n : 1;
+}
+
+void run_parallel(void* tasks, size_t task_size, int n, void* (*fn)(void*)) {
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  bool started[PARALLEL_MAX_THREADS];
+  char* task = tasks;
+  int t;
+
+  for (t = 1; t < n; t++) {
+    started[t] = pthread_create(&threads[t], NULL, fn, task + t * task_size) == 0;
+    if (!started[t]) {
+      fn(task + t * task_size);
+    }
+  }
+  fn(task);
+  for (t = 1; t < n; t++) {
+    if (started[t]) {
+      pthread_join(threads[t], NULL);
+    }
+  }
+}
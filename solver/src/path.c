@@ -0,0 +1,188 @@
+#include "solver.h"
+#include "movement.h"
+#include <stdint.h>
+
+// Solution paths: solvers store the cells from start to finish on the
+// maze and leave the grid alone. The grid is only marked with 'o' when
+// the full maze is printed; compact formats encode the moves directly.
+
+// move letters by direction index (diagonals: Q up-left, E up-right,
+// Z down-left, C down-right, as around S on a keyboard)
+static const char dir_letter[DIRS_DIAGONAL] = {'U', 'D', 'L', 'R', 'Q', 'E', 'Z', 'C'};
+
+// magic of the binary record (2: the start cell is stored)
+#define PATH_MAGIC "MZP2"
+
+int* path_reserve(Maze* maze, int length) {
+  path_clear(maze);
+
+  maze->path = mem_alloc(&maze->alloc, (size_t)length * sizeof(int));
+  if (!maze->path) {
+    return NULL;
+  }
+  maze->path_length = length;
+  return maze->path;
+}
+
+void path_clear(Maze* maze) {
+  mem_free(&maze->alloc, maze->path, (size_t)maze->path_length * sizeof(int));
+  maze->path = NULL;
+  maze->path_length = 0;
+}
+
+void mark_path(Maze* maze) {
+  int i;
+
+  for (i = 0; i < maze->path_length; i++) {
+    maze->grid[maze->path[i]] = 'o';
+  }
+}
+
+// direction index of the step from cell a to its neighbor b
+static int step_dir(int a, int b, int width) {
+  int dx = b % width - a % width;
+  int dy = b / width - a / width;
+  int d;
+
+  for (d = 0; d < DIRS_DIAGONAL; d++) {
+    if (dir_dx[d] == dx && dir_dy[d] == dy) {
+      break;
+    }
+  }
+  return d;
+}
+
+// a path as the formats see it: a start cell and a direction per move,
+// taken from stored cells or given directly
+typedef struct {
+  const int* cells;           // cells start to finish (NULL: dirs)
+  const unsigned char* dirs;  // direction index per move
+  int width;
+  int start_x, start_y;
+  size_t moves;
+} Steps;
+
+static inline int step_at(const Steps* p, size_t i) {
+  return p->dirs ? p->dirs[i] : step_dir(p->cells[i], p->cells[i + 1], p->width);
+}
+
+static void put_u32(FILE* out, uint32_t v) {
+  unsigned char b[4] = {v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24};
+
+  fwrite(b, 1, sizeof(b), out);
+}
+
+// binary record, little-endian:
+// "MZP2", width, height, start x, start y, move count (u32 each), bits
+// per move (u8: 2 when every move is orthogonal, else 4), then direction
+// indices packed low bits first
+static void write_binary(FILE* out, const Steps* p, int height) {
+  int bits = 2;
+  unsigned byte = 0;
+  int fill = 0;
+  size_t i;
+
+  for (i = 0; i < p->moves; i++) {
+    if (step_at(p, i) >= DIRS_ORTHOGONAL) {
+      bits = 4;
+      break;
+    }
+  }
+
+  fwrite(PATH_MAGIC, 1, 4, out);
+  put_u32(out, (uint32_t)p->width);
+  put_u32(out, (uint32_t)height);
+  put_u32(out, (uint32_t)p->start_x);
+  put_u32(out, (uint32_t)p->start_y);
+  put_u32(out, (uint32_t)p->moves);
+  putc(bits, out);
+
+  for (i = 0; i < p->moves; i++) {
+    byte |= (unsigned)step_at(p, i) << fill;
+    fill += bits;
+    if (fill == 8) {
+      putc(byte, out);
+      byte = 0;
+      fill = 0;
+    }
+  }
+  if (fill) {
+    putc(byte, out);
+  }
+}
+
+static MazeStatus write_steps(FILE* out, PathFormat format, const Steps* p, int height) {
+  size_t i, run;
+  int x = p->start_x;
+  int y = p->start_y;
+  int d;
+
+  switch (format) {
+    case PATH_COORDS:
+      fprintf(out, "%d %d\n", x, y);
+      for (i = 0; i < p->moves; i++) {
+        d = step_at(p, i);
+        x += dir_dx[d];
+        y += dir_dy[d];
+        fprintf(out, "%d %d\n", x, y);
+      }
+      break;
+
+    case PATH_MOVES:
+      for (i = 0; i < p->moves; i++) {
+        putc(dir_letter[step_at(p, i)], out);
+      }
+      putc('\n', out);
+      break;
+
+    case PATH_RLE:
+      // count before the letter, left out for single moves: "3RD2R"
+      for (i = 0; i < p->moves; i += run) {
+        d = step_at(p, i);
+        run = 1;
+        while (i + run < p->moves && step_at(p, i + run) == d) {
+          run++;
+        }
+        if (run > 1) {
+          fprintf(out, "%zu", run);
+        }
+        putc(dir_letter[d], out);
+      }
+      putc('\n', out);
+      break;
+
+    case PATH_BINARY:
+      // the record counts moves in 32 bits
+      if (p->moves > UINT32_MAX) {
+        return MAZE_ERR_SIZE;
+      }
+      write_binary(out, p, height);
+      break;
+
+    case PATH_GRID:
+      return MAZE_ERR_ARG;  // needs the grid, see print_maze
+  }
+  return ferror(out) ? MAZE_ERR_IO : MAZE_OK;
+}
+
+MazeStatus write_path(FILE* out, PathFormat format, const int* cells, int length, int width,
+                      int height) {
+  Steps p = { .cells = cells, .width = width };
+
+  // no cells, no moves: coords still has no line to print
+  if (length <= 0) {
+    return format == PATH_COORDS ? MAZE_OK : write_steps(out, format, &p, height);
+  }
+  p.start_x = cells[0] % width;
+  p.start_y = cells[0] / width;
+  p.moves = (size_t)length - 1;
+  return write_steps(out, format, &p, height);
+}
+
+MazeStatus write_moves(FILE* out, PathFormat format, int start_x, int start_y,
+                       const unsigned char* dirs, size_t moves, int width, int height) {
+  Steps p = { .dirs = dirs, .width = width, .start_x = start_x, .start_y = start_y,
+              .moves = moves };
+
+  return write_steps(out, format, &p, height);
+}
@@ -0,0 +1,394 @@
+#include "pipeline.h"
+#include "cache.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Pipelined directory runs.
+//
+//   reader -> [raw ring] -> parser -> [parsed ring] -> solver (caller)
+//
+// The reader pulls whole files into memory with read(), so the disk wait
+// happens on its thread while the solver works on an earlier maze. Each
+// ring has exactly one producer and one consumer and needs no lock: the
+// producer owns tail, the consumer owns head, and the release store of
+// one paired with the acquire load of the other publishes the slot.
+// Rings hold PIPELINE_DEPTH mazes, which bounds memory whatever the
+// directory size. A stage facing a full or empty ring yields, then naps,
+// so it does not spin on a core the other stages need. A NULL item ends
+// the stream.
+//
+// The solver stage keeps a result cache: a maze that repeats one solved
+// earlier in the run (same content hash from the parser, same setup) is
+// answered from it without a search.
+
+// yields before a waiting stage starts napping
+#define PIPELINE_SPINS 64
+// nap between polls of a waiting stage (ns)
+#define PIPELINE_NAP_NS 50000
+
+enum { STAGE_READ, STAGE_PARSE, STAGE_SOLVE, STAGES };
+
+typedef struct {
+  const char* name;   // file path, for the result line
+  char* data;         // file contents (reader -> parser)
+  size_t size;
+  Maze* maze;         // parsed and valid maze (parser -> solver)
+  MazeStatus status;  // first failure along the way
+} PipelineItem;
+
+typedef struct {
+  PipelineItem* slots[PIPELINE_DEPTH];
+  atomic_size_t head;  // next slot to pop (consumer)
+  atomic_size_t tail;  // next slot to push (producer)
+} Ring;
+
+typedef struct {
+  PipelineItem* items;
+  int count;
+  MazeAlgorithm algo;
+  SolverOptions opts;
+  PathFormat format;   // path after each result line unless PATH_GRID
+  bool precheck;       // label components in the parse stage
+  Ring raw;            // read, not parsed yet
+  Ring parsed;         // parsed, not solved yet
+  ResultCache* cache;  // solver stage only (NULL = every maze is searched)
+  int cache_errors;    // entries that could not be written to the cache directory
+  double busy[STAGES]; // ms spent working per stage (each written by one thread)
+  int errors;
+} Pipeline;
+
+// monotonic wall clock in ms (stages overlap, CPU time would mislead)
+static double now_ms(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// back off while the ring is full or empty
+static void ring_wait(int* spins) {
+  struct timespec nap = { 0, PIPELINE_NAP_NS };
+
+  if (++*spins < PIPELINE_SPINS) {
+    sched_yield();
+  } else {
+    nanosleep(&nap, NULL);
+  }
+}
+
+static void ring_push(Ring* ring, PipelineItem* item) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  int spins = 0;
+
+  while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == PIPELINE_DEPTH) {
+    ring_wait(&spins);
+  }
+  ring->slots[tail % PIPELINE_DEPTH] = item;
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+static PipelineItem* ring_pop(Ring* ring) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  PipelineItem* item;
+  int spins = 0;
+
+  while (atomic_load_explicit(&ring->tail, memory_order_acquire) == head) {
+    ring_wait(&spins);
+  }
+  item = ring->slots[head % PIPELINE_DEPTH];
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  return item;
+}
+
+// ======= STAGES ======
+
+// whole file into item->data
+static void read_item(PipelineItem* item) {
+  struct stat st;
+  size_t done = 0;
+  ssize_t n;
+  int fd;
+
+  fd = open(item->name, O_RDONLY);
+  if (fd < 0) {
+    item->status = MAZE_ERR_IO;
+    return;
+  }
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    item->status = MAZE_ERR_IO;
+  } else if (st.st_size == 0) {
+    item->status = MAZE_ERR_EMPTY;
+  } else if (!(item->data = malloc((size_t)st.st_size))) {
+    item->status = MAZE_ERR_NOMEM;
+  } else {
+    item->size = (size_t)st.st_size;
+    while (done < item->size) {
+      n = read(fd, item->data + done, item->size - done);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        break;
+      }
+      done += (size_t)n;
+    }
+    if (done < item->size) {
+      item->status = MAZE_ERR_IO;
+    }
+  }
+  close(fd);
+}
+
+// parse and validate (and label with precheck); only valid mazes go on
+// to the solver
+static void parse_item(PipelineItem* item, bool precheck) {
+  if (item->status == MAZE_OK) {
+    item->status = parse_maze(item->data, item->size, NULL, &item->maze);
+  }
+  free(item->data);
+  item->data = NULL;
+  if (item->status == MAZE_OK) {
+    item->status = validate_maze(item->maze);
+  }
+  if (item->status == MAZE_OK && precheck) {
+    item->status = label_components(item->maze);
+  }
+  if (item->status != MAZE_OK) {
+    free_maze(item->maze);
+    item->maze = NULL;
+  }
+}
+
+// answer from the cache or solve, then print the result line
+static void solve_item(Pipeline* p, PipelineItem* item) {
+  CacheKey key;
+  double cost;
+
+  if (item->status == MAZE_OK && p->cache) {
+    key = cache_key(item->maze, p->algo, &p->opts, 0);
+    if (!cache_lookup(p->cache, &key, item->maze, &item->status, &cost)) {
+      item->status = maze_solve(item->maze, p->algo, &p->opts, NULL);
+      if (cache_store(p->cache, &key, item->maze, item->status) != MAZE_OK) {
+        p->cache_errors++;
+      }
+    }
+  } else if (item->status == MAZE_OK) {
+    item->status = maze_solve(item->maze, p->algo, &p->opts, NULL);
+  }
+  if (item->status == MAZE_OK) {
+    printf("%s: %d\n", item->name, item->maze->path_length);
+    if (p->format != PATH_GRID) {
+      write_path(stdout, p->format, item->maze->path, item->maze->path_length,
+                 item->maze->width, item->maze->height);
+    }
+  } else if (item->status == MAZE_NO_PATH) {
+    printf("%s: no solution found\n", item->name);
+  } else {
+    printf("%s: error: %s\n", item->name, maze_strerror(item->status));
+    p->errors++;
+  }
+  free_maze(item->maze);
+  item->maze = NULL;
+}
+
+static void* reader_stage(void* arg) {
+  Pipeline* p = arg;
+  double start;
+  int i;
+
+  for (i = 0; i < p->count; i++) {
+    start = now_ms();
+    read_item(&p->items[i]);
+    p->busy[STAGE_READ] += now_ms() - start;
+    ring_push(&p->raw, &p->items[i]);
+  }
+  ring_push(&p->raw, NULL);
+  return NULL;
+}
+
+static void* parser_stage(void* arg) {
+  Pipeline* p = arg;
+  PipelineItem* item;
+  double start;
+
+  while ((item = ring_pop(&p->raw))) {
+    start = now_ms();
+    parse_item(item, p->precheck);
+    p->busy[STAGE_PARSE] += now_ms() - start;
+    ring_push(&p->parsed, item);
+  }
+  ring_push(&p->parsed, NULL);
+  return NULL;
+}
+
+// ======= DRIVER ======
+
+static int compare_names(const void* a, const void* b) {
+  return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// regular, non-hidden files of dir as "dir/name", sorted; NULL on error
+static char** list_mazes(const char* dir, int* count) {
+  DIR* d = opendir(dir);
+  struct dirent* entry;
+  struct stat st;
+  char** names = NULL;
+  char** grown;
+  char* path;
+  int capacity = 0;
+  int n = 0;
+
+  if (!d) {
+    return NULL;
+  }
+  while ((entry = readdir(d))) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    path = malloc(strlen(dir) + strlen(entry->d_name) + 2);
+    if (!path) {
+      break;
+    }
+    sprintf(path, "%s/%s", dir, entry->d_name);
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+      free(path);
+      continue;
+    }
+    if (n == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      grown = realloc(names, (size_t)capacity * sizeof(char*));
+      if (!grown) {
+        free(path);
+        break;
+      }
+      names = grown;
+    }
+    names[n++] = path;
+  }
+  closedir(d);
+
+  if (n > 1) {
+    qsort(names, (size_t)n, sizeof(char*), compare_names);
+  }
+  *count = n;
+  return names ? names : malloc(sizeof(char*));
+}
+
+static void print_pipeline_stats(const Pipeline* p, double wall_ms) {
+  double total = p->busy[STAGE_READ] + p->busy[STAGE_PARSE] + p->busy[STAGE_SOLVE];
+
+  fprintf(stderr, "\n================= Pipeline =================\n");
+  fprintf(stderr, "Mazes:           %d\n", p->count);
+  fprintf(stderr, "Time:            %.3f ms\n", wall_ms);
+  fprintf(stderr, "Read (busy):     %.3f ms\n", p->busy[STAGE_READ]);
+  fprintf(stderr, "Parse (busy):    %.3f ms\n", p->busy[STAGE_PARSE]);
+  fprintf(stderr, "Solve (busy):    %.3f ms\n", p->busy[STAGE_SOLVE]);
+  fprintf(stderr, "Overlap:         %.2fx\n", wall_ms > 0 ? total / wall_ms : 1.0);
+  if (p->cache) {
+    fprintf(stderr, "Cache hits:      %d of %d\n", p->cache->hits,
+            p->cache->hits + p->cache->misses);
+  }
+  fprintf(stderr, "============================================\n\n");
+}
+
+int run_pipeline(const char* dir, MazeAlgorithm algo, const SolverOptions* opts,
+                 PathFormat format, bool precheck, const char* cache_dir, bool show_stats) {
+  Pipeline p = { .algo = algo, .format = format, .precheck = precheck };
+  pthread_t reader, parser;
+  bool reader_started, parser_started;
+  PipelineItem* item;
+  MazeStatus status;
+  char** names;
+  double start, wall;
+  int i;
+
+  names = list_mazes(dir, &p.count);
+  if (!names) {
+    fprintf(stderr, "[ERROR]: cannot read directory %s\n", dir);
+    return 1;
+  }
+  p.items = calloc((size_t)(p.count ? p.count : 1), sizeof(PipelineItem));
+  if (!p.items) {
+    fprintf(stderr, "Error: %s\n", maze_strerror(MAZE_ERR_NOMEM));
+    for (i = 0; i < p.count; i++) {
+      free(names[i]);
+    }
+    free(names);
+    return 1;
+  }
+  for (i = 0; i < p.count; i++) {
+    p.items[i].name = names[i];
+  }
+  if (opts) {
+    p.opts = *opts;
+  }
+
+  // a deadline makes the answer depend on timing, not on the maze alone
+  if (!(algo == MAZE_ALGO_ANYTIME && p.opts.timeout_ms)) {
+    status = cache_open(cache_dir, CACHE_MEM_DEFAULT, &p.cache);
+    if (status != MAZE_OK) {
+      fprintf(stderr, "[ERROR]: cache %s: %s\n", cache_dir,
+              status == MAZE_ERR_IO ? "cannot create directory" : maze_strerror(status));
+      for (i = 0; i < p.count; i++) {
+        free(names[i]);
+      }
+      free(names);
+      free(p.items);
+      return 1;
+    }
+  }
+
+  // a stage whose thread cannot be started runs on the caller instead
+  start = now_ms();
+  reader_started = pthread_create(&reader, NULL, reader_stage, &p) == 0;
+  parser_started = reader_started && pthread_create(&parser, NULL, parser_stage, &p) == 0;
+  for (i = 0; reader_started || i < p.count; i++) {
+    if (reader_started) {
+      item = ring_pop(parser_started ? &p.parsed : &p.raw);
+      if (!item) {
+        break;
+      }
+    } else {
+      item = &p.items[i];
+      wall = now_ms();
+      read_item(item);
+      p.busy[STAGE_READ] += now_ms() - wall;
+    }
+    if (!parser_started) {
+      wall = now_ms();
+      parse_item(item, p.precheck);
+      p.busy[STAGE_PARSE] += now_ms() - wall;
+    }
+    wall = now_ms();
+    solve_item(&p, item);
+    p.busy[STAGE_SOLVE] += now_ms() - wall;
+  }
+  if (parser_started) {
+    pthread_join(parser, NULL);
+  }
+  if (reader_started) {
+    pthread_join(reader, NULL);
+  }
+  wall = now_ms() - start;
+
+  if (show_stats) {
+    fflush(stdout);
+    print_pipeline_stats(&p, wall);
+  }
+  if (p.cache_errors) {
+    fprintf(stderr, "Note: cache %s: %d entries could not be written\n", cache_dir,
+            p.cache_errors);
+  }
+  cache_close(p.cache);
+  for (i = 0; i < p.count; i++) {
+    free(names[i]);
+  }
+  free(names);
+  free(p.items);
+  return p.errors ? 1 : 0;
+}
@@ -1,6 +1,5 @@
 #include "priority_queue.h"
-#include <stdlib.h>
-#include <stdio.h>
+#include "alloc.h"
 
 // Helper functions for heap operations
 static void swap_nodes(PQNode* a, PQNode* b) {
@@ -42,32 +41,58 @@ static void heapify_down(PriorityQueue* pq, int idx) {
   }
 }
 
-PriorityQueue* create_pq(int capacity) {
-  PriorityQueue* pq = malloc(sizeof(PriorityQueue));
+PriorityQueue* create_pq(int capacity, const MazeAllocator* alloc) {
+  PriorityQueue* pq;
+
+  if (capacity <= 0) {
+    capacity = 1;
+  }
+
+  pq = mem_alloc(alloc, sizeof(PriorityQueue));
   if (!pq) {
     return NULL;
   }
 
-  pq->nodes = malloc(sizeof(PQNode) * capacity);
+  pq->nodes = mem_alloc(alloc, sizeof(PQNode) * capacity);
   if (!pq->nodes) {
-    free(pq);
+    mem_free(alloc, pq, sizeof(PriorityQueue));
     return NULL;
   }
+  pq->alloc = alloc;
 
   pq->size = 0;
   pq->capacity = capacity;
   return pq;
 }
 
-void pq_push(PriorityQueue* pq, int index, int priority) {
+bool pq_push(PriorityQueue* pq, int index, unsigned long long priority) {
+  PQNode* grown;
+
   if (pq->size >= pq->capacity) {
-    return;  // queue full
+    grown = mem_realloc(pq->alloc, pq->nodes, sizeof(PQNode) * pq->capacity,
+                        sizeof(PQNode) * pq->capacity * 2);
+    if (!grown) {
+      return false;  // queue full
+    }
+    pq->nodes = grown;
+    pq->capacity *= 2;
   }
 
   pq->nodes[pq->size].index = index;
   pq->nodes[pq->size].priority = priority;
   heapify_up(pq, pq->size);
   pq->size++;
+  return true;
+}
+
+bool pq_peek(const PriorityQueue* pq, int* index, unsigned long long* priority) {
+  if (pq->size == 0) {
+    return false;
+  }
+
+  *index = pq->nodes[0].index;
+  *priority = pq->nodes[0].priority;
+  return true;
 }
 
 bool pq_pop(PriorityQueue* pq, int* index) {
@@ -92,7 +117,7 @@ bool pq_is_empty(PriorityQueue* pq) {
 
 void free_pq(PriorityQueue* pq) {
   if (pq) {
-    free(pq->nodes);
-    free(pq);
+    mem_free(pq->alloc, pq->nodes, sizeof(PQNode) * pq->capacity);
+    mem_free(pq->alloc, pq, sizeof(PriorityQueue));
   }
 }
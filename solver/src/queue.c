@@ -1,29 +1,26 @@
 #include "queue.h"
-#include <stdlib.h>
-#include <stdio.h>
+#include "alloc.h"
 
 // create queue
-Queue* create_queue(int capacity) {
+Queue* create_queue(int capacity, const MazeAllocator* alloc) {
   Queue* queue;
   
   if (capacity <= 0) {
-    fprintf(stderr, "[ERROR]: invalid queue capacity %d\n", capacity);
     return NULL;
   }
   
   // allocate queue structure
-  queue = malloc(sizeof(Queue));
+  queue = mem_alloc(alloc, sizeof(Queue));
   if (!queue) {
-    fprintf(stderr, "[ERROR]: failed to allocate queue\n");
     return NULL;
   }
 
-  queue->data = malloc(capacity * sizeof(int));
+  queue->data = mem_alloc(alloc, capacity * sizeof(int));
   if (!queue->data) {
-    fprintf(stderr, "[ERROR]: failed to allocate queue data\n");
-    free(queue);
+    mem_free(alloc, queue, sizeof(Queue));
     return NULL;
   }
+  queue->alloc = alloc;
 
   // initializing fields
   queue->front = 0;
@@ -41,8 +38,7 @@ bool enqueue(Queue* queue, int value) {
   }
 
   if (queue->size >= queue->capacity) {
-    fprintf(stderr, "Error: queue is full\n");
-    return false;
+    return false;  // full
   }
 
   queue->rear = (queue->rear + 1) % queue->capacity;
@@ -86,7 +82,7 @@ void free_queue(Queue* queue) {
   }
   
   if (queue->data) {
-    free(queue->data);
+    mem_free(queue->alloc, queue->data, queue->capacity * sizeof(int));
   }
-  free(queue);
+  mem_free(queue->alloc, queue, sizeof(Queue));
 }
\ No newline at end of file
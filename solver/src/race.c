@@ -0,0 +1,107 @@
+#include "solver.h"
+#include "parallel.h"
+
+// Portfolio racing: which solver wins depends on the maze family, so
+// run every solver with the same objective at once and keep the first
+// answer. The grid is shared read-only (solvers only store a path);
+// each racer works on a shallow copy of the maze with its own path.
+// The winner sets a cancel flag that the others poll in their loops.
+
+// most racers for one movement/terrain mode
+#define RACE_MAX 2
+
+typedef MazeStatus (*SolveFn)(Maze*, const SolverOptions*);
+typedef MazeStatus (*SolveStatsFn)(Maze*, const SolverOptions*, SolverStats*);
+
+typedef struct {
+  Maze view;                // shared grid and labels, own path
+  SolveFn solve;
+  SolveStatsFn solve_stats; // used when stats were asked for
+  SolverOptions opts;       // caller's options with the race cancel flag
+  SolverStats stats;
+  MazeStatus status;
+  int id;
+  atomic_int* winner;       // id of the first racer to answer, -1 = none yet
+  atomic_bool* cancel;
+} RaceTask;
+
+static void* race_worker(void* arg) {
+  RaceTask* task = arg;
+  int none = -1;
+
+  task->status = task->solve_stats ? task->solve_stats(&task->view, &task->opts, &task->stats)
+                                   : task->solve(&task->view, &task->opts);
+
+  // a path or a definite "no path" ends the race, errors do not
+  if ((task->status == MAZE_OK || task->status == MAZE_NO_PATH) &&
+      atomic_compare_exchange_strong(task->winner, &none, task->id)) {
+    atomic_store(task->cancel, true);
+  }
+  return NULL;
+}
+
+MazeStatus solve_race(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  RaceTask tasks[RACE_MAX];
+  SolveFn solve[RACE_MAX];
+  SolveStatsFn solve_stats[RACE_MAX];
+  atomic_int winner = -1;
+  atomic_bool cancel = false;
+  bool diagonal = opts && opts->diagonal;
+  int n, i, w;
+
+  // validate input
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
+  }
+
+  // only solvers that optimize the same thing: fewest cells / octile
+  // cost on uniform terrain, terrain cost on weighted mazes
+  if (maze->weighted) {
+    solve[0] = solve_astar;    solve_stats[0] = solve_astar_stats;
+    solve[1] = solve_dijkstra; solve_stats[1] = solve_dijkstra_stats;
+  } else if (diagonal) {
+    solve[0] = solve_astar;    solve_stats[0] = solve_astar_stats;
+    solve[1] = solve_jps;      solve_stats[1] = solve_jps_stats;
+  } else {
+    solve[0] = solve_bfs;      solve_stats[0] = solve_bfs_stats;
+    solve[1] = solve_astar;    solve_stats[1] = solve_astar_stats;
+  }
+  n = RACE_MAX;
+
+  for (i = 0; i < n; i++) {
+    tasks[i].view = *maze;
+    tasks[i].view.path = NULL;
+    tasks[i].view.path_length = 0;
+    tasks[i].solve = solve[i];
+    tasks[i].solve_stats = stats ? solve_stats[i] : NULL;
+    tasks[i].opts = opts ? *opts : (SolverOptions){ .diagonal = false };
+    tasks[i].opts.cancel = &cancel;
+    tasks[i].opts.trace = NULL;  // one writer per trace, racers would interleave
+    tasks[i].id = i;
+    tasks[i].winner = &winner;
+    tasks[i].cancel = &cancel;
+  }
+
+  // every racer gets a thread, even on fewer cores
+  run_parallel(tasks, sizeof(RaceTask), n, race_worker);
+
+  // the winner's path moves to the maze, the rest is dropped
+  w = atomic_load(&winner);
+  path_clear(maze);
+  for (i = 0; i < n; i++) {
+    if (i == w) {
+      maze->path = tasks[i].view.path;
+      maze->path_length = tasks[i].view.path_length;
+    } else {
+      path_clear(&tasks[i].view);
+    }
+  }
+
+  if (w < 0) {
+    return tasks[0].status;  // every racer failed
+  }
+  if (stats) {
+    *stats = tasks[w].stats;
+  }
+  return tasks[w].status;
+}
@@ -0,0 +1,144 @@
+#include "radix_heap.h"
+#include "alloc.h"
+#include <string.h>
+
+// Bucket for a key: 0 if equal to last, else 1 + highest differing bit
+static int bucket_of(unsigned int key, unsigned int last) {
+  if (key == last) {
+    return 0;
+  }
+  return 32 - __builtin_clz(key ^ last);
+}
+
+// grow b to hold at least need nodes
+static bool bucket_reserve(const MazeAllocator* alloc, RadixBucket* b, int need) {
+  RadixNode* grown;
+  int capacity;
+
+  if (need > b->capacity) {
+    capacity = b->capacity ? b->capacity * 2 : 64;
+    while (capacity < need) {
+      capacity *= 2;
+    }
+    grown = mem_realloc(alloc, b->nodes, sizeof(RadixNode) * b->capacity,
+                        sizeof(RadixNode) * capacity);
+    if (!grown) {
+      return false;
+    }
+    b->nodes = grown;
+    b->capacity = capacity;
+  }
+  return true;
+}
+
+static bool bucket_append(const MazeAllocator* alloc, RadixBucket* b, int index, unsigned int key) {
+  if (!bucket_reserve(alloc, b, b->size + 1)) {
+    return false;
+  }
+
+  b->nodes[b->size].index = index;
+  b->nodes[b->size].key = key;
+  b->size++;
+  return true;
+}
+
+RadixHeap* create_radix_heap(int capacity, const MazeAllocator* alloc) {
+  RadixHeap* rh = mem_zalloc(alloc, sizeof(RadixHeap));
+  if (!rh) {
+    return NULL;
+  }
+  rh->alloc = alloc;
+
+  if (capacity > 0) {
+    rh->buckets[0].nodes = mem_alloc(alloc, sizeof(RadixNode) * capacity);
+    if (!rh->buckets[0].nodes) {
+      mem_free(alloc, rh, sizeof(RadixHeap));
+      return NULL;
+    }
+    rh->buckets[0].capacity = capacity;
+  }
+
+  return rh;
+}
+
+bool rh_push(RadixHeap* rh, int index, unsigned int key) {
+  if (key < rh->last) {
+    return false;  // would break monotonicity
+  }
+
+  if (!bucket_append(rh->alloc, &rh->buckets[bucket_of(key, rh->last)], index, key)) {
+    return false;
+  }
+  rh->size++;
+  return true;
+}
+
+bool rh_pop(RadixHeap* rh, int* index, unsigned int* key) {
+  RadixBucket* b;
+  unsigned int min_key;
+  int moving[RADIX_BUCKETS];  // nodes bound for each bucket on a refill
+  int i, j;
+
+  if (rh->size == 0) {
+    return false;
+  }
+
+  // refill bucket 0 from the first non-empty bucket
+  if (rh->buckets[0].size == 0) {
+    i = 1;
+    while (rh->buckets[i].size == 0) {
+      i++;
+    }
+
+    b = &rh->buckets[i];
+    min_key = b->nodes[0].key;
+    for (j = 1; j < b->size; j++) {
+      if (b->nodes[j].key < min_key) {
+        min_key = b->nodes[j].key;
+      }
+    }
+
+    // every node moves to a strictly lower bucket: room for all of them
+    // first, so running out of memory leaves the heap as it was
+    memset(moving, 0, sizeof(moving));
+    for (j = 0; j < b->size; j++) {
+      moving[bucket_of(b->nodes[j].key, min_key)]++;
+    }
+    for (j = 0; j < i; j++) {
+      if (moving[j] && !bucket_reserve(rh->alloc, &rh->buckets[j], rh->buckets[j].size + moving[j])) {
+        return false;
+      }
+    }
+    rh->last = min_key;
+    for (j = 0; j < b->size; j++) {
+      bucket_append(rh->alloc, &rh->buckets[bucket_of(b->nodes[j].key, min_key)],
+                    b->nodes[j].index, b->nodes[j].key);
+    }
+    b->size = 0;
+  }
+
+  b = &rh->buckets[0];
+  b->size--;
+  *index = b->nodes[b->size].index;
+  if (key) {
+    *key = b->nodes[b->size].key;
+  }
+  rh->size--;
+
+  return true;
+}
+
+bool rh_is_empty(const RadixHeap* rh) {
+  return rh->size == 0;
+}
+
+void free_radix_heap(RadixHeap* rh) {
+  int i;
+
+  if (rh) {
+    for (i = 0; i < RADIX_BUCKETS; i++) {
+      mem_free(rh->alloc, rh->buckets[i].nodes, sizeof(RadixNode) * rh->buckets[i].capacity);
+    }
+    mem_free(rh->alloc, rh, sizeof(RadixHeap));
+  }
+}
@@ -0,0 +1,347 @@
+#include "solver.h"
+#include "priority_queue.h"
+#include "arena.h"
+#include "movement.h"
+#include <stdint.h>
+
+// Anytime weighted A*: searches with f = g + w * h, w from large to 1.
+// A large w dives to the goal and returns a first path quickly, each
+// next run is cheaper to beat because everything that cannot improve
+// on the best path so far is pruned. The run with weight w finds a path
+// of cost <= w * optimal (h is consistent), so the best path always
+// carries a bound; the w = 1 run proves it optimal. A deadline or the
+// cancel flag ends the sequence, the best path found so far stands.
+//
+// Weighted keys are not monotone (w * h can drop faster than g grows),
+// so the open set is the binary heap, not the radix heap.
+
+// weights in tenths (f = 10 g + weight h), the last one is plain A*
+static const int weights[] = {50, 30, 20, 15, 12, 10};
+#define WEIGHT_SCALE 10
+
+// parent direction values (0 = not reached yet)
+#define DIR_NONE  0
+#define DIR_START 15
+
+// state byte layout: low nibble = parent direction, then closed flag
+#define DIR_MASK    0x0F
+#define CLOSED_BIT  0x10
+
+// low key bits: h as tie-breaker, deeper cells first among equal f
+#define TIE_BITS 24
+#define TIE_MAX  ((1u << TIE_BITS) - 1)
+
+// how one weighted run ended
+typedef enum {
+  RUN_FOUND,      // goal reached below the incumbent cost
+  RUN_EXHAUSTED,  // nothing left that could beat the incumbent
+  RUN_STOPPED,    // deadline or cancel flag
+  RUN_NOMEM
+} RunResult;
+
+typedef struct {
+  Maze* maze;
+  uint32_t* g;           // cost from start (valid once reached)
+  unsigned char* state;  // parent direction | CLOSED_BIT
+  PriorityQueue* open_set;
+  const atomic_bool* cancel;
+  double deadline;       // monotonic ms, 0 = none
+  bool cancelled;        // stopped by the flag rather than the deadline
+  unsigned polls;
+  int expanded;
+} AnytimeSearch;
+
+// monotonic wall clock in ms (the deadline is wall time, not CPU time)
+static double now_ms(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// cancel flag and deadline, looked at every CANCEL_POLL expansions
+static bool should_stop(AnytimeSearch* s) {
+  if ((++s->polls & (CANCEL_POLL - 1)) != 0) {
+    return false;
+  }
+  if (s->cancel && atomic_load_explicit(s->cancel, memory_order_relaxed)) {
+    s->cancelled = true;
+    return true;
+  }
+  return s->deadline > 0 && now_ms() >= s->deadline;
+}
+
+// Manhattan or octile distance, in g units
+ALWAYS_INLINE uint32_t anytime_estimate(int x, int y, int goal_x, int goal_y,
+                                        const bool diagonal) {
+  int dist_x = (x > goal_x) ? (x - goal_x) : (goal_x - x);
+  int dist_y = (y > goal_y) ? (y - goal_y) : (goal_y - y);
+
+  return diagonal ? (uint32_t)octile_distance(x, y, goal_x, goal_y) : (uint32_t)(dist_x + dist_y);
+}
+
+ALWAYS_INLINE unsigned long long anytime_key(uint32_t g, uint32_t h, int weight) {
+  unsigned long long f = (unsigned long long)g * WEIGHT_SCALE + (unsigned long long)h * weight;
+
+  return (f << TIE_BITS) | (h < TIE_MAX ? h : TIE_MAX);
+}
+
+// one weighted A* run from scratch (state already zeroed for the first),
+// cells that cannot reach the goal below incumbent are never queued
+ALWAYS_INLINE RunResult weighted_run(AnytimeSearch* s, int weight, uint32_t incumbent,
+                                     bool reset, const bool diagonal) {
+  Maze* maze = s->maze;
+  int width = maze->width;
+  int start_idx = 0;
+  int finish_idx = IDX(width - 1, maze->height - 1, width);
+  int goal_x = width - 1;
+  int goal_y = maze->height - 1;
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  int current_idx, neighbor_idx;
+  int x, y, nx, ny, i;
+  uint32_t tentative_g, h;
+
+  if (reset) {
+    memset(s->state, 0, (size_t)width * maze->height);
+  }
+  s->open_set->size = 0;
+
+  s->g[start_idx] = 0;
+  s->state[start_idx] = DIR_START;
+  if (!pq_push(s->open_set, start_idx,
+               anytime_key(0, anytime_estimate(0, 0, goal_x, goal_y, diagonal), weight))) {
+    return RUN_NOMEM;
+  }
+
+  while (pq_pop(s->open_set, &current_idx)) {
+    if (should_stop(s)) {
+      return RUN_STOPPED;
+    }
+
+    // skip if already processed (no reopening: the bound holds without)
+    if (s->state[current_idx] & CLOSED_BIT) {
+      continue;
+    }
+    s->state[current_idx] |= CLOSED_BIT;
+    s->expanded++;
+
+    if (current_idx == finish_idx) {
+      return RUN_FOUND;
+    }
+
+    x = current_idx % width;
+    y = current_idx / width;
+
+    for (i = 0; i < n_dirs; i++) {
+      nx = x + dir_dx[i];
+      ny = y + dir_dy[i];
+
+      if (!IS_VALID_POS(nx, ny, width, maze->height)) {
+        continue;
+      }
+
+      neighbor_idx = IDX(nx, ny, width);
+
+      if (s->state[neighbor_idx] & CLOSED_BIT) {
+        continue;
+      }
+
+      if (!IS_PASSABLE(maze->grid[neighbor_idx])) {
+        continue;
+      }
+
+      if (diagonal && i >= DIRS_ORTHOGONAL && !(is_open(maze, nx, y) && is_open(maze, x, ny))) {
+        continue;
+      }
+
+      tentative_g = s->g[current_idx] + CELL_COST(maze->grid[neighbor_idx])
+                  * (diagonal ? (i < DIRS_ORTHOGONAL ? COST_STRAIGHT : COST_DIAGONAL) : 1);
+      h = anytime_estimate(nx, ny, goal_x, goal_y, diagonal);
+
+      // cannot beat the best path so far
+      if ((unsigned long long)tentative_g + h >= incumbent) {
+        continue;
+      }
+
+      if (s->state[neighbor_idx] == DIR_NONE || tentative_g < s->g[neighbor_idx]) {
+        s->state[neighbor_idx] = i + 1;
+        s->g[neighbor_idx] = tentative_g;
+        if (!pq_push(s->open_set, neighbor_idx, anytime_key(tentative_g, h, weight))) {
+          return RUN_NOMEM;
+        }
+      }
+    }
+  }
+
+  return RUN_EXHAUSTED;
+}
+
+// store the path in maze->path by walking parent directions back from
+// finish, returns its length (-1 if out of memory)
+static int reconstruct_path_anytime(Maze* maze, const unsigned char* state, int start_idx,
+                                    int finish_idx) {
+  int current;
+  int path_length = 1;  // count start
+  int* path;
+  int i, d;
+
+  // count cells back from finish
+  for (current = finish_idx; current != start_idx; path_length++) {
+    d = (state[current] & DIR_MASK) - 1;
+    current -= IDX(dir_dx[d], dir_dy[d], maze->width);
+  }
+  path = path_reserve(maze, path_length);
+  if (!path) {
+    return -1;
+  }
+
+  // fill from the end
+  current = finish_idx;
+  for (i = path_length - 1; i > 0; i--) {
+    path[i] = current;
+    d = (state[current] & DIR_MASK) - 1;
+    current -= IDX(dir_dx[d], dir_dy[d], maze->width);
+  }
+  path[0] = start_idx;
+
+  return path_length;
+}
+
+// weight schedule driver, specialized like the A* kernel
+ALWAYS_INLINE MazeStatus anytime_kernel(Maze* maze, const SolverOptions* opts, SolverStats* stats,
+                                        const bool with_stats, const bool diagonal) {
+  AnytimeSearch search;
+  Arena arena;
+  size_t cells_n = (size_t)maze->width * maze->height;
+  int start_idx = 0;
+  int finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
+  uint32_t best = UINT32_MAX;
+  uint32_t h_start;
+  double bound = 0.0;
+  int path_length = 0;
+  RunResult result = RUN_EXHAUSTED;
+  MazeStatus status;
+  clock_t start_time = 0;
+  size_t i;
+
+  if (with_stats) {
+    // initialize stats
+    stats->algorithm = "Anytime A*";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
+  }
+
+  search.maze = maze;
+  search.cancel = CANCEL_FLAG(opts);
+  search.deadline = opts && opts->timeout_ms ? now_ms() + opts->timeout_ms : 0;
+  search.cancelled = false;
+  search.polls = 0;
+  search.expanded = 0;
+
+  // labeled apart: no path, answer without searching
+  if (!same_component(maze, start_idx, finish_idx)) {
+    if (with_stats) {
+      stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+    }
+    return MAZE_NO_PATH;
+  }
+
+  // cell state in one arena, reset before every run
+  if (!arena_init(&arena, ARENA_SIZE(cells_n * (sizeof(uint32_t) + sizeof(unsigned char)), 2),
+                  &maze->alloc, opts && opts->huge_pages)) {
+    return MAZE_ERR_NOMEM;
+  }
+  search.g = arena_push(&arena, cells_n * sizeof(uint32_t));
+  search.state = arena_push_zero(&arena, cells_n * sizeof(unsigned char));
+
+  search.open_set = create_pq(maze->width + maze->height, &maze->alloc);
+  if (!search.open_set) {
+    arena_release(&arena);
+    return MAZE_ERR_NOMEM;
+  }
+
+  h_start = anytime_estimate(0, 0, maze->width - 1, maze->height - 1, diagonal);
+
+  // until plain A* ran or the bound says the path is optimal already
+  for (i = 0; i < sizeof(weights) / sizeof(weights[0]) && bound != 1.0; i++) {
+    result = weighted_run(&search, weights[i], best, i > 0, diagonal);
+    if (result == RUN_FOUND) {
+      best = search.g[finish_idx];
+      path_length = reconstruct_path_anytime(maze, search.state, start_idx, finish_idx);
+      if (path_length < 0) {
+        result = RUN_NOMEM;
+        break;
+      }
+      // cost <= w * optimal, and h(start) <= optimal
+      bound = (double)weights[i] / WEIGHT_SCALE;
+      if (h_start > 0 && (double)best / h_start < bound) {
+        bound = (double)best / h_start;
+      }
+    } else if (result == RUN_EXHAUSTED) {
+      if (best == UINT32_MAX) {
+        break;  // nothing to improve on and still no path: unreachable
+      }
+      if (weights[i] == WEIGHT_SCALE) {
+        bound = 1.0;  // plain A* found nothing cheaper
+      }
+    } else {
+      break;  // stopped or out of memory
+    }
+  }
+
+  if (result == RUN_NOMEM) {
+    path_clear(maze);
+    status = MAZE_ERR_NOMEM;
+  } else if (best != UINT32_MAX) {
+    status = MAZE_OK;
+  } else if (result == RUN_STOPPED) {
+    status = search.cancelled ? MAZE_CANCELLED : MAZE_TIMEOUT;
+  } else {
+    status = MAZE_NO_PATH;
+  }
+
+  if (with_stats) {
+    if (status == MAZE_OK) {
+      stats->path_length = maze->path_length;
+      stats->path_cost = (double)best / (diagonal ? COST_STRAIGHT : 1);
+      stats->bound = bound;
+    }
+    stats->cells_visited = search.expanded;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+
+  // cleanup
+  arena_release(&arena);
+  free_pq(search.open_set);
+
+  return status;
+}
+
+// anytime weighted A*
+MazeStatus solve_anytime(Maze* maze, const SolverOptions* opts) {
+  // validate input
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
+  }
+  if (opts && opts->diagonal) {
+    return anytime_kernel(maze, opts, NULL, false, true);
+  }
+  return anytime_kernel(maze, opts, NULL, false, false);
+}
+
+// anytime weighted A* with statistics
+MazeStatus solve_anytime_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  // validate input
+  if (!maze || !maze->grid || !stats) {
+    return MAZE_ERR_ARG;
+  }
+  if (opts && opts->diagonal) {
+    return anytime_kernel(maze, opts, stats, true, true);
+  }
+  return anytime_kernel(maze, opts, stats, true, false);
+}
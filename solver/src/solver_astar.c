@@ -1,53 +1,100 @@
 #include "solver.h"
-#include "priority_queue.h"
+#include "radix_heap.h"
+#include "arena.h"
+#include "movement.h"
+#include "landmarks.h"
+#include "targets.h"
+#include "trace.h"
 #include <string.h>
-#include <limits.h>
-
-// Manhattan distance heuristic
+#include <stdint.h>
+
+// parent direction values (0 = not reached yet)
+#define DIR_NONE  0
+#define DIR_START 15
+
+// state byte layout: low nibble = parent direction, then closed flag
+#define DIR_MASK    0x0F
+#define CLOSED_BIT  0x10
+
+// Per-cell search state, split hot/cold: g is a plain 32-bit array
+// (terrain weights and diagonal step costs need more than the 27 bits
+// a packed record left), and a single byte holds the direction we
+// arrived through and the closed flag. f is never stored, it only
+// lives in the open set.
+typedef struct {
+  uint32_t* g;           // cost from start (valid once reached)
+  unsigned char* state;  // parent direction | CLOSED_BIT
+} SearchCells;
+
+// Manhattan distance heuristic (admissible: every step costs at least 1)
 static int heuristic(int x, int y, int goal_x, int goal_y) {
-  int dx = (x > goal_x) ? (x - goal_x) : (goal_x - x);
-  int dy = (y > goal_y) ? (y - goal_y) : (goal_y - y);
-  return dx + dy;
+  int dist_x = (x > goal_x) ? (x - goal_x) : (goal_x - x);
+  int dist_y = (y > goal_y) ? (y - goal_y) : (goal_y - y);
+  return dist_x + dist_y;
 }
 
-// reconstruct path from parent array and return path length
-static int reconstruct_path_astar(Maze* maze, const int* parent, int start_idx, int finish_idx) {
-  int current = finish_idx;
-  int path_length = 0;
+// heuristic for the movement mode: octile distance when moving diagonally
+ALWAYS_INLINE int estimate(int x, int y, int goal_x, int goal_y, const bool diagonal) {
+  return diagonal ? octile_distance(x, y, goal_x, goal_y) : heuristic(x, y, goal_x, goal_y);
+}
 
-  while (current != start_idx) {
-    if (current != start_idx && current != finish_idx) {
-      maze->grid[current] = 'o';
-    }
-    path_length++;
-    current = parent[current];
-  }
-  maze->grid[start_idx] = 'o';
-  maze->grid[finish_idx] = 'o';
-  path_length++;  // count start
+// ALT: the tighter of the geometric and the landmark bound (both are
+// consistent, so their max is too and keys stay monotone)
+ALWAYS_INLINE uint32_t alt_estimate(const Landmarks* lm, const uint32_t* goal_dist, int cell,
+                                    int x, int y, int goal_x, int goal_y, const bool diagonal) {
+  uint32_t geometric = (uint32_t)estimate(x, y, goal_x, goal_y, diagonal);
+  uint32_t landmark = landmark_bound(lm, goal_dist, cell);
 
-  return path_length;
+  return landmark > geometric ? landmark : geometric;
 }
 
-// count cells in closed set
-static int count_closed(const bool* in_closed, int size) {
-  int count = 0;
-  int i;
-  for (i = 0; i < size; i++) {
-    if (in_closed[i]) {
-      count++;
-    }
+// store the path in maze->path by walking parent directions back from
+// finish, returns its length (-1 if out of memory)
+static int reconstruct_path_astar(Maze* maze, const SearchCells* cells, int start_idx, int finish_idx) {
+  int current;
+  int path_length = 1;  // count start
+  int* path;
+  int i, d;
+
+  // count cells back from finish
+  for (current = finish_idx; current != start_idx; path_length++) {
+    d = (cells->state[current] & DIR_MASK) - 1;
+    current -= IDX(dir_dx[d], dir_dy[d], maze->width);
+  }
+  path = path_reserve(maze, path_length);
+  if (!path) {
+    return -1;
   }
-  return count;
+
+  // fill from the end
+  current = finish_idx;
+  for (i = path_length - 1; i > 0; i--) {
+    path[i] = current;
+    d = (cells->state[current] & DIR_MASK) - 1;
+    current -= IDX(dir_dx[d], dir_dy[d], maze->width);
+  }
+  path[0] = start_idx;
+
+  return path_length;
 }
 
-// A* - main algo
-bool solve_astar(Maze* maze) {
-  int* g_score;        // cost from start to current
-  int* f_score;        // estimated total cost (g + h)
-  int* parent;
-  bool* in_closed;
-  PriorityQueue* open_set;
+// best-first kernel, specialized at compile time:
+// - with_stats: the plain build carries no counter or timer code at all
+// - use_heuristic: A* (Manhattan or octile distance), or Dijkstra (h = 0)
+// - use_landmarks: A* raised to the ALT bound of maze->landmarks
+// - diagonal: 8-directional movement, steps cost COST_STRAIGHT/COST_DIAGONAL
+// - multi: stop at the cheapest of maze->targets, h = distance to the
+//   nearest exit (never combined with landmarks)
+// The stats build also logs each expansion to opts->trace when one is set.
+// All variants pop monotone keys, so the open set is a radix heap.
+ALWAYS_INLINE MazeStatus astar_kernel(Maze* maze, const SolverOptions* opts, SolverStats* stats,
+                                      const bool with_stats, const bool use_heuristic,
+                                      const bool use_landmarks, const bool diagonal,
+                                      const bool multi) {
+  SearchCells cells;
+  const Landmarks* lm = maze->landmarks;
+  uint32_t goal_dist[LANDMARKS_MAX];
+  RadixHeap* open_set;
   int start_idx;
   int finish_idx;
   int current_idx;
@@ -57,95 +104,120 @@ bool solve_astar(Maze* maze) {
   int goal_x, goal_y;
   int i;
   bool found;
-  int tentative_g;
-
-  int dx[] = {0, 0, -1, 1};
-  int dy[] = {-1, 1, 0, 0};
-
-  // validate input
-  if (!maze || !maze->grid) {
-    fprintf(stderr, "Error: invalid maze in solve_astar\n");
-    return false;
+  bool cancelled = false;
+  bool nomem = false;
+  const atomic_bool* cancel = CANCEL_FLAG(opts);
+  unsigned polls = 0;
+  int path_length;
+  MazeStatus status;
+  uint32_t tentative_g;
+  size_t cells_n = (size_t)maze->width * maze->height;
+  Arena arena;
+  int cells_visited = 0;
+  clock_t start_time = 0;
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  MazeTrace* trace = with_stats && opts ? opts->trace : NULL;
+  unsigned int key;
+  unsigned int f;
+
+  if (with_stats) {
+    // initialize stats
+    stats->algorithm = use_landmarks ? "A* (ALT)" : use_heuristic ? "A*" : "Dijkstra";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
   }
 
   // calculate start and finish
   start_idx = IDX(0, 0, maze->width);
   finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
 
-  goal_x = maze->width - 1;
-  goal_y = maze->height - 1;
-
-  // allocate arrays
-  g_score = malloc(maze->width * maze->height * sizeof(int));
-  if (!g_score) {
-    fprintf(stderr, "Error: failed to allocate g_score array\n");
-    return false;
+  // labeled apart: no path, answer without searching
+  if (multi) {
+    maze->targets->reached = -1;
+  } else if (!same_component(maze, start_idx, finish_idx)) {
+    if (with_stats) {
+      stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+    }
+    return MAZE_NO_PATH;
   }
 
-  f_score = malloc(maze->width * maze->height * sizeof(int));
-  if (!f_score) {
-    fprintf(stderr, "Error: failed to allocate f_score array\n");
-    free(g_score);
-    return false;
-  }
+  goal_x = maze->width - 1;
+  goal_y = maze->height - 1;
 
-  parent = malloc(maze->width * maze->height * sizeof(int));
-  if (!parent) {
-    fprintf(stderr, "Error: failed to allocate parent array\n");
-    free(g_score);
-    free(f_score);
-    return false;
+  // landmark distances to the goal, fixed for the whole search
+  if (use_landmarks) {
+    for (i = 0; i < lm->count; i++) {
+      goal_dist[i] = lm->dist[(size_t)finish_idx * lm->count + i];
+    }
   }
 
-  in_closed = calloc(maze->width * maze->height, sizeof(bool));
-  if (!in_closed) {
-    fprintf(stderr, "Error: failed to allocate closed set\n");
-    free(g_score);
-    free(f_score);
-    free(parent);
-    return false;
+  // allocate cell state in one arena, zeroed = unreached and open
+  if (!arena_init(&arena, ARENA_SIZE(cells_n * (sizeof(uint32_t) + sizeof(unsigned char)), 2),
+                  &maze->alloc, opts && opts->huge_pages)) {
+    return MAZE_ERR_NOMEM;
   }
+  cells.g = arena_push(&arena, cells_n * sizeof(uint32_t));
+  cells.state = arena_push_zero(&arena, cells_n * sizeof(unsigned char));
 
-  // initialize scores
-  for (i = 0; i < maze->width * maze->height; i++) {
-    g_score[i] = INT_MAX;
-    f_score[i] = INT_MAX;
-    parent[i] = -1;
+  // create open set (grows on demand, so it lives outside the arena)
+  open_set = create_radix_heap(maze->width + maze->height, &maze->alloc);
+  if (!open_set) {
+    arena_release(&arena);
+    return MAZE_ERR_NOMEM;
   }
 
-  // create priority queue
-  open_set = create_pq(maze->width * maze->height);
-  if (!open_set) {
-    fprintf(stderr, "Error: failed to create priority queue\n");
-    free(g_score);
-    free(f_score);
-    free(parent);
-    free(in_closed);
-    return false;
+  if (with_stats && trace) {
+    trace_begin(trace, maze, use_heuristic ? TRACE_ASTAR : TRACE_DIJKSTRA,
+                (diagonal ? TRACE_DIAGONAL : 0) | (multi ? TRACE_MULTI : 0)
+                | (use_landmarks ? TRACE_LANDMARKS : 0));
   }
 
   // initialize start
-  g_score[start_idx] = 0;
-  f_score[start_idx] = heuristic(0, 0, goal_x, goal_y);
-  pq_push(open_set, start_idx, f_score[start_idx]);
+  cells.g[start_idx] = 0;
+  cells.state[start_idx] = DIR_START;
+  if (use_landmarks) {
+    f = alt_estimate(lm, goal_dist, start_idx, 0, 0, goal_x, goal_y, diagonal);
+  } else if (multi) {
+    f = use_heuristic ? nearest_target(maze->targets, 0, 0, diagonal) : 0;
+  } else {
+    f = use_heuristic ? estimate(0, 0, goal_x, goal_y, diagonal) : 0;
+  }
+  nomem = !rh_push(open_set, start_idx, f);
 
-  // A* main loop
+  // main loop
   found = false;
 
-  while (!pq_is_empty(open_set)) {
-    if (!pq_pop(open_set, &current_idx)) {
+  while (!nomem && !rh_is_empty(open_set)) {
+    if (!rh_pop(open_set, &current_idx, with_stats ? &key : NULL)) {
+      nomem = true;
+      break;
+    }
+    if (poll_cancel(cancel, &polls)) {
+      cancelled = true;
       break;
     }
 
     // skip if already processed
-    if (in_closed[current_idx]) {
+    if (cells.state[current_idx] & CLOSED_BIT) {
       continue;
     }
 
-    in_closed[current_idx] = true;
+    cells.state[current_idx] |= CLOSED_BIT;
+    if (with_stats) {
+      cells_visited++;
+    }
+    if (with_stats && trace) {
+      trace_step(trace, current_idx, cells.g[current_idx], key, (uint32_t)open_set->size);
+    }
 
     // found finish?
-    if (current_idx == finish_idx) {
+    if (multi ? is_target(maze->targets, current_idx) : current_idx == finish_idx) {
+      finish_idx = current_idx;
       found = true;
       break;
     }
@@ -154,9 +226,9 @@ bool solve_astar(Maze* maze) {
     y = current_idx / maze->width;
 
     // check all neighbors
-    for (i = 0; i < 4; i++) {
-      nx = x + dx[i];
-      ny = y + dy[i];
+    for (i = 0; i < n_dirs; i++) {
+      nx = x + dir_dx[i];
+      ny = y + dir_dy[i];
 
       if (!IS_VALID_POS(nx, ny, maze->width, maze->height)) {
         continue;
@@ -164,208 +236,157 @@ bool solve_astar(Maze* maze) {
 
       neighbor_idx = IDX(nx, ny, maze->width);
 
-      if (in_closed[neighbor_idx]) {
+      if (cells.state[neighbor_idx] & CLOSED_BIT) {
         continue;
       }
 
-      if (maze->grid[neighbor_idx] != '*') {
+      if (!IS_PASSABLE(maze->grid[neighbor_idx])) {
         continue;
       }
 
-      tentative_g = g_score[current_idx] + 1;
+      if (diagonal && i >= DIRS_ORTHOGONAL && !(is_open(maze, nx, y) && is_open(maze, x, ny))) {
+        continue;
+      }
 
-      if (tentative_g < g_score[neighbor_idx]) {
-        parent[neighbor_idx] = current_idx;
-        g_score[neighbor_idx] = tentative_g;
-        f_score[neighbor_idx] = tentative_g + heuristic(nx, ny, goal_x, goal_y);
-        pq_push(open_set, neighbor_idx, f_score[neighbor_idx]);
+      tentative_g = cells.g[current_idx] + CELL_COST(maze->grid[neighbor_idx])
+                  * (diagonal ? (i < DIRS_ORTHOGONAL ? COST_STRAIGHT : COST_DIAGONAL) : 1);
+
+      if (cells.state[neighbor_idx] == DIR_NONE || tentative_g < cells.g[neighbor_idx]) {
+        cells.state[neighbor_idx] = i + 1;
+        cells.g[neighbor_idx] = tentative_g;
+        if (use_landmarks) {
+          f = tentative_g + alt_estimate(lm, goal_dist, neighbor_idx, nx, ny, goal_x, goal_y,
+                                         diagonal);
+        } else if (multi) {
+          f = use_heuristic ? tentative_g + nearest_target(maze->targets, nx, ny, diagonal)
+                            : tentative_g;
+        } else {
+          f = use_heuristic ? tentative_g + estimate(nx, ny, goal_x, goal_y, diagonal) : tentative_g;
+        }
+        if (!rh_push(open_set, neighbor_idx, f)) {
+          nomem = true;
+          break;
+        }
       }
     }
   }
 
-  // reconstruct path if found
+  // reconstruct path if found (a dropped node would make any answer wrong)
+  status = nomem ? MAZE_ERR_NOMEM : cancelled ? MAZE_CANCELLED : MAZE_NO_PATH;
   if (found) {
-    reconstruct_path_astar(maze, parent, start_idx, finish_idx);
+    path_length = reconstruct_path_astar(maze, &cells, start_idx, finish_idx);
+    status = path_length < 0 ? MAZE_ERR_NOMEM : MAZE_OK;
+    if (with_stats && path_length > 0) {
+      stats->path_cost = (double)cells.g[finish_idx] / (diagonal ? COST_STRAIGHT : 1);
+      stats->path_length = path_length;
+    }
+    if (multi) {
+      maze->targets->reached = finish_idx;
+    }
+  }
+
+  if (with_stats) {
+    stats->cells_visited = cells_visited;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+  if (with_stats && trace) {
+    trace_end(trace, status);
   }
 
   // cleanup
-  free(g_score);
-  free(f_score);
-  free(parent);
-  free(in_closed);
-  free_pq(open_set);
+  arena_release(&arena);
+  free_radix_heap(open_set);
 
-  return found;
+  return status;
 }
 
-// A* with statistics
-bool solve_astar_stats(Maze* maze, SolverStats* stats) {
-  int* g_score;
-  int* f_score;
-  int* parent;
-  bool* in_closed;
-  PriorityQueue* open_set;
-  int start_idx;
-  int finish_idx;
-  int current_idx;
-  int neighbor_idx;
-  int x, y;
-  int nx, ny;
-  int goal_x, goal_y;
-  int i;
-  bool found;
-  int tentative_g;
-  clock_t start_time, end_time;
-
-  int dx[] = {0, 0, -1, 1};
-  int dy[] = {-1, 1, 0, 0};
+// A* - main algo (ALT when landmarks were built for this movement mode,
+// nearest-exit heuristic in multi-target mode)
+MazeStatus solve_astar(Maze* maze, const SolverOptions* opts) {
+  bool diagonal = opts && opts->diagonal;
+  SolverStats stats;
 
   // validate input
-  if (!maze || !maze->grid || !stats) {
-    fprintf(stderr, "Error: invalid input in solve_astar_stats\n");
-    return false;
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
   }
-
-  // initialize stats
-  stats->algorithm = "A*";
-  stats->cells_visited = 0;
-  stats->path_length = 0;
-  stats->time_ms = 0.0;
-
-  start_time = clock();
-
-  // calculate start and finish
-  start_idx = IDX(0, 0, maze->width);
-  finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
-
-  goal_x = maze->width - 1;
-  goal_y = maze->height - 1;
-
-  // allocate arrays
-  g_score = malloc(maze->width * maze->height * sizeof(int));
-  if (!g_score) {
-    fprintf(stderr, "Error: failed to allocate g_score array\n");
-    return false;
+  // only the stats build traces, the plain one stays as it was
+  if (opts && opts->trace) {
+    return solve_astar_stats(maze, opts, &stats);
   }
-
-  f_score = malloc(maze->width * maze->height * sizeof(int));
-  if (!f_score) {
-    fprintf(stderr, "Error: failed to allocate f_score array\n");
-    free(g_score);
-    return false;
+  if (maze->targets) {
+    return diagonal ? astar_kernel(maze, opts, NULL, false, true, false, true, true)
+                    : astar_kernel(maze, opts, NULL, false, true, false, false, true);
   }
-
-  parent = malloc(maze->width * maze->height * sizeof(int));
-  if (!parent) {
-    fprintf(stderr, "Error: failed to allocate parent array\n");
-    free(g_score);
-    free(f_score);
-    return false;
+  if (landmarks_match(maze, diagonal)) {
+    return diagonal ? astar_kernel(maze, opts, NULL, false, true, true, true, false)
+                    : astar_kernel(maze, opts, NULL, false, true, true, false, false);
   }
-
-  in_closed = calloc(maze->width * maze->height, sizeof(bool));
-  if (!in_closed) {
-    fprintf(stderr, "Error: failed to allocate closed set\n");
-    free(g_score);
-    free(f_score);
-    free(parent);
-    return false;
+  if (diagonal) {
+    return astar_kernel(maze, opts, NULL, false, true, false, true, false);
   }
+  return astar_kernel(maze, opts, NULL, false, true, false, false, false);
+}
 
-  // initialize scores
-  for (i = 0; i < maze->width * maze->height; i++) {
-    g_score[i] = INT_MAX;
-    f_score[i] = INT_MAX;
-    parent[i] = -1;
-  }
+// A* with statistics
+MazeStatus solve_astar_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  bool diagonal = opts && opts->diagonal;
 
-  // create priority queue
-  open_set = create_pq(maze->width * maze->height);
-  if (!open_set) {
-    fprintf(stderr, "Error: failed to create priority queue\n");
-    free(g_score);
-    free(f_score);
-    free(parent);
-    free(in_closed);
-    return false;
+  // validate input
+  if (!maze || !maze->grid || !stats) {
+    return MAZE_ERR_ARG;
   }
-
-  // initialize start
-  g_score[start_idx] = 0;
-  f_score[start_idx] = heuristic(0, 0, goal_x, goal_y);
-  pq_push(open_set, start_idx, f_score[start_idx]);
-
-  // A* main loop
-  found = false;
-
-  while (!pq_is_empty(open_set)) {
-    if (!pq_pop(open_set, &current_idx)) {
-      break;
-    }
-
-    // skip if already processed
-    if (in_closed[current_idx]) {
-      continue;
-    }
-
-    in_closed[current_idx] = true;
-
-    // found finish?
-    if (current_idx == finish_idx) {
-      found = true;
-      break;
-    }
-
-    x = current_idx % maze->width;
-    y = current_idx / maze->width;
-
-    // check all neighbors
-    for (i = 0; i < 4; i++) {
-      nx = x + dx[i];
-      ny = y + dy[i];
-
-      if (!IS_VALID_POS(nx, ny, maze->width, maze->height)) {
-        continue;
-      }
-
-      neighbor_idx = IDX(nx, ny, maze->width);
-
-      if (in_closed[neighbor_idx]) {
-        continue;
-      }
-
-      if (maze->grid[neighbor_idx] != '*') {
-        continue;
-      }
-
-      tentative_g = g_score[current_idx] + 1;
-
-      if (tentative_g < g_score[neighbor_idx]) {
-        parent[neighbor_idx] = current_idx;
-        g_score[neighbor_idx] = tentative_g;
-        f_score[neighbor_idx] = tentative_g + heuristic(nx, ny, goal_x, goal_y);
-        pq_push(open_set, neighbor_idx, f_score[neighbor_idx]);
-      }
-    }
+  if (maze->targets) {
+    return diagonal ? astar_kernel(maze, opts, stats, true, true, false, true, true)
+                    : astar_kernel(maze, opts, stats, true, true, false, false, true);
+  }
+  if (landmarks_match(maze, diagonal)) {
+    return diagonal ? astar_kernel(maze, opts, stats, true, true, true, true, false)
+                    : astar_kernel(maze, opts, stats, true, true, true, false, false);
+  }
+  if (diagonal) {
+    return astar_kernel(maze, opts, stats, true, true, false, true, false);
   }
+  return astar_kernel(maze, opts, stats, true, true, false, false, false);
+}
 
-  // collect statistics
-  stats->cells_visited = count_closed(in_closed, maze->width * maze->height);
+// Dijkstra - A* kernel without heuristic
+MazeStatus solve_dijkstra(Maze* maze, const SolverOptions* opts) {
+  bool diagonal = opts && opts->diagonal;
+  SolverStats stats;
 
-  // reconstruct path if found
-  if (found) {
-    stats->path_length = reconstruct_path_astar(maze, parent, start_idx, finish_idx);
+  // validate input
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
   }
+  // only the stats build traces, the plain one stays as it was
+  if (opts && opts->trace) {
+    return solve_dijkstra_stats(maze, opts, &stats);
+  }
+  if (maze->targets) {
+    return diagonal ? astar_kernel(maze, opts, NULL, false, false, false, true, true)
+                    : astar_kernel(maze, opts, NULL, false, false, false, false, true);
+  }
+  if (diagonal) {
+    return astar_kernel(maze, opts, NULL, false, false, false, true, false);
+  }
+  return astar_kernel(maze, opts, NULL, false, false, false, false, false);
+}
 
-  end_time = clock();
-  stats->time_ms = ((double)(end_time - start_time)) / CLOCKS_PER_SEC * 1000.0;
-
-  // cleanup
-  free(g_score);
-  free(f_score);
-  free(parent);
-  free(in_closed);
-  free_pq(open_set);
+// Dijkstra with statistics
+MazeStatus solve_dijkstra_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  bool diagonal = opts && opts->diagonal;
 
-  return found;
+  // validate input
+  if (!maze || !maze->grid || !stats) {
+    return MAZE_ERR_ARG;
+  }
+  if (maze->targets) {
+    return diagonal ? astar_kernel(maze, opts, stats, true, false, false, true, true)
+                    : astar_kernel(maze, opts, stats, true, false, false, false, true);
+  }
+  if (diagonal) {
+    return astar_kernel(maze, opts, stats, true, false, false, true, false);
+  }
+  return astar_kernel(maze, opts, stats, true, false, false, false, false);
 }
@@ -1,268 +1,404 @@
 #include "solver.h"
 #include "queue.h"
+#include "arena.h"
+#include "movement.h"
+#include "targets.h"
+#include "trace.h"
 #include <string.h>
 
-// reconstruct path from parent array and return path length
-static int reconstruct_path(Maze* maze, const int* parent, int start_idx, int finish_idx) {
+// store the path from parent array in maze->path, returns its length
+// (-1 if out of memory); terrain cost of the path is summed into
+// path_cost when given, diagonal steps cost COST_DIAGONAL / COST_STRAIGHT
+static int reconstruct_path(Maze* maze, const int* parent, int start_idx, int finish_idx,
+                            double* path_cost) {
   int current;
-  int path_length = 0;
+  int path_length = 1;  // count start
+  int* path;
+  int i;
+  bool diagonal_step;
+
+  // count cells back from finish
+  for (current = finish_idx; current != start_idx; current = parent[current]) {
+    path_length++;
+  }
+  path = path_reserve(maze, path_length);
+  if (!path) {
+    return -1;
+  }
 
-  // start from finish
+  // fill from the end
   current = finish_idx;
+  i = path_length;
 
   while (current != start_idx) {
-    if (current != start_idx && current != finish_idx) {
-      maze->grid[current] = 'o';
+    if (path_cost) {
+      diagonal_step = current % maze->width != parent[current] % maze->width
+                   && current / maze->width != parent[current] / maze->width;
+      *path_cost += CELL_COST(maze->grid[current])
+                  * (diagonal_step ? (double)COST_DIAGONAL / COST_STRAIGHT : 1.0);
     }
-    path_length++;
+    path[--i] = current;
     current = parent[current];
   }
-  maze->grid[start_idx] = 'o';
-  maze->grid[finish_idx] = 'o';
-  path_length++;  // count start
+  path[0] = start_idx;
 
   return path_length;
 }
 
-// count visited cells
-static int count_visited(const bool* visited, int size) {
-  int count = 0;
+// bfs kernel from start_idx to finish_idx, specialized at compile time:
+// - with_stats: the plain build carries no counter or timer code at all
+// - diagonal: 8-directional movement without corner cutting
+// - multi: stop at the first of maze->targets reached instead of finish_idx
+// The stats build also logs each dequeue to opts->trace when one is set.
+// Terrain weights are ignored: bfs finds the path with fewest cells.
+ALWAYS_INLINE MazeStatus bfs_kernel(Maze* maze, const SolverOptions* opts, SolverStats* stats,
+                                    int start_idx, int finish_idx, const bool with_stats,
+                                    const bool diagonal, const bool multi) {
+  bool* visited;
+  int* parent;
+  Queue* queue;
+  int current_idx;
+  int neighbor_idx;
+  int x, y;
+  int nx, ny;
   int i;
-  for (i = 0; i < size; i++) {
-    if (visited[i]) {
-      count++;
-    }
+  bool found;
+  bool cancelled = false;
+  const atomic_bool* cancel = CANCEL_FLAG(opts);
+  unsigned polls = 0;
+  int path_length;
+  MazeStatus status;
+  size_t cells = (size_t)maze->width * maze->height;
+  Arena arena;
+  MazeAllocator scratch;
+  int cells_visited = 0;
+  clock_t start_time = 0;
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  MazeTrace* trace = with_stats && opts ? opts->trace : NULL;
+  int expanded = 0;
+  int level = 0;
+  int level_end = 1;  // dequeues before the next level starts
+
+  if (with_stats) {
+    // initialize stats
+    stats->algorithm = "BFS";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
   }
-  return count;
-}
 
-// bfs - main algo
-bool solve_bfs(Maze* maze) {
-  bool* visited;      
-  int* parent;        
-  Queue* queue;       
-  int start_idx;      
-  int finish_idx;     
-  int current_idx;    
-  int neighbor_idx;   
-  int x, y;           
-  int nx, ny;         
-  int i;              
-  bool found;      
-  
-  int dx[] = {0, 0, -1, 1};
-  int dy[] = {-1, 1, 0, 0};
-  
-  // validate input
-  if (!maze || !maze->grid) {
-    fprintf(stderr, "Error: invalid maze in solve_bfs\n");
-    return false;
-  }
-  
-  // calculate start and finish idx
-  start_idx = IDX(0, 0, maze->width);
-  finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
-  
-  // allocate aux arr
-  visited = calloc(maze->width * maze->height, sizeof(bool));
-  if (!visited) {
-    fprintf(stderr, "Error: failed to allocate visited array\n");
-    return false;
+  // labeled apart: no path, answer without searching
+  if (multi) {
+    maze->targets->reached = -1;
+  } else if (!same_component(maze, start_idx, finish_idx)) {
+    if (with_stats) {
+      stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+    }
+    return MAZE_NO_PATH;
   }
 
-  parent = malloc(maze->width * maze->height * sizeof(int));
-  if (!parent) {
-    fprintf(stderr, "Error: failed to allocate parent array\n");
-    free(visited);
-    return false;
+  // allocate aux arr: visited, parent and the queue share one arena
+  if (!arena_init(&arena, ARENA_SIZE(cells * (sizeof(bool) + 2 * sizeof(int)) + sizeof(Queue), 4),
+                  &maze->alloc, opts && opts->huge_pages)) {
+    return MAZE_ERR_NOMEM;
   }
+  scratch = arena_allocator(&arena);
+
+  visited = arena_push_zero(&arena, cells * sizeof(bool));
+  parent = arena_push(&arena, cells * sizeof(int));
 
   for (i = 0; i < maze->width * maze->height; i++) {
     parent[i] = -1;
   }
-  
-  // create queue
-  queue = create_queue(maze->width * maze->height);
+
+  // create queue: cells fits an int, both sides are capped at MAZE_MAX_SIZE
+  queue = create_queue((int)cells, &scratch);
   if (!queue) {
-    fprintf(stderr, "Error: failed to create queue\n");
-    free(visited);
-    free(parent);
-    return false;
+    arena_release(&arena);
+    return MAZE_ERR_NOMEM;
+  }
+
+  if (with_stats && trace) {
+    trace_begin(trace, maze, TRACE_BFS, (diagonal ? TRACE_DIAGONAL : 0) | (multi ? TRACE_MULTI : 0));
   }
-  
+
   // init bfs
   visited[start_idx] = true;
   enqueue(queue, start_idx);
-  
+  if (with_stats) {
+    cells_visited++;
+  }
+
   // bfs loop
   found = false;
-  
+
   while (!is_queue_empty(queue)) {
     if (!dequeue(queue, &current_idx)) {
-      break;  
+      break;
+    }
+    if (poll_cancel(cancel, &polls)) {
+      cancelled = true;
+      break;
+    }
+    // every cell of a level is queued once the level before is dequeued
+    if (with_stats && trace) {
+      if (expanded++ == level_end) {
+        level++;
+        level_end = cells_visited;
+      }
+      trace_step(trace, current_idx, (uint32_t)level, (uint32_t)level, (uint32_t)queue->size);
     }
-    
-    if (current_idx == finish_idx) {
+
+    if (multi ? is_target(maze->targets, current_idx) : current_idx == finish_idx) {
+      finish_idx = current_idx;
       found = true;
-      break;  
+      break;
     }
     x = current_idx % maze->width;
     y = current_idx / maze->width;
-    
-    for (i = 0; i < 4; i++) {
-      nx = x + dx[i];
-      ny = y + dy[i];
-      
+
+    for (i = 0; i < n_dirs; i++) {
+      nx = x + dir_dx[i];
+      ny = y + dir_dy[i];
+
       if (!IS_VALID_POS(nx, ny, maze->width, maze->height)) {
-          continue;  
+          continue;
       }
       neighbor_idx = IDX(nx, ny, maze->width);
-      
+
       if (visited[neighbor_idx]) {
-          continue;  
+          continue;
       }
-      
-      if (maze->grid[neighbor_idx] != '*') {
+
+      if (!IS_PASSABLE(maze->grid[neighbor_idx])) {
+          continue;
+      }
+
+      if (diagonal && i >= DIRS_ORTHOGONAL && !(is_open(maze, nx, y) && is_open(maze, x, ny))) {
           continue;
       }
       visited[neighbor_idx] = true;
       parent[neighbor_idx] = current_idx;
       enqueue(queue, neighbor_idx);
+      if (with_stats) {
+        cells_visited++;
+      }
     }
   }
 
   // results
+  status = cancelled ? MAZE_CANCELLED : MAZE_NO_PATH;
   if (found) {
-    reconstruct_path(maze, parent, start_idx, finish_idx);
+    path_length = reconstruct_path(maze, parent, start_idx, finish_idx,
+                                   with_stats ? &stats->path_cost : NULL);
+    status = path_length < 0 ? MAZE_ERR_NOMEM : MAZE_OK;
+    if (with_stats && path_length > 0) {
+      stats->path_length = path_length;
+    }
+    if (multi) {
+      maze->targets->reached = finish_idx;
+    }
   }
 
-  // cleanup
-  free(visited);
-  free(parent);
-  free_queue(queue);
-
-  return found;
-}
-
-// bfs with statistics
-bool solve_bfs_stats(Maze* maze, SolverStats* stats) {
-  bool* visited;
-  int* parent;
-  Queue* queue;
-  int start_idx;
-  int finish_idx;
-  int current_idx;
-  int neighbor_idx;
-  int x, y;
-  int nx, ny;
-  int i;
-  bool found;
-  clock_t start_time, end_time;
-
-  int dx[] = {0, 0, -1, 1};
-  int dy[] = {-1, 1, 0, 0};
-
-  // validate input
-  if (!maze || !maze->grid || !stats) {
-    fprintf(stderr, "Error: invalid input in solve_bfs_stats\n");
-    return false;
+  if (with_stats) {
+    stats->cells_visited = cells_visited;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+  if (with_stats && trace) {
+    trace_end(trace, status);
   }
 
-  // initialize stats
-  stats->algorithm = "BFS";
-  stats->cells_visited = 0;
-  stats->path_length = 0;
-  stats->time_ms = 0.0;
-
-  start_time = clock();
-
-  // calculate start and finish idx
-  start_idx = IDX(0, 0, maze->width);
-  finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
+  // cleanup
+  arena_release(&arena);
 
-  // allocate aux arr
-  visited = calloc(maze->width * maze->height, sizeof(bool));
-  if (!visited) {
-    fprintf(stderr, "Error: failed to allocate visited array\n");
-    return false;
-  }
+  return status;
+}
 
-  parent = malloc(maze->width * maze->height * sizeof(int));
-  if (!parent) {
-    fprintf(stderr, "Error: failed to allocate parent array\n");
-    free(visited);
-    return false;
+// Small mazes (up to SMALL_MAZE_MAX on both sides): the whole search
+// state fits on the stack, so a solve makes no allocation but the path.
+// Walls and visited marks are bitboards, one 64-bit word per row, built
+// with one pass over the grid, and the queue holds y * 64 + x so no
+// division by the width is left in the loop. Cells are dequeued and neighbors tried in
+// the same order as bfs_kernel, so the path and the counts are the same;
+// only the storage differs. Traced and multi-target solves keep
+// bfs_kernel.
+ALWAYS_INLINE MazeStatus small_bfs_kernel(Maze* maze, const SolverOptions* opts, SolverStats* stats,
+                                          int start_idx, int finish_idx, const bool with_stats,
+                                          const bool diagonal) {
+  uint64_t open[SMALL_MAZE_MAX];   // passable cells, bit x of word y
+  uint64_t seen[SMALL_MAZE_MAX];   // queued cells
+  int parent[SMALL_MAZE_MAX * SMALL_MAZE_MAX];
+  uint16_t queue[SMALL_MAZE_MAX * SMALL_MAZE_MAX];  // y << 6 | x
+  const int width = maze->width;
+  const int height = maze->height;
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  const atomic_bool* cancel = CANCEL_FLAG(opts);
+  const char* row;
+  unsigned polls = 0;
+  int head = 0;
+  int tail = 0;
+  int finish;
+  int current, x, y, nx, ny, i;
+  int path_length;
+  bool found = false;
+  bool cancelled = false;
+  MazeStatus status;
+  clock_t start_time = 0;
+
+  if (with_stats) {
+    stats->algorithm = "BFS";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
   }
 
-  for (i = 0; i < maze->width * maze->height; i++) {
-    parent[i] = -1;
+  if (!same_component(maze, start_idx, finish_idx)) {
+    if (with_stats) {
+      stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+    }
+    return MAZE_NO_PATH;
   }
 
-  // create queue
-  queue = create_queue(maze->width * maze->height);
-  if (!queue) {
-    fprintf(stderr, "Error: failed to create queue\n");
-    free(visited);
-    free(parent);
-    return false;
+  for (y = 0; y < height; y++) {
+    row = maze->grid + (size_t)y * width;
+    open[y] = 0;
+    seen[y] = 0;
+    for (x = 0; x < width; x++) {
+      open[y] |= (uint64_t)IS_PASSABLE(row[x]) << x;
+    }
   }
 
-  // init bfs
-  visited[start_idx] = true;
-  enqueue(queue, start_idx);
-
-  // bfs loop
-  found = false;
+  seen[start_idx / width] |= 1ULL << (start_idx % width);
+  queue[tail++] = (uint16_t)(start_idx / width << 6 | start_idx % width);
+  finish = finish_idx / width << 6 | finish_idx % width;
 
-  while (!is_queue_empty(queue)) {
-    if (!dequeue(queue, &current_idx)) {
+  while (head < tail) {
+    current = queue[head++];
+    if (poll_cancel(cancel, &polls)) {
+      cancelled = true;
       break;
     }
-
-    if (current_idx == finish_idx) {
+    if (current == finish) {
       found = true;
       break;
     }
-    x = current_idx % maze->width;
-    y = current_idx / maze->width;
+    x = current & (SMALL_MAZE_MAX - 1);
+    y = current >> 6;
 
-    for (i = 0; i < 4; i++) {
-      nx = x + dx[i];
-      ny = y + dy[i];
+    for (i = 0; i < n_dirs; i++) {
+      nx = x + dir_dx[i];
+      ny = y + dir_dy[i];
 
-      if (!IS_VALID_POS(nx, ny, maze->width, maze->height)) {
-          continue;
+      if (!IS_VALID_POS(nx, ny, width, height) || !((open[ny] & ~seen[ny]) >> nx & 1)) {
+        continue;
       }
-      neighbor_idx = IDX(nx, ny, maze->width);
-
-      if (visited[neighbor_idx]) {
-          continue;
+      if (diagonal && i >= DIRS_ORTHOGONAL && !((open[y] >> nx) & (open[ny] >> x) & 1)) {
+        continue;
       }
+      seen[ny] |= 1ULL << nx;
+      parent[IDX(nx, ny, width)] = IDX(x, y, width);
+      queue[tail++] = (uint16_t)(ny << 6 | nx);
+    }
+  }
 
-      if (maze->grid[neighbor_idx] != '*') {
-          continue;
-      }
-      visited[neighbor_idx] = true;
-      parent[neighbor_idx] = current_idx;
-      enqueue(queue, neighbor_idx);
+  status = cancelled ? MAZE_CANCELLED : MAZE_NO_PATH;
+  if (found) {
+    path_length = reconstruct_path(maze, parent, start_idx, finish_idx,
+                                   with_stats ? &stats->path_cost : NULL);
+    status = path_length < 0 ? MAZE_ERR_NOMEM : MAZE_OK;
+    if (with_stats && path_length > 0) {
+      stats->path_length = path_length;
     }
   }
 
-  // collect statistics
-  stats->cells_visited = count_visited(visited, maze->width * maze->height);
+  if (with_stats) {
+    // every queued cell counts as visited, as in bfs_kernel
+    stats->cells_visited = tail;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+  return status;
+}
 
-  // results
-  if (found) {
-    stats->path_length = reconstruct_path(maze, parent, start_idx, finish_idx);
+// bfs - main algo (to the nearest exit in multi-target mode)
+MazeStatus solve_bfs(Maze* maze, const SolverOptions* opts) {
+  bool diagonal = opts && opts->diagonal;
+  int finish;
+
+  SolverStats stats;
+
+  // validate input
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
+  }
+  // only the stats build traces, the plain one stays as it was
+  if (opts && opts->trace) {
+    return solve_bfs_stats(maze, opts, &stats);
+  }
+  finish = maze->width * maze->height - 1;
+  if (maze->targets) {
+    return diagonal ? bfs_kernel(maze, opts, NULL, 0, finish, false, true, true)
+                    : bfs_kernel(maze, opts, NULL, 0, finish, false, false, true);
+  }
+  if (IS_SMALL_MAZE(maze)) {
+    return diagonal ? small_bfs_kernel(maze, opts, NULL, 0, finish, false, true)
+                    : small_bfs_kernel(maze, opts, NULL, 0, finish, false, false);
   }
+  return diagonal ? bfs_kernel(maze, opts, NULL, 0, finish, false, true, false)
+                  : bfs_kernel(maze, opts, NULL, 0, finish, false, false, false);
+}
 
-  end_time = clock();
-  stats->time_ms = ((double)(end_time - start_time)) / CLOCKS_PER_SEC * 1000.0;
+// bfs with statistics
+MazeStatus solve_bfs_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  bool diagonal = opts && opts->diagonal;
+  int finish;
 
-  // cleanup
-  free(visited);
-  free(parent);
-  free_queue(queue);
+  // validate input
+  if (!maze || !maze->grid || !stats) {
+    return MAZE_ERR_ARG;
+  }
+  finish = maze->width * maze->height - 1;
+  if (maze->targets) {
+    return diagonal ? bfs_kernel(maze, opts, stats, 0, finish, true, true, true)
+                    : bfs_kernel(maze, opts, stats, 0, finish, true, false, true);
+  }
+  if (IS_SMALL_MAZE(maze) && !(opts && opts->trace)) {
+    return diagonal ? small_bfs_kernel(maze, opts, stats, 0, finish, true, true)
+                    : small_bfs_kernel(maze, opts, stats, 0, finish, true, false);
+  }
+  return diagonal ? bfs_kernel(maze, opts, stats, 0, finish, true, true, false)
+                  : bfs_kernel(maze, opts, stats, 0, finish, true, false, false);
+}
+
+// bfs between any two cells
+MazeStatus solve_bfs_between(Maze* maze, const SolverOptions* opts, int start, int finish,
+                             SolverStats* stats) {
+  bool diagonal = opts && opts->diagonal;
 
-  return found;
-}
\ No newline at end of file
+  // validate input
+  if (!maze || !maze->grid || start < 0 || finish < 0
+      || start >= maze->width * maze->height || finish >= maze->width * maze->height) {
+    return MAZE_ERR_ARG;
+  }
+  if (IS_SMALL_MAZE(maze) && !(stats && opts && opts->trace)) {
+    if (stats) {
+      return diagonal ? small_bfs_kernel(maze, opts, stats, start, finish, true, true)
+                      : small_bfs_kernel(maze, opts, stats, start, finish, true, false);
+    }
+    return diagonal ? small_bfs_kernel(maze, opts, NULL, start, finish, false, true)
+                    : small_bfs_kernel(maze, opts, NULL, start, finish, false, false);
+  }
+  if (stats) {
+    return diagonal ? bfs_kernel(maze, opts, stats, start, finish, true, true, false)
+                    : bfs_kernel(maze, opts, stats, start, finish, true, false, false);
+  }
+  return diagonal ? bfs_kernel(maze, opts, NULL, start, finish, false, true, false)
+                  : bfs_kernel(maze, opts, NULL, start, finish, false, false, false);
+}
@@ -0,0 +1,570 @@
+#include "solver.h"
+#include "movement.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Out-of-core BFS for mazes larger than memory.
+//
+// Nothing W*H-sized lives in memory. The maze file and a state file
+// (one nibble per cell: parent direction + 1, 0 = unvisited) are mapped
+// in row bands, a handful at a time; evicted bands are unmapped and the
+// kernel writes dirty state back to disk. The frontier is a FIFO whose
+// middle spills to a file, so cells come out in exactly the order the
+// in-memory queue would produce and the path matches solve_bfs. The
+// path is marked in the state file and the maze streamed out band by
+// band, or, for the compact formats, just its cells are written.
+
+// state nibbles
+#define ST_UNVISITED 0
+#define ST_ON_PATH   14
+#define ST_START     15
+
+// bands kept mapped per file (a cell and its neighbors span at most 2)
+#define BAND_SLOTS 8
+
+// smallest queue block (cells)
+#define QUEUE_BLOCK_MIN 64
+
+// bytes read at a time while looking for the end of the first row
+#define WIDTH_CHUNK 4096
+
+// ======== ROW BANDS ==========
+
+typedef struct {
+  int band;        // band index (-1 = free)
+  char* map;       // mapping (page aligned)
+  size_t map_len;
+  char* data;      // first row of the band
+  unsigned stamp;  // last use, for LRU eviction
+} BandSlot;
+
+typedef struct {
+  int fd;
+  bool writable;
+  size_t file_size;
+  size_t row_bytes;    // bytes per row in the file
+  int rows;
+  int rows_per_band;
+  int* slot_of_band;   // -1 if not mapped
+  BandSlot slots[BAND_SLOTS];
+  unsigned clock;
+} BandCache;
+
+static bool band_init(BandCache* bc, int fd, bool writable, size_t file_size, size_t row_bytes,
+                      int rows, int rows_per_band) {
+  int n_bands = rows / rows_per_band + (rows % rows_per_band != 0);
+  int i;
+
+  bc->fd = fd;
+  bc->writable = writable;
+  bc->file_size = file_size;
+  bc->row_bytes = row_bytes;
+  bc->rows = rows;
+  bc->rows_per_band = rows_per_band;
+  bc->clock = 0;
+  for (i = 0; i < BAND_SLOTS; i++) {
+    bc->slots[i].band = -1;
+    bc->slots[i].map = NULL;
+    bc->slots[i].stamp = 0;
+  }
+
+  bc->slot_of_band = malloc(n_bands * sizeof(int));
+  if (!bc->slot_of_band) {
+    return false;
+  }
+  for (i = 0; i < n_bands; i++) {
+    bc->slot_of_band[i] = -1;
+  }
+  return true;
+}
+
+static void band_unmap(BandCache* bc, BandSlot* slot) {
+  if (slot->map) {
+    munmap(slot->map, slot->map_len);
+    bc->slot_of_band[slot->band] = -1;
+    slot->map = NULL;
+    slot->band = -1;
+  }
+}
+
+static void band_free(BandCache* bc) {
+  int i;
+
+  for (i = 0; i < BAND_SLOTS; i++) {
+    band_unmap(bc, &bc->slots[i]);
+  }
+  free(bc->slot_of_band);
+}
+
+// pointer to row y, mapping its band into the least recently used slot
+static char* band_row(BandCache* bc, int y) {
+  int band = y / bc->rows_per_band;
+  int s = bc->slot_of_band[band];
+  long page = sysconf(_SC_PAGESIZE);
+  size_t offset, aligned, end;
+  BandSlot* slot;
+  int i;
+
+  if (s < 0) {
+    s = 0;
+    for (i = 1; i < BAND_SLOTS; i++) {
+      if (bc->slots[i].stamp < bc->slots[s].stamp) {
+        s = i;
+      }
+    }
+    slot = &bc->slots[s];
+    band_unmap(bc, slot);
+
+    offset = (size_t)band * bc->rows_per_band * bc->row_bytes;
+    aligned = offset / page * page;
+    end = offset + (size_t)bc->rows_per_band * bc->row_bytes;
+    if (end > bc->file_size) {
+      end = bc->file_size;
+    }
+
+    slot->map_len = end - aligned;
+    slot->map = mmap(NULL, slot->map_len, bc->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                     MAP_SHARED, bc->fd, aligned);
+    if (slot->map == MAP_FAILED) {
+      slot->map = NULL;
+      return NULL;
+    }
+    slot->data = slot->map + (offset - aligned);
+    slot->band = band;
+    bc->slot_of_band[band] = s;
+  }
+
+  bc->slots[s].stamp = ++bc->clock;
+  return bc->slots[s].data + (size_t)(y - band * bc->rows_per_band) * bc->row_bytes;
+}
+
+// ======== SPILLING FIFO ==========
+
+// head block (oldest) -> spilled blocks in the file -> tail block (newest)
+typedef struct {
+  uint64_t* head;     // cell indices: y * width + x can pass 4G
+  uint64_t* tail;
+  int block;          // cells per block
+  int head_pos;
+  int head_len;
+  int tail_len;
+  int fd;
+  off_t read_off;     // next spilled block to read
+  off_t write_off;    // end of spilled data
+} SpillQueue;
+
+static bool sq_push(SpillQueue* q, uint64_t cell) {
+  size_t bytes = (size_t)q->block * sizeof(uint64_t);
+
+  if (q->tail_len == q->block) {
+    if (pwrite(q->fd, q->tail, bytes, q->write_off) != (ssize_t)bytes) {
+      return false;
+    }
+    q->write_off += bytes;
+    q->tail_len = 0;
+  }
+  q->tail[q->tail_len++] = cell;
+  return true;
+}
+
+static bool sq_pop(SpillQueue* q, uint64_t* cell) {
+  uint64_t* swap;
+  size_t bytes = (size_t)q->block * sizeof(uint64_t);
+
+  if (q->head_pos == q->head_len) {
+    if (q->read_off < q->write_off) {
+      if (pread(q->fd, q->head, bytes, q->read_off) != (ssize_t)bytes) {
+        return false;
+      }
+      q->read_off += bytes;
+      q->head_len = q->block;
+      // drained: reuse the file from the start
+      if (q->read_off == q->write_off) {
+        q->read_off = 0;
+        q->write_off = 0;
+      }
+    } else if (q->tail_len > 0) {
+      swap = q->head;
+      q->head = q->tail;
+      q->tail = swap;
+      q->head_len = q->tail_len;
+      q->tail_len = 0;
+    } else {
+      return false;
+    }
+    q->head_pos = 0;
+  }
+  *cell = q->head[q->head_pos++];
+  return true;
+}
+
+// ======== HELPERS ==========
+
+// unlinked temporary file in $TMPDIR (or /tmp)
+static int temp_file(void) {
+  const char* dir = getenv("TMPDIR");
+  char path[4096];
+  int fd;
+
+  snprintf(path, sizeof(path), "%s/maze-external-XXXXXX", dir && *dir ? dir : "/tmp");
+  fd = mkstemp(path);
+  if (fd >= 0) {
+    unlink(path);
+  }
+  return fd;
+}
+
+static int get_nibble(const char* row, int x) {
+  unsigned char b = (unsigned char)row[x / 2];
+  return x & 1 ? b >> 4 : b & 0x0F;
+}
+
+static void set_nibble(char* row, int x, int v) {
+  unsigned char b = (unsigned char)row[x / 2];
+  row[x / 2] = (char)(x & 1 ? (b & 0x0F) | (v << 4) : (b & 0xF0) | v);
+}
+
+// check layout and characters band by band; rows must all be width long
+static MazeStatus check_file(BandCache* maze_rows, int width, int height, size_t file_size) {
+  bool bad = false;
+  bool weighted = false;
+  char* row;
+  int y;
+
+  for (y = 0; y < height; y++) {
+    row = band_row(maze_rows, y);
+    if (!row) {
+      return MAZE_ERR_IO;
+    }
+    if (memchr(row, '\n', width) ||
+        ((size_t)y * ((size_t)width + 1) + width < file_size && row[width] != '\n')) {
+      return MAZE_ERR_SHORT_LINE;
+    }
+    scan_maze_row(row, width, &bad, &weighted);
+  }
+  return bad ? MAZE_ERR_CHAR : MAZE_OK;
+}
+
+// ======== SOLVER ==========
+
+// external bfs kernel, specialized at compile time on diagonal movement
+// (the moves of the path are also collected, finish first, when moves is
+// given). Cells are counted in 64 bits; stats saturate at INT_MAX
+ALWAYS_INLINE MazeStatus external_kernel(BandCache* maze_rows, BandCache* state_rows,
+                                         SpillQueue* queue, int width, int height,
+                                         unsigned char** moves, size_t* n_moves,
+                                         SolverStats* stats, const bool diagonal) {
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  uint64_t finish = (uint64_t)height * width - 1;
+  uint64_t current;
+  uint64_t visited = 1;
+  uint64_t path_cells = 0;
+  char* m_rows[3];
+  char* s_rows[3];
+  char* cell_row;
+  char* state_row;
+  int x, y, nx, ny, i, d, v;
+  bool found = false;
+  bool diagonal_step;
+  size_t capacity = 0;
+  unsigned char* grown;
+
+  state_row = band_row(state_rows, 0);
+  if (!state_row) {
+    return MAZE_ERR_IO;
+  }
+  set_nibble(state_row, 0, ST_START);
+  if (!sq_push(queue, 0)) {
+    return MAZE_ERR_IO;
+  }
+
+  while (sq_pop(queue, &current)) {
+    if (current == finish) {
+      found = true;
+      break;
+    }
+    x = (int)(current % width);
+    y = (int)(current / width);
+
+    // rows y-1, y, y+1 (at most two bands each, all stay mapped)
+    for (i = 0; i < 3; i++) {
+      if (y - 1 + i < 0 || y - 1 + i >= height) {
+        continue;
+      }
+      m_rows[i] = band_row(maze_rows, y - 1 + i);
+      s_rows[i] = band_row(state_rows, y - 1 + i);
+      if (!m_rows[i] || !s_rows[i]) {
+        return MAZE_ERR_IO;
+      }
+    }
+
+    for (i = 0; i < n_dirs; i++) {
+      nx = x + dir_dx[i];
+      ny = y + dir_dy[i];
+
+      if (!IS_VALID_POS(nx, ny, width, height)) {
+        continue;
+      }
+      if (get_nibble(s_rows[ny - y + 1], nx) != ST_UNVISITED) {
+        continue;
+      }
+      if (!IS_PASSABLE(m_rows[ny - y + 1][nx])) {
+        continue;
+      }
+      if (diagonal && i >= DIRS_ORTHOGONAL &&
+          !(IS_PASSABLE(m_rows[1][nx]) && IS_PASSABLE(m_rows[ny - y + 1][x]))) {
+        continue;
+      }
+      set_nibble(s_rows[ny - y + 1], nx, i + 1);
+      if (!sq_push(queue, (uint64_t)ny * width + nx)) {
+        return MAZE_ERR_IO;
+      }
+      visited++;
+    }
+  }
+  stats->cells_visited = visited > INT_MAX ? INT_MAX : (int)visited;
+
+  if (!found) {
+    return MAZE_NO_PATH;
+  }
+
+  // walk parents back to start, turning each cell into a path mark
+  x = width - 1;
+  y = height - 1;
+  while (1) {
+    cell_row = band_row(maze_rows, y);
+    state_row = band_row(state_rows, y);
+    if (!cell_row || !state_row) {
+      return MAZE_ERR_IO;
+    }
+    v = get_nibble(state_row, x);
+    set_nibble(state_row, x, ST_ON_PATH);
+    path_cells++;
+    if (v == ST_START) {
+      break;
+    }
+    d = v - 1;
+    if (moves) {
+      if (*n_moves == capacity) {
+        capacity = capacity ? capacity * 2 : (size_t)width + height;
+        grown = realloc(*moves, capacity);
+        if (!grown) {
+          return MAZE_ERR_NOMEM;
+        }
+        *moves = grown;
+      }
+      (*moves)[(*n_moves)++] = (unsigned char)d;
+    }
+    diagonal_step = d >= DIRS_ORTHOGONAL;
+    stats->path_cost += CELL_COST(cell_row[x])
+                      * (diagonal_step ? (double)COST_DIAGONAL / COST_STRAIGHT : 1.0);
+    x -= dir_dx[d];
+    y -= dir_dy[d];
+  }
+  stats->path_length = path_cells > INT_MAX ? INT_MAX : (int)path_cells;
+  return MAZE_OK;
+}
+
+// stream the maze with path marks to out
+static MazeStatus write_solution(BandCache* maze_rows, BandCache* state_rows, int width,
+                                 int height, FILE* out) {
+  char* line = malloc((size_t)width + 1);
+  char* cell_row;
+  char* state_row;
+  int x, y;
+
+  if (!line) {
+    return MAZE_ERR_NOMEM;
+  }
+  line[width] = '\n';
+
+  for (y = 0; y < height; y++) {
+    cell_row = band_row(maze_rows, y);
+    state_row = band_row(state_rows, y);
+    if (!cell_row || !state_row) {
+      free(line);
+      return MAZE_ERR_IO;
+    }
+    for (x = 0; x < width; x++) {
+      line[x] = get_nibble(state_row, x) == ST_ON_PATH ? 'o' : cell_row[x];
+    }
+    if (fwrite(line, 1, (size_t)width + 1, out) != (size_t)width + 1) {
+      free(line);
+      return MAZE_ERR_IO;
+    }
+  }
+  free(line);
+  return MAZE_OK;
+}
+
+MazeStatus solve_bfs_external(const char* filename, const SolverOptions* opts, PathFormat format,
+                              FILE* out, SolverStats* stats) {
+  BandCache maze_rows = { .slot_of_band = NULL };
+  BandCache state_rows = { .slot_of_band = NULL };
+  SpillQueue queue = { .head = NULL, .tail = NULL, .fd = -1 };
+  SolverStats local_stats;
+  unsigned char* moves = NULL;
+  size_t n_moves = 0;
+  size_t i;
+  unsigned char swap;
+  struct stat st;
+  size_t budget = opts && opts->mem_limit ? opts->mem_limit : DEFAULT_MEM_LIMIT;
+  size_t state_bytes, band_budget, line, rows;
+  char chunk[WIDTH_CHUNK];
+  char* newline = NULL;
+  ssize_t got;
+  int maze_fd, state_fd = -1;
+  int width, height, rows_per_band;
+  clock_t start_time = clock();
+  MazeStatus status;
+
+  if (!filename || !out) {
+    return MAZE_ERR_ARG;
+  }
+  if (!stats) {
+    stats = &local_stats;
+  }
+  stats->algorithm = "BFS (external)";
+  stats->cells_visited = 0;
+  stats->path_length = 0;
+  stats->path_cost = 0;
+  stats->bound = 1.0;
+  stats->time_ms = 0.0;
+
+  maze_fd = open(filename, O_RDONLY);
+  if (maze_fd < 0) {
+    return MAZE_ERR_IO;
+  }
+  if (fstat(maze_fd, &st) != 0 || st.st_size == 0) {
+    close(maze_fd);
+    return st.st_size == 0 ? MAZE_ERR_EMPTY : MAZE_ERR_IO;
+  }
+
+  // width from the first line, read a chunk at a time (no row is ever
+  // held whole); rows are fixed length so offsets are known
+  got = pread(maze_fd, chunk, sizeof(chunk), 0);
+  // run-length text has no row offsets to seek to (maze-rle decodes it)
+  if (got >= 5 && memcmp(chunk, RLE_MAGIC " ", 5) == 0) {
+    close(maze_fd);
+    return MAZE_ERR_ARG;
+  }
+  line = 0;
+  while (got > 0 && !(newline = memchr(chunk, '\n', (size_t)got)) && line <= INT_MAX) {
+    line += (size_t)got;
+    got = pread(maze_fd, chunk, sizeof(chunk), (off_t)line);
+  }
+  if (got < 0) {
+    close(maze_fd);
+    return MAZE_ERR_IO;
+  }
+  if (got > 0 && newline) {
+    line += (size_t)(newline - chunk);
+  }
+  if (line == 0) {
+    close(maze_fd);
+    return MAZE_ERR_EMPTY;
+  }
+  // no limit of its own: sides only have to fit the int coordinates, and
+  // memory is bounded by the budget (a band is at least one row mapped)
+  rows = ((size_t)st.st_size + line) / (line + 1);
+  if (line > INT_MAX || rows > INT_MAX) {
+    close(maze_fd);
+    return MAZE_ERR_SIZE;
+  }
+  width = (int)line;
+  height = (int)rows;
+  if (rows * (line + 1) != (size_t)st.st_size && rows * (line + 1) - 1 != (size_t)st.st_size) {
+    close(maze_fd);
+    return MAZE_ERR_SHORT_LINE;
+  }
+
+  // budget: 1/8 for the two queue blocks, the rest for mapped bands
+  queue.block = (int)(budget / 8 / 2 / sizeof(uint64_t));
+  if (queue.block < QUEUE_BLOCK_MIN) {
+    queue.block = QUEUE_BLOCK_MIN;
+  }
+  band_budget = budget - budget / 8;
+  state_bytes = ((size_t)width + 1) / 2;
+  rows = band_budget / BAND_SLOTS / ((size_t)width + 1 + state_bytes);
+  rows_per_band = rows < 1 ? 1 : rows > (size_t)height ? height : (int)rows;
+
+  status = MAZE_ERR_NOMEM;
+  if (!band_init(&maze_rows, maze_fd, false, (size_t)st.st_size, (size_t)width + 1, height,
+                 rows_per_band)) {
+    goto cleanup;
+  }
+
+  status = check_file(&maze_rows, width, height, (size_t)st.st_size);
+  if (status != MAZE_OK) {
+    goto cleanup;
+  }
+  if (!IS_PASSABLE(band_row(&maze_rows, 0)[0]) ||
+      !IS_PASSABLE(band_row(&maze_rows, height - 1)[width - 1])) {
+    status = MAZE_NO_PATH;
+    goto cleanup;
+  }
+
+  // sparse state file, zero = unvisited
+  status = MAZE_ERR_IO;
+  state_fd = temp_file();
+  queue.fd = temp_file();
+  if (state_fd < 0 || queue.fd < 0 || ftruncate(state_fd, (off_t)(state_bytes * height)) != 0) {
+    goto cleanup;
+  }
+
+  status = MAZE_ERR_NOMEM;
+  queue.head = malloc((size_t)queue.block * sizeof(uint64_t));
+  queue.tail = malloc((size_t)queue.block * sizeof(uint64_t));
+  if (!queue.head || !queue.tail ||
+      !band_init(&state_rows, state_fd, true, state_bytes * height, state_bytes, height,
+                 rows_per_band)) {
+    goto cleanup;
+  }
+
+  // compact formats need the moves (a byte each, so the path does not
+  // depend on cell indices fitting an int), the grid is read back from
+  // the marks
+  if (opts && opts->diagonal) {
+    status = external_kernel(&maze_rows, &state_rows, &queue, width, height,
+                             format == PATH_GRID ? NULL : &moves, &n_moves, stats, true);
+  } else {
+    status = external_kernel(&maze_rows, &state_rows, &queue, width, height,
+                             format == PATH_GRID ? NULL : &moves, &n_moves, stats, false);
+  }
+  if (status == MAZE_OK && format == PATH_GRID) {
+    status = write_solution(&maze_rows, &state_rows, width, height, out);
+  } else if (status == MAZE_OK) {
+    for (i = 0; i < n_moves / 2; i++) {
+      swap = moves[i];
+      moves[i] = moves[n_moves - 1 - i];
+      moves[n_moves - 1 - i] = swap;
+    }
+    status = write_moves(out, format, 0, 0, moves, n_moves, width, height);
+  }
+
+cleanup:
+  free(moves);
+  if (state_rows.slot_of_band) {
+    band_free(&state_rows);
+  }
+  if (maze_rows.slot_of_band) {
+    band_free(&maze_rows);
+  }
+  free(queue.head);
+  free(queue.tail);
+  if (queue.fd >= 0) {
+    close(queue.fd);
+  }
+  if (state_fd >= 0) {
+    close(state_fd);
+  }
+  close(maze_fd);
+
+  stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  return status;
+}
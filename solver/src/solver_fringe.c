@@ -0,0 +1,486 @@
+#include "solver.h"
+#include "movement.h"
+#include <stdint.h>
+
+// Memory-bounded optimal search: Fringe Search with a fixed-size
+// transposition table instead of per-cell arrays.
+//
+// Fringe Search is IDA* that keeps its frontier: cells with
+// f = g + h <= limit are expanded depth first, the others wait on the
+// "later" list, and the next pass starts from them with the smallest
+// f that was over the limit. Expanding only below the limit keeps it
+// optimal, like A*, without a priority queue.
+//
+// What A* keeps per cell (g, parent, closed) lives in a table of
+// opts->mem_limit bytes. When the table is full, the least recently
+// touched entry is dropped. A dropped cell is searched again if the
+// search meets it (re-expansion instead of memory), never ignored, so
+// the path stays optimal. The frontier lists only hold the fringe, which
+// is small in mazes.
+//
+// Re-expansion is bounded: once a search has expanded FRINGE_MAX_REEXPAND
+// times the cells of the maze, the table is taken to thrash (a loopy or
+// weighted maze far too big for the budget, where re-expansion grows
+// exponentially) and the search gives up with MAZE_ERR_NOMEM. Perfect
+// mazes stay well under it even at the smallest budget (23x at 16K on
+// 1001x1001).
+//
+// The path is read back through the parent directions in the table.
+// Where the chain is broken (an entry was dropped, or rewritten with a
+// worse g after that), the optimal cost of the cell is still known, so
+// a new search from start to that cell finishes the path.
+
+// table ways per set (one set is looked at per cell)
+#define TT_WAYS 4
+
+// share of the budget given to the table (rest: fringe lists, path)
+#define TT_SHARE(budget) ((budget) / 4 * 3)
+
+// expansions per maze cell before the table counts as thrashing
+#define FRINGE_MAX_REEXPAND 32
+
+// info layout: parent direction (4 bits), closed flag, pass stamp
+#define INFO_DIR_MASK  0x0Fu
+#define INFO_CLOSED    0x10u
+#define INFO_STAMP_SHIFT 5
+
+// fringe entries carry the parent direction in the top bits of the cell
+#define ENTRY_DIR_SHIFT 28
+#define ENTRY_CELL_MASK ((1u << ENTRY_DIR_SHIFT) - 1)
+#define DIR_START 15
+
+typedef struct {
+  uint32_t key;   // cell + 1, 0 = empty way
+  uint32_t g;     // best known cost from start
+  uint32_t info;  // parent direction | INFO_CLOSED | stamp << INFO_STAMP_SHIFT
+} TTEntry;
+
+// a cell waiting on a fringe list with the cost it was reached at
+typedef struct {
+  uint32_t cell_dir;  // cell | parent direction << ENTRY_DIR_SHIFT
+  uint32_t g;
+} FringeEntry;
+
+typedef struct {
+  FringeEntry* items;
+  size_t size;
+  size_t capacity;
+} FringeList;
+
+typedef struct {
+  Maze* maze;
+  TTEntry* table;
+  size_t sets;          // power of two
+  uint32_t stamp;       // current pass, for least-recently-touched eviction
+  FringeList now;       // expanded depth first (a stack)
+  FringeList later;     // over the limit, next pass
+  const atomic_bool* cancel;
+  unsigned polls;
+  long expanded;
+  long max_expanded;    // thrash guard, FRINGE_MAX_REEXPAND per cell
+} FringeSearch;
+
+// ============ TRANSPOSITION TABLE ============
+
+static TTEntry* tt_set(const FringeSearch* fs, int cell) {
+  return fs->table + ((size_t)cell & (fs->sets - 1)) * TT_WAYS;
+}
+
+static TTEntry* tt_lookup(const FringeSearch* fs, int cell) {
+  TTEntry* set = tt_set(fs, cell);
+  uint32_t key = (uint32_t)cell + 1;
+  int w;
+
+  for (w = 0; w < TT_WAYS; w++) {
+    if (set[w].key == key) {
+      return &set[w];
+    }
+  }
+  return NULL;
+}
+
+// entry for cell, taking the empty or least recently touched way
+static TTEntry* tt_store(FringeSearch* fs, int cell, uint32_t g, int dir) {
+  TTEntry* set = tt_set(fs, cell);
+  TTEntry* slot = NULL;
+  uint32_t key = (uint32_t)cell + 1;
+  int w;
+
+  for (w = 0; w < TT_WAYS; w++) {
+    if (set[w].key == key || set[w].key == 0) {
+      slot = &set[w];
+      break;
+    }
+    if (!slot || (set[w].info >> INFO_STAMP_SHIFT) < (slot->info >> INFO_STAMP_SHIFT)) {
+      slot = &set[w];
+    }
+  }
+
+  slot->key = key;
+  slot->g = g;
+  slot->info = (uint32_t)dir | (fs->stamp << INFO_STAMP_SHIFT);
+  return slot;
+}
+
+static void tt_touch(const FringeSearch* fs, TTEntry* entry) {
+  entry->info = (entry->info & ((1u << INFO_STAMP_SHIFT) - 1)) | (fs->stamp << INFO_STAMP_SHIFT);
+}
+
+// ============ FRINGE LISTS ============
+
+static bool list_push(FringeList* list, const MazeAllocator* alloc, int cell, int dir, uint32_t g) {
+  size_t capacity;
+  FringeEntry* items;
+
+  if (list->size == list->capacity) {
+    capacity = list->capacity ? list->capacity * 2 : 1024;
+    items = mem_realloc(alloc, list->items, list->capacity * sizeof(FringeEntry),
+                        capacity * sizeof(FringeEntry));
+    if (!items) {
+      return false;
+    }
+    list->items = items;
+    list->capacity = capacity;
+  }
+  list->items[list->size].cell_dir = (uint32_t)cell | ((uint32_t)dir << ENTRY_DIR_SHIFT);
+  list->items[list->size].g = g;
+  list->size++;
+  return true;
+}
+
+static void list_free(FringeList* list, const MazeAllocator* alloc) {
+  mem_free(alloc, list->items, list->capacity * sizeof(FringeEntry));
+  list->items = NULL;
+  list->size = 0;
+  list->capacity = 0;
+}
+
+// ============ SEARCH ============
+
+// Manhattan or octile distance, in g units
+ALWAYS_INLINE uint32_t fringe_estimate(int x, int y, int goal_x, int goal_y, const bool diagonal) {
+  int dist_x = (x > goal_x) ? (x - goal_x) : (goal_x - x);
+  int dist_y = (y > goal_y) ? (y - goal_y) : (goal_y - y);
+
+  return diagonal ? (uint32_t)octile_distance(x, y, goal_x, goal_y) : (uint32_t)(dist_x + dist_y);
+}
+
+// cost of stepping into cell in direction d
+ALWAYS_INLINE uint32_t step_cost(const Maze* maze, int cell, int d, const bool diagonal) {
+  return CELL_COST(maze->grid[cell])
+       * (diagonal ? (d < DIRS_ORTHOGONAL ? COST_STRAIGHT : COST_DIAGONAL) : 1);
+}
+
+// optimal cost from start to goal into *cost; the table holds the
+// parent chain of goal afterwards (possibly broken by evictions)
+ALWAYS_INLINE MazeStatus fringe_run(FringeSearch* fs, int start, int goal, uint32_t* cost,
+                                    bool reset, const bool diagonal) {
+  Maze* maze = fs->maze;
+  const MazeAllocator* alloc = &maze->alloc;
+  int width = maze->width;
+  int goal_x = goal % width;
+  int goal_y = goal / width;
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  FringeList swap;
+  FringeEntry item;
+  TTEntry* entry;
+  uint64_t limit, next_limit, f;
+  uint32_t g, ng, h;
+  int cell, dir, next, x, y, nx, ny, d;
+
+  if (reset) {
+    memset(fs->table, 0, fs->sets * TT_WAYS * sizeof(TTEntry));
+  }
+  fs->now.size = 0;
+  fs->later.size = 0;
+  fs->stamp = 1;
+
+  tt_store(fs, start, 0, DIR_START);
+  if (!list_push(&fs->later, alloc, start, DIR_START, 0)) {
+    return MAZE_ERR_NOMEM;
+  }
+  limit = fringe_estimate(start % width, start / width, goal_x, goal_y, diagonal);
+
+  // one pass per f limit, until the goal is expanded or nothing is left
+  while (fs->later.size > 0) {
+    swap = fs->now;
+    fs->now = fs->later;
+    fs->later = swap;
+    fs->later.size = 0;
+    next_limit = UINT64_MAX;
+    if (fs->stamp < (UINT32_MAX >> INFO_STAMP_SHIFT)) {
+      fs->stamp++;
+    }
+
+    while (fs->now.size > 0) {
+      item = fs->now.items[--fs->now.size];
+      cell = (int)(item.cell_dir & ENTRY_CELL_MASK);
+      dir = (int)(item.cell_dir >> ENTRY_DIR_SHIFT);
+      g = item.g;
+
+      if (poll_cancel(fs->cancel, &fs->polls)) {
+        return MAZE_CANCELLED;
+      }
+
+      // superseded by a cheaper entry, or expanded at this cost already
+      entry = tt_lookup(fs, cell);
+      if (entry && (entry->g < g || (entry->g == g && (entry->info & INFO_CLOSED)))) {
+        continue;
+      }
+      if (!entry || entry->g > g) {
+        entry = tt_store(fs, cell, g, dir);  // dropped meanwhile: still valid
+      }
+
+      x = cell % width;
+      y = cell / width;
+      h = fringe_estimate(x, y, goal_x, goal_y, diagonal);
+      f = (uint64_t)g + h;
+
+      // over the limit: wait for a later pass
+      if (f > limit) {
+        tt_touch(fs, entry);
+        if (f < next_limit) {
+          next_limit = f;
+        }
+        if (!list_push(&fs->later, alloc, cell, dir, g)) {
+          return MAZE_ERR_NOMEM;
+        }
+        continue;
+      }
+
+      entry->info |= INFO_CLOSED;
+      tt_touch(fs, entry);
+      if (++fs->expanded > fs->max_expanded) {
+        return MAZE_ERR_NOMEM;
+      }
+
+      if (cell == goal) {
+        *cost = g;
+        return MAZE_OK;
+      }
+
+      // children go on top of the stack: expanded right after this cell
+      for (d = n_dirs - 1; d >= 0; d--) {
+        nx = x + dir_dx[d];
+        ny = y + dir_dy[d];
+
+        if (!IS_VALID_POS(nx, ny, width, maze->height)) {
+          continue;
+        }
+        next = IDX(nx, ny, width);
+        if (!IS_PASSABLE(maze->grid[next])) {
+          continue;
+        }
+        if (diagonal && d >= DIRS_ORTHOGONAL && !(is_open(maze, nx, y) && is_open(maze, x, ny))) {
+          continue;
+        }
+
+        ng = g + step_cost(maze, next, d, diagonal);
+        entry = tt_lookup(fs, next);
+        if (entry && entry->g <= ng) {
+          continue;
+        }
+        tt_store(fs, next, ng, d + 1);
+        if (!list_push(&fs->now, alloc, next, d + 1, ng)) {
+          return MAZE_ERR_NOMEM;
+        }
+      }
+    }
+
+    limit = next_limit;
+  }
+
+  return MAZE_NO_PATH;
+}
+
+// append cell to a growing cell array
+static bool cells_push(int** cells, size_t* count, size_t* capacity, const MazeAllocator* alloc,
+                       int cell) {
+  size_t grown;
+  int* items;
+
+  if (*count == *capacity) {
+    grown = *capacity ? *capacity * 2 : 1024;
+    items = mem_realloc(alloc, *cells, *capacity * sizeof(int), grown * sizeof(int));
+    if (!items) {
+      return false;
+    }
+    *cells = items;
+    *capacity = grown;
+  }
+  (*cells)[(*count)++] = cell;
+  return true;
+}
+
+// read the path back from the table, searching again from start to
+// the first cell whose chain was lost
+ALWAYS_INLINE MazeStatus fringe_path(FringeSearch* fs, int start, int goal, uint32_t cost,
+                                     const bool diagonal) {
+  Maze* maze = fs->maze;
+  const MazeAllocator* alloc = &maze->alloc;
+  int* cells = NULL;  // goal first, reversed into the path at the end
+  int* trimmed;
+  size_t count = 0, capacity = 0;
+  TTEntry* entry;
+  MazeStatus status = MAZE_OK;
+  uint32_t g = cost;
+  int cell = goal;
+  int d, swap;
+  size_t i;
+
+  if (!cells_push(&cells, &count, &capacity, alloc, cell)) {
+    return MAZE_ERR_NOMEM;
+  }
+
+  while (cell != start) {
+    entry = tt_lookup(fs, cell);
+    if (!entry || entry->g != g) {
+      // chain lost here: g is still this cell's optimal cost
+      status = fringe_run(fs, start, cell, &g, true, diagonal);
+      if (status != MAZE_OK) {
+        break;
+      }
+      continue;
+    }
+
+    d = (int)(entry->info & INFO_DIR_MASK) - 1;
+    g -= step_cost(maze, cell, d, diagonal);
+    cell -= IDX(dir_dx[d], dir_dy[d], maze->width);
+    if (!cells_push(&cells, &count, &capacity, alloc, cell)) {
+      status = MAZE_ERR_NOMEM;
+      break;
+    }
+  }
+
+  // trim to size and hand the array over as the path
+  if (status == MAZE_OK) {
+    trimmed = mem_realloc(alloc, cells, capacity * sizeof(int), count * sizeof(int));
+    if (trimmed) {
+      cells = trimmed;
+      capacity = count;
+    } else {
+      status = MAZE_ERR_NOMEM;
+    }
+  }
+  if (status != MAZE_OK) {
+    mem_free(alloc, cells, capacity * sizeof(int));
+    return status;
+  }
+
+  for (i = 0; i < count / 2; i++) {
+    swap = cells[i];
+    cells[i] = cells[count - 1 - i];
+    cells[count - 1 - i] = swap;
+  }
+  path_clear(maze);
+  maze->path = cells;
+  maze->path_length = (int)count;
+  return MAZE_OK;
+}
+
+// Fringe Search kernel, specialized like the A* kernel
+ALWAYS_INLINE MazeStatus fringe_kernel(Maze* maze, const SolverOptions* opts, SolverStats* stats,
+                                       const bool with_stats, const bool diagonal) {
+  FringeSearch fs;
+  size_t budget = opts && opts->mem_limit ? opts->mem_limit : DEFAULT_MEM_LIMIT;
+  size_t cells_n = (size_t)maze->width * maze->height;
+  size_t sets = 1;
+  int start_idx = 0;
+  int finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
+  uint32_t cost = 0;
+  MazeStatus status;
+  clock_t start_time = 0;
+
+  if (with_stats) {
+    // initialize stats
+    stats->algorithm = "Fringe";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
+  }
+
+  // fringe entries keep the cell in 28 bits
+  if (cells_n > ENTRY_CELL_MASK) {
+    return MAZE_ERR_SIZE;
+  }
+  if (budget < FRINGE_MIN_MEM) {
+    return MAZE_ERR_ARG;
+  }
+
+  // labeled apart: no path, answer without searching
+  if (!same_component(maze, start_idx, finish_idx)) {
+    if (with_stats) {
+      stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+    }
+    return MAZE_NO_PATH;
+  }
+
+  // largest power-of-two set count inside the table's share, no more
+  // than about two ways per cell (a bigger table would only sit empty)
+  while (sets * 2 * TT_WAYS * sizeof(TTEntry) <= TT_SHARE(budget)
+         && sets * TT_WAYS < 2 * cells_n) {
+    sets *= 2;
+  }
+
+  fs.maze = maze;
+  fs.sets = sets;
+  fs.table = mem_zalloc(&maze->alloc, sets * TT_WAYS * sizeof(TTEntry));
+  fs.now = (FringeList){NULL, 0, 0};
+  fs.later = (FringeList){NULL, 0, 0};
+  fs.cancel = CANCEL_FLAG(opts);
+  fs.polls = 0;
+  fs.expanded = 0;
+  fs.max_expanded = (long)(cells_n * FRINGE_MAX_REEXPAND);
+  if (!fs.table) {
+    return MAZE_ERR_NOMEM;
+  }
+
+  status = fringe_run(&fs, start_idx, finish_idx, &cost, false, diagonal);
+  if (status == MAZE_OK) {
+    status = fringe_path(&fs, start_idx, finish_idx, cost, diagonal);
+  }
+
+  if (with_stats) {
+    if (status == MAZE_OK) {
+      stats->path_length = maze->path_length;
+      stats->path_cost = (double)cost / (diagonal ? COST_STRAIGHT : 1);
+    }
+    stats->cells_visited = fs.expanded > INT32_MAX ? INT32_MAX : (int)fs.expanded;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+
+  // cleanup
+  list_free(&fs.now, &maze->alloc);
+  list_free(&fs.later, &maze->alloc);
+  mem_free(&maze->alloc, fs.table, sets * TT_WAYS * sizeof(TTEntry));
+
+  return status;
+}
+
+// Fringe Search within opts->mem_limit
+MazeStatus solve_fringe(Maze* maze, const SolverOptions* opts) {
+  // validate input
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
+  }
+  if (opts && opts->diagonal) {
+    return fringe_kernel(maze, opts, NULL, false, true);
+  }
+  return fringe_kernel(maze, opts, NULL, false, false);
+}
+
+// Fringe Search with statistics
+MazeStatus solve_fringe_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  // validate input
+  if (!maze || !maze->grid || !stats) {
+    return MAZE_ERR_ARG;
+  }
+  if (opts && opts->diagonal) {
+    return fringe_kernel(maze, opts, stats, true, true);
+  }
+  return fringe_kernel(maze, opts, stats, true, false);
+}
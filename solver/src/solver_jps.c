@@ -0,0 +1,398 @@
+#include "solver.h"
+#include "radix_heap.h"
+#include "arena.h"
+#include "movement.h"
+#include <string.h>
+#include <stdint.h>
+
+// state byte flags
+#define REACHED_BIT 0x01
+#define CLOSED_BIT  0x02
+
+// -1, 0 or 1
+#define SIGN(v) (((v) > 0) - ((v) < 0))
+
+// Jump point search on 8-directional uniform grids, diagonal moves may
+// not cut corners. Only jump points enter the open set, so the larger
+// branching factor of diagonal movement does not blow it up.
+
+// walk straight from (x, y) until a jump point, a wall or the goal
+// returns the jump point index or -1
+static int jump_straight(const Maze* maze, int x, int y, int dx, int dy, int goal_idx) {
+  int idx;
+
+  while (1) {
+    x += dx;
+    y += dy;
+
+    if (!is_open(maze, x, y)) {
+      return -1;
+    }
+
+    idx = IDX(x, y, maze->width);
+    if (idx == goal_idx) {
+      return idx;
+    }
+
+    // forced neighbor: a side cell only reachable optimally through here
+    if (dx != 0) {
+      if ((is_open(maze, x, y - 1) && !is_open(maze, x - dx, y - 1)) ||
+          (is_open(maze, x, y + 1) && !is_open(maze, x - dx, y + 1))) {
+        return idx;
+      }
+    } else {
+      if ((is_open(maze, x - 1, y) && !is_open(maze, x - 1, y - dy)) ||
+          (is_open(maze, x + 1, y) && !is_open(maze, x + 1, y - dy))) {
+        return idx;
+      }
+    }
+  }
+}
+
+// walk diagonally from (x, y) until a cell whose straight scans find a
+// jump point, a blocked step or the goal; returns the index or -1
+static int jump_diagonal(const Maze* maze, int x, int y, int dx, int dy, int goal_idx) {
+  int idx;
+
+  while (1) {
+    // no corner cutting
+    if (!is_open(maze, x + dx, y) || !is_open(maze, x, y + dy)) {
+      return -1;
+    }
+
+    x += dx;
+    y += dy;
+
+    if (!is_open(maze, x, y)) {
+      return -1;
+    }
+
+    idx = IDX(x, y, maze->width);
+    if (idx == goal_idx) {
+      return idx;
+    }
+
+    if (jump_straight(maze, x, y, dx, 0, goal_idx) >= 0 ||
+        jump_straight(maze, x, y, 0, dy, goal_idx) >= 0) {
+      return idx;
+    }
+  }
+}
+
+// pruned neighbor directions of (x, y) reached moving (dx, dy);
+// (0, 0) at the start returns every legal direction
+static int pruned_dirs(const Maze* maze, int x, int y, int dx, int dy, int* out_dx, int* out_dy) {
+  int n = 0;
+  int d;
+  bool next_open, side_a, side_b;
+
+  if (dx == 0 && dy == 0) {
+    for (d = 0; d < DIRS_DIAGONAL; d++) {
+      if (can_move(maze, x, y, d)) {
+        out_dx[n] = dir_dx[d];
+        out_dy[n] = dir_dy[d];
+        n++;
+      }
+    }
+    return n;
+  }
+
+  if (dx != 0 && dy != 0) {
+    // diagonal: keep going, plus both straight components
+    side_a = is_open(maze, x, y + dy);
+    side_b = is_open(maze, x + dx, y);
+    if (side_a) {
+      out_dx[n] = 0; out_dy[n] = dy; n++;
+    }
+    if (side_b) {
+      out_dx[n] = dx; out_dy[n] = 0; n++;
+    }
+    if (side_a && side_b) {
+      out_dx[n] = dx; out_dy[n] = dy; n++;
+    }
+  } else if (dx != 0) {
+    // horizontal: keep going, turn up/down, or go diagonal ahead
+    next_open = is_open(maze, x + dx, y);
+    side_a = is_open(maze, x, y + 1);
+    side_b = is_open(maze, x, y - 1);
+    if (next_open) {
+      out_dx[n] = dx; out_dy[n] = 0; n++;
+      if (side_a) {
+        out_dx[n] = dx; out_dy[n] = 1; n++;
+      }
+      if (side_b) {
+        out_dx[n] = dx; out_dy[n] = -1; n++;
+      }
+    }
+    if (side_a) {
+      out_dx[n] = 0; out_dy[n] = 1; n++;
+    }
+    if (side_b) {
+      out_dx[n] = 0; out_dy[n] = -1; n++;
+    }
+  } else {
+    // vertical: keep going, turn left/right, or go diagonal ahead
+    next_open = is_open(maze, x, y + dy);
+    side_a = is_open(maze, x + 1, y);
+    side_b = is_open(maze, x - 1, y);
+    if (next_open) {
+      out_dx[n] = 0; out_dy[n] = dy; n++;
+      if (side_a) {
+        out_dx[n] = 1; out_dy[n] = dy; n++;
+      }
+      if (side_b) {
+        out_dx[n] = -1; out_dy[n] = dy; n++;
+      }
+    }
+    if (side_a) {
+      out_dx[n] = 1; out_dy[n] = 0; n++;
+    }
+    if (side_b) {
+      out_dx[n] = -1; out_dy[n] = 0; n++;
+    }
+  }
+
+  return n;
+}
+
+// store the path in maze->path by filling the straight/diagonal runs
+// between jump points, returns its length (-1 if out of memory)
+static int reconstruct_path_jps(Maze* maze, const int* parent, int start_idx, int finish_idx) {
+  int current;
+  int path_length = 1;  // count start
+  int* path;
+  int i, x, y, px, py, sx, sy, steps_x, steps_y;
+
+  // count cells back from finish: each run adds the longer axis
+  for (current = finish_idx; current != start_idx; current = parent[current]) {
+    steps_x = abs(current % maze->width - parent[current] % maze->width);
+    steps_y = abs(current / maze->width - parent[current] / maze->width);
+    path_length += steps_x > steps_y ? steps_x : steps_y;
+  }
+  path = path_reserve(maze, path_length);
+  if (!path) {
+    return -1;
+  }
+
+  // fill from the end
+  current = finish_idx;
+  i = path_length;
+
+  while (current != start_idx) {
+    x = current % maze->width;
+    y = current / maze->width;
+    px = parent[current] % maze->width;
+    py = parent[current] / maze->width;
+    sx = SIGN(px - x);
+    sy = SIGN(py - y);
+
+    while (x != px || y != py) {
+      path[--i] = IDX(x, y, maze->width);
+      x += sx;
+      y += sy;
+    }
+    current = parent[current];
+  }
+  path[0] = start_idx;
+
+  return path_length;
+}
+
+// JPS kernel, specialized at compile time on with_stats
+ALWAYS_INLINE MazeStatus jps_kernel(Maze* maze, const SolverOptions* opts, SolverStats* stats,
+                                    const bool with_stats) {
+  uint32_t* g;
+  int* parent;
+  unsigned char* state;
+  RadixHeap* open_set;
+  int start_idx;
+  int finish_idx;
+  int current_idx;
+  int jump_idx;
+  int x, y, jx, jy;
+  int dx, dy;
+  int goal_x, goal_y;
+  int succ_dx[DIRS_DIAGONAL];
+  int succ_dy[DIRS_DIAGONAL];
+  int n_succ;
+  int i;
+  int steps_x, steps_y;
+  bool found;
+  bool cancelled = false;
+  bool nomem = false;
+  const atomic_bool* cancel = CANCEL_FLAG(opts);
+  unsigned polls = 0;
+  int path_length;
+  MazeStatus status;
+  uint32_t tentative_g;
+  size_t cells = (size_t)maze->width * maze->height;
+  Arena arena;
+  int cells_visited = 0;
+  clock_t start_time = 0;
+
+  if (with_stats) {
+    // initialize stats
+    stats->algorithm = "JPS";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
+  }
+
+  // calculate start and finish
+  start_idx = IDX(0, 0, maze->width);
+  finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
+
+  // labeled apart: no path, answer without searching
+  if (!same_component(maze, start_idx, finish_idx)) {
+    if (with_stats) {
+      stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+    }
+    return MAZE_NO_PATH;
+  }
+
+  goal_x = maze->width - 1;
+  goal_y = maze->height - 1;
+
+  // allocate state
+  if (!arena_init(&arena, ARENA_SIZE(cells * (sizeof(uint32_t) + sizeof(int) + 1), 3),
+                  &maze->alloc, opts && opts->huge_pages)) {
+    return MAZE_ERR_NOMEM;
+  }
+  g = arena_push(&arena, cells * sizeof(uint32_t));
+  parent = arena_push(&arena, cells * sizeof(int));
+  state = arena_push_zero(&arena, cells * sizeof(unsigned char));
+
+  open_set = create_radix_heap(maze->width + maze->height, &maze->alloc);
+  if (!open_set) {
+    arena_release(&arena);
+    return MAZE_ERR_NOMEM;
+  }
+
+  // initialize start
+  g[start_idx] = 0;
+  parent[start_idx] = start_idx;
+  state[start_idx] = REACHED_BIT;
+  nomem = !rh_push(open_set, start_idx, octile_distance(0, 0, goal_x, goal_y));
+
+  // main loop
+  found = false;
+
+  while (!nomem && !rh_is_empty(open_set)) {
+    if (!rh_pop(open_set, &current_idx, NULL)) {
+      nomem = true;
+      break;
+    }
+    if (poll_cancel(cancel, &polls)) {
+      cancelled = true;
+      break;
+    }
+
+    if (state[current_idx] & CLOSED_BIT) {
+      continue;
+    }
+
+    state[current_idx] |= CLOSED_BIT;
+    if (with_stats) {
+      cells_visited++;
+    }
+
+    if (current_idx == finish_idx) {
+      found = true;
+      break;
+    }
+
+    x = current_idx % maze->width;
+    y = current_idx / maze->width;
+    dx = SIGN(x - parent[current_idx] % maze->width);
+    dy = SIGN(y - parent[current_idx] / maze->width);
+
+    n_succ = pruned_dirs(maze, x, y, dx, dy, succ_dx, succ_dy);
+
+    for (i = 0; i < n_succ; i++) {
+      if (succ_dx[i] != 0 && succ_dy[i] != 0) {
+        jump_idx = jump_diagonal(maze, x, y, succ_dx[i], succ_dy[i], finish_idx);
+      } else {
+        jump_idx = jump_straight(maze, x, y, succ_dx[i], succ_dy[i], finish_idx);
+      }
+
+      if (jump_idx < 0 || (state[jump_idx] & CLOSED_BIT)) {
+        continue;
+      }
+
+      // jump points lie on a pure straight or diagonal run
+      jx = jump_idx % maze->width;
+      jy = jump_idx / maze->width;
+      steps_x = jx > x ? jx - x : x - jx;
+      steps_y = jy > y ? jy - y : y - jy;
+      tentative_g = g[current_idx]
+                  + (succ_dx[i] != 0 && succ_dy[i] != 0 ? COST_DIAGONAL * steps_x
+                                                       : COST_STRAIGHT * (steps_x + steps_y));
+
+      if (!(state[jump_idx] & REACHED_BIT) || tentative_g < g[jump_idx]) {
+        state[jump_idx] |= REACHED_BIT;
+        g[jump_idx] = tentative_g;
+        parent[jump_idx] = current_idx;
+        if (!rh_push(open_set, jump_idx, tentative_g + octile_distance(jx, jy, goal_x, goal_y))) {
+          nomem = true;
+          break;
+        }
+      }
+    }
+  }
+
+  // reconstruct path if found (a dropped node would make any answer wrong)
+  status = nomem ? MAZE_ERR_NOMEM : cancelled ? MAZE_CANCELLED : MAZE_NO_PATH;
+  if (found) {
+    path_length = reconstruct_path_jps(maze, parent, start_idx, finish_idx);
+    status = path_length < 0 ? MAZE_ERR_NOMEM : MAZE_OK;
+    if (with_stats && path_length > 0) {
+      stats->path_cost = (double)g[finish_idx] / COST_STRAIGHT;
+      stats->path_length = path_length;
+    }
+  }
+
+  if (with_stats) {
+    stats->cells_visited = cells_visited;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+
+  // cleanup
+  arena_release(&arena);
+  free_radix_heap(open_set);
+
+  return status;
+}
+
+// JPS - main algo (weighted terrain breaks jump pruning, use diagonal A*)
+MazeStatus solve_jps(Maze* maze, const SolverOptions* opts) {
+  SolverOptions diag_opts = opts ? *opts : (SolverOptions){ .diagonal = true };
+
+  // validate input
+  if (!maze || !maze->grid) {
+    return MAZE_ERR_ARG;
+  }
+  diag_opts.diagonal = true;
+  if (maze->weighted) {
+    return solve_astar(maze, &diag_opts);
+  }
+  return jps_kernel(maze, opts, NULL, false);
+}
+
+// JPS with statistics
+MazeStatus solve_jps_stats(Maze* maze, const SolverOptions* opts, SolverStats* stats) {
+  SolverOptions diag_opts = opts ? *opts : (SolverOptions){ .diagonal = true };
+
+  // validate input
+  if (!maze || !maze->grid || !stats) {
+    return MAZE_ERR_ARG;
+  }
+  diag_opts.diagonal = true;
+  if (maze->weighted) {
+    return solve_astar_stats(maze, &diag_opts, stats);
+  }
+  return jps_kernel(maze, opts, stats, true);
+}
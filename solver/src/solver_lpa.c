@@ -0,0 +1,336 @@
+#include "lpa.h"
+#include "movement.h"
+#include "landmarks.h"
+#include <string.h>
+
+// unreached / unreachable cost
+#define LPA_INF UINT32_MAX
+
+// direction index pointing back the other way
+static const int opposite[DIRS_DIAGONAL] = {1, 0, 3, 2, 7, 6, 5, 4};
+
+// cost of stepping from cell idx in direction d (LPA_INF if not allowed)
+static uint32_t edge_cost(const LpaPlanner* lpa, int idx, int d) {
+  const Maze* maze = lpa->maze;
+  int x = idx % maze->width;
+  int y = idx / maze->width;
+  int cost;
+
+  if (!is_open(maze, x, y) || !can_move(maze, x, y, d)) {
+    return LPA_INF;
+  }
+
+  cost = CELL_COST(maze->grid[IDX(x + dir_dx[d], y + dir_dy[d], maze->width)]);
+  if (lpa->diagonal) {
+    cost *= d < DIRS_ORTHOGONAL ? COST_STRAIGHT : COST_DIAGONAL;
+  }
+  return (uint32_t)cost;
+}
+
+// Manhattan or octile distance to finish
+static uint32_t lpa_heuristic(const LpaPlanner* lpa, int idx) {
+  int x = idx % lpa->maze->width;
+  int y = idx / lpa->maze->width;
+  int goal_x = lpa->maze->width - 1;
+  int goal_y = lpa->maze->height - 1;
+
+  if (lpa->diagonal) {
+    return (uint32_t)octile_distance(x, y, goal_x, goal_y);
+  }
+  return (uint32_t)((goal_x - x) + (goal_y - y));
+}
+
+// key [min(g, rhs) + h; min(g, rhs)] packed high/low
+static unsigned long long calc_key(const LpaPlanner* lpa, int idx) {
+  uint32_t m = lpa->g[idx] < lpa->rhs[idx] ? lpa->g[idx] : lpa->rhs[idx];
+
+  if (m == LPA_INF) {
+    return ~0ULL;
+  }
+  return ((unsigned long long)(m + lpa_heuristic(lpa, idx)) << 32) | m;
+}
+
+// recompute rhs of idx and put it in the open set if inconsistent;
+// MAZE_ERR_NOMEM if the push fails (idx is then missing from the open set)
+static MazeStatus update_vertex(LpaPlanner* lpa, int idx) {
+  const Maze* maze = lpa->maze;
+  int x = idx % maze->width;
+  int y = idx / maze->width;
+  int n_dirs = lpa->diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  int d, pred;
+  uint32_t best, cost;
+  unsigned long long key;
+
+  if (idx != lpa->start_idx) {
+    best = LPA_INF;
+    for (d = 0; d < n_dirs; d++) {
+      if (!IS_VALID_POS(x + dir_dx[d], y + dir_dy[d], maze->width, maze->height)) {
+        continue;
+      }
+      pred = IDX(x + dir_dx[d], y + dir_dy[d], maze->width);
+      if (lpa->g[pred] == LPA_INF) {
+        continue;
+      }
+      cost = edge_cost(lpa, pred, opposite[d]);
+      if (cost != LPA_INF && lpa->g[pred] + cost < best) {
+        best = lpa->g[pred] + cost;
+      }
+    }
+    lpa->rhs[idx] = best;
+  }
+
+  if (lpa->g[idx] == lpa->rhs[idx]) {
+    lpa->in_open[idx] = 0;  // stale entries are skipped on pop
+    return MAZE_OK;
+  }
+
+  key = calc_key(lpa, idx);
+  if (!lpa->in_open[idx] || lpa->open_key[idx] != key) {
+    if (!pq_push(lpa->open_set, idx, key)) {
+      lpa->broken = true;
+      return MAZE_ERR_NOMEM;
+    }
+    lpa->open_key[idx] = key;
+    lpa->in_open[idx] = 1;
+  }
+  return MAZE_OK;
+}
+
+// peek at the smallest live entry, dropping stale ones
+static bool top_key(LpaPlanner* lpa, int* idx, unsigned long long* key) {
+  int dropped;
+
+  while (pq_peek(lpa->open_set, idx, key)) {
+    if (lpa->in_open[*idx] && lpa->open_key[*idx] == *key) {
+      return true;
+    }
+    pq_pop(lpa->open_set, &dropped);
+  }
+  return false;
+}
+
+LpaPlanner* lpa_create(Maze* maze, const SolverOptions* opts) {
+  LpaPlanner* lpa;
+  int size;
+  int i;
+
+  if (!maze || !maze->grid) {
+    return NULL;
+  }
+
+  lpa = mem_zalloc(&maze->alloc, sizeof(LpaPlanner));
+  if (!lpa) {
+    return NULL;
+  }
+
+  size = maze->width * maze->height;
+  lpa->maze = maze;
+  lpa->diagonal = opts && opts->diagonal;
+  lpa->start_idx = IDX(0, 0, maze->width);
+  lpa->finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
+
+  // per-cell state in one arena
+  if (!arena_init(&lpa->arena, ARENA_SIZE(size * (2 * sizeof(uint32_t) + sizeof(unsigned long long)
+                                                  + sizeof(unsigned char)), 4),
+                  &maze->alloc, opts && opts->huge_pages)) {
+    mem_free(&maze->alloc, lpa, sizeof(LpaPlanner));
+    return NULL;
+  }
+  lpa->g = arena_push(&lpa->arena, size * sizeof(uint32_t));
+  lpa->rhs = arena_push(&lpa->arena, size * sizeof(uint32_t));
+  lpa->open_key = arena_push(&lpa->arena, size * sizeof(unsigned long long));
+  lpa->in_open = arena_push_zero(&lpa->arena, size * sizeof(unsigned char));
+  lpa->open_set = create_pq(maze->width + maze->height, &maze->alloc);
+  if (!lpa->open_set) {
+    lpa_free(lpa);
+    return NULL;
+  }
+
+  for (i = 0; i < size; i++) {
+    lpa->g[i] = LPA_INF;
+    lpa->rhs[i] = LPA_INF;
+  }
+
+  // start is the only locally inconsistent cell
+  lpa->rhs[lpa->start_idx] = 0;
+  if (update_vertex(lpa, lpa->start_idx) != MAZE_OK) {
+    lpa_free(lpa);
+    return NULL;
+  }
+
+  return lpa;
+}
+
+MazeStatus lpa_compute(LpaPlanner* lpa) {
+  const Maze* maze = lpa->maze;
+  int n_dirs = lpa->diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  int finish = lpa->finish_idx;
+  int idx, d, x, y;
+  unsigned long long key;
+
+  lpa->expanded = 0;
+  if (lpa->broken) {
+    return MAZE_ERR_NOMEM;
+  }
+
+  while (top_key(lpa, &idx, &key)) {
+    if (key >= calc_key(lpa, finish) && lpa->rhs[finish] == lpa->g[finish]) {
+      break;
+    }
+
+    pq_pop(lpa->open_set, &idx);
+    lpa->in_open[idx] = 0;
+    lpa->expanded++;
+
+    if (lpa->g[idx] > lpa->rhs[idx]) {
+      // overconsistent: settle it
+      lpa->g[idx] = lpa->rhs[idx];
+    } else {
+      // underconsistent: a cost went up, reopen it
+      lpa->g[idx] = LPA_INF;
+      if (update_vertex(lpa, idx) != MAZE_OK) {
+        return MAZE_ERR_NOMEM;
+      }
+    }
+
+    x = idx % maze->width;
+    y = idx / maze->width;
+    for (d = 0; d < n_dirs; d++) {
+      if (IS_VALID_POS(x + dir_dx[d], y + dir_dy[d], maze->width, maze->height)
+          && update_vertex(lpa, IDX(x + dir_dx[d], y + dir_dy[d], maze->width)) != MAZE_OK) {
+        return MAZE_ERR_NOMEM;
+      }
+    }
+  }
+
+  return lpa->g[finish] != LPA_INF && IS_PASSABLE(maze->grid[lpa->start_idx]) ? MAZE_OK
+                                                                              : MAZE_NO_PATH;
+}
+
+MazeStatus lpa_set_cell(LpaPlanner* lpa, int x, int y, char c) {
+  Maze* maze = lpa->maze;
+  int idx, d;
+
+  if (!IS_VALID_POS(x, y, maze->width, maze->height)) {
+    return MAZE_ERR_ARG;
+  }
+  if (!IS_PASSABLE(c) && c != 'X') {
+    return MAZE_ERR_CHAR;
+  }
+
+  idx = IDX(x, y, maze->width);
+  if (maze->grid[idx] == c) {
+    return MAZE_OK;
+  }
+
+  maze->grid[idx] = c;
+  if (c >= '1' && c <= '9') {
+    maze->weighted = true;
+  }
+
+  // cached components and landmark tables no longer match the grid
+  mem_free(&maze->alloc, maze->labels, (size_t)maze->width * maze->height * sizeof(int));
+  maze->labels = NULL;
+  free_landmarks(maze);
+
+  // edges into the cell, out of it and diagonals around its corners
+  // all end at the cell or one of its 8 neighbors
+  if (update_vertex(lpa, idx) != MAZE_OK) {
+    return MAZE_ERR_NOMEM;
+  }
+  for (d = 0; d < DIRS_DIAGONAL; d++) {
+    if (IS_VALID_POS(x + dir_dx[d], y + dir_dy[d], maze->width, maze->height)
+        && update_vertex(lpa, IDX(x + dir_dx[d], y + dir_dy[d], maze->width)) != MAZE_OK) {
+      return MAZE_ERR_NOMEM;
+    }
+  }
+  return MAZE_OK;
+}
+
+int lpa_store_path(LpaPlanner* lpa, double* path_cost) {
+  Maze* maze = lpa->maze;
+  int n_dirs = lpa->diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+  int current = lpa->finish_idx;
+  int* path = NULL;
+  int* grown;
+  int* stored;
+  int path_length = 0;
+  int capacity = 0;
+  int x, y, d, pred, best, i;
+  uint32_t cost, best_g;
+
+  if (lpa->g[current] == LPA_INF || !IS_PASSABLE(maze->grid[lpa->start_idx])) {
+    return 0;
+  }
+
+  // follow the cheapest predecessor back to start
+  while (1) {
+    if (path_length >= capacity) {
+      capacity = capacity ? capacity * 2 : maze->width + maze->height;
+      grown = mem_realloc(&maze->alloc, path, path_length * sizeof(int), capacity * sizeof(int));
+      if (!grown) {
+        mem_free(&maze->alloc, path, path_length * sizeof(int));
+        return 0;
+      }
+      path = grown;
+    }
+    path[path_length++] = current;
+
+    if (current == lpa->start_idx) {
+      break;
+    }
+
+    x = current % maze->width;
+    y = current / maze->width;
+    best = -1;
+    best_g = LPA_INF;
+
+    for (d = 0; d < n_dirs; d++) {
+      if (!IS_VALID_POS(x + dir_dx[d], y + dir_dy[d], maze->width, maze->height)) {
+        continue;
+      }
+      pred = IDX(x + dir_dx[d], y + dir_dy[d], maze->width);
+      if (lpa->g[pred] == LPA_INF) {
+        continue;
+      }
+      cost = edge_cost(lpa, pred, opposite[d]);
+      if (cost != LPA_INF && lpa->g[pred] + cost < best_g) {
+        best_g = lpa->g[pred] + cost;
+        best = pred;
+      }
+    }
+
+    if (best < 0) {
+      mem_free(&maze->alloc, path, capacity * sizeof(int));
+      return 0;  // not planned yet, call lpa_compute first
+    }
+    current = best;
+  }
+
+  // stored start to finish
+  stored = path_reserve(maze, path_length);
+  if (stored) {
+    for (i = 0; i < path_length; i++) {
+      stored[i] = path[path_length - 1 - i];
+    }
+  }
+  mem_free(&maze->alloc, path, capacity * sizeof(int));
+  if (!stored) {
+    return 0;
+  }
+
+  if (path_cost) {
+    *path_cost = (double)lpa->g[lpa->finish_idx] / (lpa->diagonal ? COST_STRAIGHT : 1);
+  }
+  return path_length;
+}
+
+void lpa_free(LpaPlanner* lpa) {
+  if (!lpa) {
+    return;
+  }
+
+  arena_release(&lpa->arena);
+  free_pq(lpa->open_set);
+  mem_free(&lpa->maze->alloc, lpa, sizeof(LpaPlanner));
+}
@@ -0,0 +1,402 @@
+#include "solver.h"
+#include "arena.h"
+#include "movement.h"
+#include <stdint.h>
+
+// Multi-source BFS (MS-BFS): up to 64 searches advance together.
+//
+// Each search owns one bit (a lane) of two words per cell: the lanes that
+// have seen the cell, and the lanes that reached it on the current level
+// (side by side, one cache line per step). A cell is expanded once per
+// level for all of its lanes, so searches that walk the same corridors
+// at the same time share the work. The frontier list carries each
+// cell's lanes along, and is read in order.
+//
+// BFS distances are symmetric, so each query is searched from whichever
+// end more queries share: a lane answers every query that has its source
+// as an endpoint, and "many starts to one exit" becomes a single search.
+
+#define LANES 64
+
+typedef uint64_t LaneMask;
+
+// lanes per cell: seen so far, and reached on the level being built
+typedef struct {
+  LaneMask seen;
+  LaneMask next;
+} LaneCell;
+
+// frontier cell and the lanes it holds
+typedef struct {
+  LaneMask lanes;
+  int cell;
+} LaneEntry;
+
+// frontier of one level, grows on demand
+typedef struct {
+  LaneEntry* items;
+  size_t size;
+  size_t capacity;
+} LaneList;
+
+// a query waiting for the sweeps
+typedef struct {
+  int source;  // endpoint searched from (sort key while lanes are assigned)
+  int goal;    // the other endpoint (sort key within a sweep)
+  int lane;    // lane of source in its sweep
+  int query;   // index into queries / distances
+} LaneQuery;
+
+// per-cell and per-query state of a batch
+typedef struct {
+  LaneCell* cells;
+  uint64_t* goal_bits;   // goals of the current sweep, one bit per cell
+  LaneQuery* pending;    // non-trivial queries, grouped by source
+  int* endpoints;        // sorted endpoints of all pending queries
+  int* hits;             // goals first reached by some lane this level
+  LaneList frontier;
+  LaneList next;
+  const MazeAllocator* alloc;
+} BatchCells;
+
+#define GOAL_TEST(bits, cell)  ((bits)[(cell) >> 6] & ((uint64_t)1 << ((cell) & 63)))
+#define GOAL_SET(bits, cell)   ((bits)[(cell) >> 6] |= (uint64_t)1 << ((cell) & 63))
+#define GOAL_CLEAR(bits, cell) ((bits)[(cell) >> 6] &= ~((uint64_t)1 << ((cell) & 63)))
+
+static int compare_int(const void* a, const void* b) {
+  int ia = *(const int*)a;
+  int ib = *(const int*)b;
+
+  return (ia > ib) - (ia < ib);
+}
+
+static int compare_source(const void* a, const void* b) {
+  const LaneQuery* qa = a;
+  const LaneQuery* qb = b;
+
+  return (qa->source > qb->source) - (qa->source < qb->source);
+}
+
+static int compare_goal(const void* a, const void* b) {
+  const LaneQuery* qa = a;
+  const LaneQuery* qb = b;
+
+  return (qa->goal > qb->goal) - (qa->goal < qb->goal);
+}
+
+// first index in a sorted int array holding a value >= key
+static int lower_bound(const int* sorted, int n, int key) {
+  int lo = 0, hi = n, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (sorted[mid] < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// how many times cell occurs among the sorted endpoints
+static int endpoint_count(const int* sorted, int n, int cell) {
+  return lower_bound(sorted, n, cell + 1) - lower_bound(sorted, n, cell);
+}
+
+static bool list_push(LaneList* list, const MazeAllocator* alloc, int cell, LaneMask lanes) {
+  size_t capacity;
+  LaneEntry* items;
+
+  if (list->size == list->capacity) {
+    capacity = list->capacity ? list->capacity * 2 : 1024;
+    items = mem_realloc(alloc, list->items, list->capacity * sizeof(LaneEntry),
+                        capacity * sizeof(LaneEntry));
+    if (!items) {
+      return false;
+    }
+    list->items = items;
+    list->capacity = capacity;
+  }
+  list->items[list->size].cell = cell;
+  list->items[list->size].lanes = lanes;
+  list->size++;
+  return true;
+}
+
+// first query of a sweep (sorted by goal) with this goal
+static int first_with_goal(const LaneQuery* sweep, int n, int goal) {
+  int lo = 0, hi = n, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (sweep[mid].goal < goal) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// one sweep: BFS from every lane source at once until each query of the
+// sweep has its distance (the unreachable ones keep -1); cells must be
+// all zero on entry
+ALWAYS_INLINE MazeStatus msbfs_sweep(const Maze* maze, BatchCells* c, LaneQuery* sweep,
+                                     int sweep_n, const int* lane_source, int* lane_pending,
+                                     int lanes, int* distances, const atomic_bool* cancel,
+                                     unsigned* polls, int* expanded, const bool with_stats,
+                                     const bool diagonal) {
+  LaneMask active = 0;
+  LaneMask mask, add, bit;
+  LaneCell* near;
+  LaneList swap;
+  int hits_n;
+  int unresolved = sweep_n;
+  int level = 0;
+  int cell, next, x, y;
+  size_t i;
+  int j, k, d;
+  const int n_dirs = diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL;
+
+  c->frontier.size = 0;
+  for (j = 0; j < lanes; j++) {
+    bit = (LaneMask)1 << j;
+    c->cells[lane_source[j]].seen |= bit;
+    if (!list_push(&c->frontier, c->alloc, lane_source[j], bit)) {
+      return MAZE_ERR_NOMEM;
+    }
+    active |= bit;
+  }
+
+  while (c->frontier.size > 0 && unresolved > 0) {
+    level++;
+    c->next.size = 0;
+    hits_n = 0;
+
+    for (i = 0; i < c->frontier.size; i++) {
+      mask = c->frontier.items[i].lanes & active;
+      if (!mask) {
+        continue;  // only lanes that are already done
+      }
+      if (poll_cancel(cancel, polls)) {
+        return MAZE_CANCELLED;
+      }
+      if (with_stats) {
+        (*expanded)++;
+      }
+
+      cell = c->frontier.items[i].cell;
+      x = cell % maze->width;
+      y = cell / maze->width;
+      for (d = 0; d < n_dirs; d++) {
+        if (diagonal ? !can_move(maze, x, y, d) : !is_open(maze, x + dir_dx[d], y + dir_dy[d])) {
+          continue;
+        }
+        next = cell + IDX(dir_dx[d], dir_dy[d], maze->width);
+        near = &c->cells[next];
+        add = mask & ~near->seen;
+        if (!add) {
+          continue;
+        }
+        near->seen |= add;
+        if (!near->next && !list_push(&c->next, c->alloc, next, 0)) {
+          return MAZE_ERR_NOMEM;
+        }
+        near->next |= add;
+        if (GOAL_TEST(c->goal_bits, next)) {
+          GOAL_CLEAR(c->goal_bits, next);  // listed once per level
+          c->hits[hits_n++] = next;
+        }
+      }
+    }
+
+    // collect the lanes of the new level
+    for (i = 0; i < c->next.size; i++) {
+      near = &c->cells[c->next.items[i].cell];
+      c->next.items[i].lanes = near->next;
+      near->next = 0;
+    }
+
+    swap = c->frontier;
+    c->frontier = c->next;
+    c->next = swap;
+
+    // answer the queries whose goal a lane of theirs reached just now;
+    // a lane with no query left stops spreading
+    for (j = 0; j < hits_n; j++) {
+      cell = c->hits[j];
+      GOAL_SET(c->goal_bits, cell);
+      for (k = first_with_goal(sweep, sweep_n, cell); k < sweep_n && sweep[k].goal == cell; k++) {
+        bit = (LaneMask)1 << sweep[k].lane;
+        if (distances[sweep[k].query] < 0 && (c->cells[cell].seen & bit)) {
+          distances[sweep[k].query] = level;
+          unresolved--;
+          if (--lane_pending[sweep[k].lane] == 0) {
+            active &= ~bit;
+          }
+        }
+      }
+    }
+  }
+  return MAZE_OK;
+}
+
+// batch kernel, specialized at compile time like the single bfs:
+// - with_stats: the plain build carries no counter or timer code at all
+// - diagonal: 8-directional movement without corner cutting
+ALWAYS_INLINE MazeStatus msbfs_kernel(Maze* maze, const SolverOptions* opts,
+                                      const MazeQuery* queries, int count, int* distances,
+                                      SolverStats* stats, const bool with_stats,
+                                      const bool diagonal) {
+  BatchCells c;
+  Arena arena;
+  LaneQuery* sweep;
+  int lane_source[LANES];
+  int lane_pending[LANES];
+  int lanes, sweep_n;
+  int pending_n = 0, next_pending = 0;
+  int start, goal;
+  int i;
+  bool first_sweep = true;
+  MazeStatus status = MAZE_OK;
+  const atomic_bool* cancel = CANCEL_FLAG(opts);
+  unsigned polls = 0;
+  int expanded = 0;
+  size_t cells_n = (size_t)maze->width * maze->height;
+  size_t goal_words = cells_n / 64 + 1;
+  clock_t start_time = 0;
+
+  if (with_stats) {
+    stats->algorithm = "MS-BFS";
+    stats->cells_visited = 0;
+    stats->path_length = 0;
+    stats->path_cost = 0;
+    stats->bound = 1.0;
+    stats->time_ms = 0.0;
+
+    start_time = clock();
+  }
+
+  // lane words and goal bits per cell, then the per-query lists (the
+  // frontier lists grow on demand, so they live outside the arena)
+  if (!arena_init(&arena,
+                  ARENA_SIZE(cells_n * sizeof(LaneCell) + goal_words * sizeof(uint64_t)
+                                 + (size_t)count * (sizeof(LaneQuery) + 3 * sizeof(int)), 5),
+                  &maze->alloc, opts && opts->huge_pages)) {
+    return MAZE_ERR_NOMEM;
+  }
+  c.cells = arena_push_zero(&arena, cells_n * sizeof(LaneCell));
+  c.goal_bits = arena_push_zero(&arena, goal_words * sizeof(uint64_t));
+  c.pending = arena_push(&arena, (size_t)count * sizeof(LaneQuery));
+  c.endpoints = arena_push(&arena, (size_t)count * 2 * sizeof(int));
+  c.hits = arena_push(&arena, (size_t)count * sizeof(int));
+  c.frontier = (LaneList){ NULL, 0, 0 };
+  c.next = (LaneList){ NULL, 0, 0 };
+  c.alloc = &maze->alloc;
+
+  // answer trivial queries right away, the rest go to the sweeps
+  for (i = 0; i < count; i++) {
+    start = IDX(queries[i].start_x, queries[i].start_y, maze->width);
+    goal = IDX(queries[i].goal_x, queries[i].goal_y, maze->width);
+    distances[i] = -1;
+    if (!IS_PASSABLE(maze->grid[start]) || !IS_PASSABLE(maze->grid[goal])
+        || !same_component(maze, start, goal)) {
+      continue;
+    }
+    if (start == goal) {
+      distances[i] = 0;
+      continue;
+    }
+    c.pending[pending_n].source = start;
+    c.pending[pending_n].goal = goal;
+    c.pending[pending_n].query = i;
+    c.endpoints[2 * pending_n] = start;
+    c.endpoints[2 * pending_n + 1] = goal;
+    pending_n++;
+  }
+
+  // search each query from its more shared end, and group by source so
+  // a source never needs a lane in two sweeps
+  qsort(c.endpoints, 2 * (size_t)pending_n, sizeof(int), compare_int);
+  for (i = 0; i < pending_n; i++) {
+    start = c.pending[i].source;
+    goal = c.pending[i].goal;
+    if (endpoint_count(c.endpoints, 2 * pending_n, goal)
+        > endpoint_count(c.endpoints, 2 * pending_n, start)) {
+      c.pending[i].source = goal;
+      c.pending[i].goal = start;
+    }
+  }
+  qsort(c.pending, pending_n, sizeof(LaneQuery), compare_source);
+
+  while (next_pending < pending_n && status == MAZE_OK) {
+    // the next 64 sources and all of their queries
+    sweep = c.pending + next_pending;
+    lanes = 0;
+    sweep_n = 0;
+    for (; next_pending < pending_n; next_pending++, sweep_n++) {
+      if (lanes == 0 || c.pending[next_pending].source != lane_source[lanes - 1]) {
+        if (lanes == LANES) {
+          break;
+        }
+        lane_source[lanes] = c.pending[next_pending].source;
+        lane_pending[lanes] = 0;
+        lanes++;
+      }
+      c.pending[next_pending].lane = lanes - 1;
+      lane_pending[lanes - 1]++;
+    }
+    qsort(sweep, sweep_n, sizeof(LaneQuery), compare_goal);
+
+    if (!first_sweep) {
+      memset(c.cells, 0, cells_n * sizeof(LaneCell));
+    }
+    first_sweep = false;
+    for (i = 0; i < sweep_n; i++) {
+      GOAL_SET(c.goal_bits, sweep[i].goal);
+    }
+
+    status = msbfs_sweep(maze, &c, sweep, sweep_n, lane_source, lane_pending, lanes, distances,
+                       cancel, &polls, &expanded, with_stats, diagonal);
+
+    for (i = 0; i < sweep_n; i++) {
+      GOAL_CLEAR(c.goal_bits, sweep[i].goal);
+    }
+  }
+
+  if (with_stats) {
+    stats->cells_visited = expanded;
+    stats->time_ms = ((double)(clock() - start_time)) / CLOCKS_PER_SEC * 1000.0;
+  }
+
+  mem_free(&maze->alloc, c.frontier.items, c.frontier.capacity * sizeof(LaneEntry));
+  mem_free(&maze->alloc, c.next.items, c.next.capacity * sizeof(LaneEntry));
+  arena_release(&arena);
+  return status;
+}
+
+// multi-source bfs over a batch of queries
+MazeStatus solve_bfs_batch(Maze* maze, const SolverOptions* opts, const MazeQuery* queries,
+                           int count, int* distances, SolverStats* stats) {
+  bool diagonal = opts && opts->diagonal;
+  int i;
+
+  // validate input
+  if (!maze || !maze->grid || count < 0 || (count > 0 && (!queries || !distances))) {
+    return MAZE_ERR_ARG;
+  }
+  for (i = 0; i < count; i++) {
+    if (!IS_VALID_POS(queries[i].start_x, queries[i].start_y, maze->width, maze->height)
+        || !IS_VALID_POS(queries[i].goal_x, queries[i].goal_y, maze->width, maze->height)) {
+      return MAZE_ERR_ARG;
+    }
+  }
+
+  if (stats) {
+    return diagonal ? msbfs_kernel(maze, opts, queries, count, distances, stats, true, true)
+                    : msbfs_kernel(maze, opts, queries, count, distances, stats, true, false);
+  }
+  return diagonal ? msbfs_kernel(maze, opts, queries, count, distances, NULL, false, true)
+                  : msbfs_kernel(maze, opts, queries, count, distances, NULL, false, false);
+}
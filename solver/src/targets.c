@@ -0,0 +1,212 @@
+#include "targets.h"
+#include "movement.h"
+#include <limits.h>
+
+// Exit sets for multi-target search.
+//
+// Buckets are sized for about one exit each (never under
+// TARGET_BUCKET_MIN cells a side) and only keep the bounding box of
+// their exits, so the heuristic costs one distance per nearby bucket
+// however many exits it holds. The nearest box is searched ring by ring
+// around the bucket of the query cell: every cell of ring r is at least
+// (r - 1) * size + 1 steps away along one axis, so the search stops as
+// soon as the best box found is no farther than that. With only a few
+// non-empty buckets (clustered exits) a plain scan of them is cheaper
+// than walking rings of empty ones.
+
+#define TARGET_BUCKET_MIN 16
+#define TARGET_SCAN_MAX 16
+
+// words of the exit bitmap
+static size_t bit_words(const Maze* maze) {
+  return (size_t)maze->width * maze->height / 64 + 1;
+}
+
+void free_targets(Maze* maze) {
+  Targets* t = maze->targets;
+
+  if (!t) {
+    return;
+  }
+  mem_free(&maze->alloc, t->boxes, (size_t)t->buckets_x * t->buckets_y * sizeof(TargetBox));
+  mem_free(&maze->alloc, t->filled, (size_t)t->filled_count * sizeof(TargetBox));
+  mem_free(&maze->alloc, t->bits, bit_words(maze) * sizeof(uint64_t));
+  mem_free(&maze->alloc, t, sizeof(Targets));
+  maze->targets = NULL;
+}
+
+// bucket side for count exits: about one exit per bucket
+static int bucket_size(const Maze* maze, int count) {
+  double area = (double)maze->width * maze->height / count;
+  int size = TARGET_BUCKET_MIN;
+
+  while ((double)size * size < area) {
+    size *= 2;
+  }
+  return size;
+}
+
+MazeStatus set_targets(Maze* maze, const int* cells, int count, bool grid_exits) {
+  size_t cells_n;
+  size_t words;
+  size_t buckets;
+  uint64_t* bits;
+  Targets* t;
+  TargetBox* box;
+  int distinct = 0;
+  int cell, x, y, i;
+  size_t w;
+  uint64_t word;
+
+  if (!maze || !maze->grid || count < 0 || (count > 0 && !cells)) {
+    return MAZE_ERR_ARG;
+  }
+  cells_n = (size_t)maze->width * maze->height;
+  words = bit_words(maze);
+
+  // collect the exits in a bitmap (drops duplicates)
+  bits = mem_zalloc(&maze->alloc, words * sizeof(uint64_t));
+  if (!bits) {
+    return MAZE_ERR_NOMEM;
+  }
+  for (i = 0; i < count; i++) {
+    if (cells[i] < 0 || (size_t)cells[i] >= cells_n) {
+      mem_free(&maze->alloc, bits, words * sizeof(uint64_t));
+      return MAZE_ERR_ARG;
+    }
+    bits[cells[i] >> 6] |= (uint64_t)1 << (cells[i] & 63);
+  }
+  if (grid_exits) {
+    for (w = 0; w < cells_n; w++) {
+      if (maze->grid[w] == 'E') {
+        bits[w >> 6] |= (uint64_t)1 << (w & 63);
+      }
+    }
+  }
+  for (w = 0; w < words; w++) {
+    distinct += __builtin_popcountll(bits[w]);
+  }
+
+  free_targets(maze);
+  if (distinct == 0) {
+    mem_free(&maze->alloc, bits, words * sizeof(uint64_t));
+    return MAZE_OK;
+  }
+
+  t = mem_alloc(&maze->alloc, sizeof(Targets));
+  if (!t) {
+    mem_free(&maze->alloc, bits, words * sizeof(uint64_t));
+    return MAZE_ERR_NOMEM;
+  }
+  t->count = distinct;
+  t->bits = bits;
+  t->reached = -1;
+  t->bucket_size = bucket_size(maze, distinct);
+  t->buckets_x = (maze->width + t->bucket_size - 1) / t->bucket_size;
+  t->buckets_y = (maze->height + t->bucket_size - 1) / t->bucket_size;
+  buckets = (size_t)t->buckets_x * t->buckets_y;
+  t->boxes = mem_alloc(&maze->alloc, buckets * sizeof(TargetBox));
+  t->filled = NULL;
+  t->filled_count = 0;
+  if (!t->boxes) {
+    maze->targets = t;
+    free_targets(maze);
+    return MAZE_ERR_NOMEM;
+  }
+
+  // grow each bucket's box over its exits
+  for (w = 0; w < buckets; w++) {
+    t->boxes[w] = (TargetBox){ INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+  }
+  for (w = 0; w < words; w++) {
+    for (word = bits[w]; word; word &= word - 1) {
+      cell = (int)(w * 64 + __builtin_ctzll(word));
+      x = cell % maze->width;
+      y = cell / maze->width;
+      box = &t->boxes[(y / t->bucket_size) * t->buckets_x + x / t->bucket_size];
+      box->min_x = x < box->min_x ? x : box->min_x;
+      box->min_y = y < box->min_y ? y : box->min_y;
+      box->max_x = x > box->max_x ? x : box->max_x;
+      box->max_y = y > box->max_y ? y : box->max_y;
+    }
+  }
+
+  // pack the non-empty boxes
+  for (w = 0; w < buckets; w++) {
+    t->filled_count += t->boxes[w].min_x <= t->boxes[w].max_x;
+  }
+  t->filled = mem_alloc(&maze->alloc, (size_t)t->filled_count * sizeof(TargetBox));
+  maze->targets = t;
+  if (!t->filled) {
+    free_targets(maze);
+    return MAZE_ERR_NOMEM;
+  }
+  for (w = 0, i = 0; w < buckets; w++) {
+    if (t->boxes[w].min_x <= t->boxes[w].max_x) {
+      t->filled[i++] = t->boxes[w];
+    }
+  }
+  return MAZE_OK;
+}
+
+// distance from (x, y) to a box in the heuristic's units
+static inline int box_distance(const TargetBox* box, int x, int y, bool diagonal) {
+  int dx = x < box->min_x ? box->min_x - x : x > box->max_x ? x - box->max_x : 0;
+  int dy = y < box->min_y ? box->min_y - y : y > box->max_y ? y - box->max_y : 0;
+
+  if (diagonal) {
+    return octile_distance(0, 0, dx, dy);
+  }
+  return dx + dy;
+}
+
+int nearest_target(const Targets* t, int x, int y, bool diagonal) {
+  int hx = x / t->bucket_size;
+  int hy = y / t->bucket_size;
+  int rings = t->buckets_x > t->buckets_y ? t->buckets_x : t->buckets_y;
+  int best = INT_MAX;
+  const TargetBox* box;
+  int bound, d;
+  int r, bx, by, step;
+
+  if (t->filled_count <= TARGET_SCAN_MAX) {
+    for (r = 0; r < t->filled_count; r++) {
+      d = box_distance(&t->filled[r], x, y, diagonal);
+      if (d < best) {
+        best = d;
+      }
+    }
+    return best;
+  }
+
+  for (r = 0; r < rings; r++) {
+    // nothing in ring r (or beyond) can beat best
+    if (r > 0) {
+      bound = (r - 1) * t->bucket_size + 1;
+      if (best <= (diagonal ? bound * COST_STRAIGHT : bound)) {
+        break;
+      }
+    }
+    for (by = hy - r; by <= hy + r; by++) {
+      if (by < 0 || by >= t->buckets_y) {
+        continue;
+      }
+      // full rows at the top and bottom of the ring, else its two sides
+      step = (by == hy - r || by == hy + r) ? 1 : 2 * r;
+      for (bx = hx - r; bx <= hx + r; bx += step) {
+        if (bx < 0 || bx >= t->buckets_x) {
+          continue;
+        }
+        box = &t->boxes[by * t->buckets_x + bx];
+        if (box->min_x > box->max_x) {
+          continue;
+        }
+        d = box_distance(box, x, y, diagonal);
+        if (d < best) {
+          best = d;
+        }
+      }
+    }
+  }
+  return best;
+}
@@ -0,0 +1,101 @@
+#include "trace.h"
+
+static unsigned char* put_u32(unsigned char* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+  return p + 4;
+}
+
+MazeStatus trace_open(const char* filename, const MazeAllocator* alloc, MazeTrace** out) {
+  MazeTrace* trace;
+
+  if (!filename || !out) {
+    return MAZE_ERR_ARG;
+  }
+  *out = NULL;
+  if (!alloc) {
+    alloc = maze_default_allocator();
+  }
+  trace = mem_alloc(alloc, sizeof(MazeTrace));
+  if (!trace) {
+    return MAZE_ERR_NOMEM;
+  }
+  trace->alloc = *alloc;
+  trace->buf = mem_alloc(alloc, TRACE_BUFFER);
+  if (!trace->buf) {
+    mem_free(alloc, trace, sizeof(MazeTrace));
+    return MAZE_ERR_NOMEM;
+  }
+  trace->file = fopen(filename, "wb");
+  if (!trace->file) {
+    mem_free(alloc, trace->buf, TRACE_BUFFER);
+    mem_free(alloc, trace, sizeof(MazeTrace));
+    return MAZE_ERR_IO;
+  }
+  // records are buffered here already
+  setvbuf(trace->file, NULL, _IONBF, 0);
+
+  memcpy(trace->buf, TRACE_MAGIC, 4);
+  trace->used = 4;
+  trace->prev = -1;
+  trace->steps = 0;
+  trace->error = MAZE_OK;
+  *out = trace;
+  return MAZE_OK;
+}
+
+MazeStatus trace_close(MazeTrace* trace) {
+  MazeStatus status;
+
+  if (!trace) {
+    return MAZE_ERR_ARG;
+  }
+  trace_flush(trace);
+  if (fclose(trace->file) != 0 && trace->error == MAZE_OK) {
+    trace->error = MAZE_ERR_IO;
+  }
+  status = trace->error;
+  mem_free(&trace->alloc, trace->buf, TRACE_BUFFER);
+  mem_free(&trace->alloc, trace, sizeof(MazeTrace));
+  return status;
+}
+
+void trace_flush(MazeTrace* trace) {
+  // after a failed write the rest is dropped, the file is unusable anyway
+  if (trace->used && trace->error == MAZE_OK
+      && fwrite(trace->buf, 1, trace->used, trace->file) != trace->used) {
+    trace->error = MAZE_ERR_IO;
+  }
+  trace->used = 0;
+}
+
+void trace_begin(MazeTrace* trace, const Maze* maze, TraceKind kind, int flags) {
+  unsigned char* p;
+
+  if (trace->used > TRACE_BUFFER - 10) {
+    trace_flush(trace);
+  }
+  p = trace->buf + trace->used;
+  p = put_u32(p, (uint32_t)maze->width);
+  p = put_u32(p, (uint32_t)maze->height);
+  *p++ = (unsigned char)kind;
+  *p++ = (unsigned char)flags;
+  trace->used = (size_t)(p - trace->buf);
+  trace->prev = -1;
+  trace->steps = 0;
+}
+
+void trace_end(MazeTrace* trace, MazeStatus status) {
+  unsigned char* p;
+
+  if (trace->used > TRACE_BUFFER - TRACE_RECORD_MAX) {
+    trace_flush(trace);
+  }
+  p = trace->buf + trace->used;
+  p = trace_varint(p, 0);
+  p = trace_varint(p, (uint32_t)status);
+  p = trace_varint(p, trace->steps);
+  trace->used = (size_t)(p - trace->buf);
+}
@@ -2,56 +2,50 @@
 
 // =========== VALIDATE ==========
 
-bool validate_maze(const Maze *maze) {
+MazeStatus validate_maze(const Maze *maze) {
   int start_idx, finish_idx;
   int i;
   char c;
 
   // check null
-  if (!maze) {
-    fprintf(stderr, "[ERROR]: Maze is null");
-    return false;
-  }
-
-  if (!maze -> grid) {
-    fprintf(stderr, "[ERROR]: Maze is null");
-    return false;
+  if (!maze || !maze -> grid) {
+    return MAZE_ERR_ARG;
   }
 
   // check dimensions
-  if (maze->width < 1 || maze->width > 10000) {
-    fprintf(stderr, "Error: invalid width %d (must be 1-10000)\n", maze->width);
-    return false;
+  if (maze->width < 1 || maze->width > MAZE_MAX_SIZE) {
+    return MAZE_ERR_SIZE;
   }
     
-  if (maze->height < 1 || maze->height > 10000) {
-    fprintf(stderr, "Error: invalid height %d (must be 1-10000)\n", maze->height);
-    return false;
+  if (maze->height < 1 || maze->height > MAZE_MAX_SIZE) {
+    return MAZE_ERR_SIZE;
   }
 
   // start positions
   start_idx = IDX(0, 0, maze->width);
-  if (maze->grid[start_idx] != '*') {
-    return false;
+  if (!IS_PASSABLE(maze->grid[start_idx])) {
+    return MAZE_NO_PATH;
   }
 
-  // finish position
+  // finish position (multi-target search ends at an exit instead)
   finish_idx = IDX(maze->width - 1, maze->height - 1, maze->width);
 
-  if (maze->grid[finish_idx] != '*') {
-    return false;
+  if (!maze->targets && !IS_PASSABLE(maze->grid[finish_idx])) {
+    return MAZE_NO_PATH;
+  }
+
+  // check characters (already done while loading when checked is set)
+  if (maze->checked) {
+    return MAZE_OK;
   }
 
-  // check characters
   for (i = 0; i < maze->width * maze->height; i++) {
     c = maze->grid[i];
 
-    if (c != '*' && c != 'X') {
-      fprintf(stderr, "Error: invalid character '%c' at index %d\n", c, i);
-      fprintf(stderr, "Valid characters are: '*' (free) and 'X' (wall)\n");
-      return false;
+    if (!IS_PASSABLE(c) && c != 'X') {
+      return MAZE_ERR_CHAR;
     }
   }
 
-  return true;
-}
\ No newline at end of file
+  return MAZE_OK;
+}
@@ -0,0 +1,680 @@
+#include "solver.h"
+#include <stdint.h>
+
+// maze-bench: timing and memory regression gate.
+//
+// The corpus is generated in memory from fixed seeds, so every machine
+// benchmarks the same mazes without shipping them. Each case (maze +
+// solver) is solved once to warm up, then timed `runs` times through
+// maze_solve with the default allocator, the path the CLI takes. The
+// timed solves go round-robin over the cases, so a burst of machine
+// noise lands on one sample of many cases rather than on every sample
+// of one. Peak solver memory comes from one more solve through a
+// counting allocator; it does not depend on timing noise.
+//
+// --compare reads a baseline written by --save. A case gets slower when
+// the whole bootstrap 95% interval of (median now / median baseline) is
+// above 1 + threshold, so a noisy run widens the interval instead of
+// failing the gate. Memory regresses when the peak grows by more than
+// the memory threshold.
+//
+// Exit code: 0 no regression, 1 regression, 2 usage or input error.
+
+// timed solves per case
+#define BENCH_RUNS 11
+#define BENCH_RUNS_MAX 1000
+
+// bootstrap resamples of the median ratio
+#define BOOTSTRAP 2000
+
+// default thresholds in percent
+#define TIME_THRESHOLD 10.0
+#define MEM_THRESHOLD 1.0
+
+// the baseline file may hold at most this many cases
+#define BASELINE_MAX 256
+
+typedef enum { GEN_NOISE, GEN_PERFECT, GEN_ROOMS, GEN_WEIGHTED } Generator;
+
+typedef struct {
+  const char* name;
+  Generator gen;
+  int width, height;
+  int percent;    // walls for noise and weighted mazes, room walls noise
+  uint64_t seed;
+} BenchMaze;
+
+typedef struct {
+  int maze;            // index into corpus
+  const char* solver;
+  MazeAlgorithm algo;
+  bool diagonal;
+} BenchCase;
+
+static const BenchMaze corpus[] = {
+  {"perfect_1001", GEN_PERFECT, 1001, 1001, 0, 1},
+  {"noise30_1000", GEN_NOISE, 1000, 1000, 30, 7},
+  {"open10_2000", GEN_NOISE, 2000, 2000, 10, 3},
+  {"rooms_999", GEN_ROOMS, 999, 999, 5, 4},
+  {"weighted_1000", GEN_WEIGHTED, 1000, 1000, 20, 5},
+};
+
+static const BenchCase cases[] = {
+  {0, "bfs", MAZE_ALGO_BFS, false},
+  {0, "astar", MAZE_ALGO_ASTAR, false},
+  {0, "dijkstra", MAZE_ALGO_DIJKSTRA, false},
+  {0, "jps", MAZE_ALGO_JPS, true},
+  {1, "bfs", MAZE_ALGO_BFS, false},
+  {1, "astar", MAZE_ALGO_ASTAR, false},
+  {1, "astar-diag", MAZE_ALGO_ASTAR, true},
+  {1, "jps", MAZE_ALGO_JPS, true},
+  {2, "bfs", MAZE_ALGO_BFS, false},
+  {2, "astar", MAZE_ALGO_ASTAR, false},
+  {2, "jps", MAZE_ALGO_JPS, true},
+  {3, "bfs", MAZE_ALGO_BFS, false},
+  {3, "astar", MAZE_ALGO_ASTAR, false},
+  {4, "astar", MAZE_ALGO_ASTAR, false},
+  {4, "dijkstra", MAZE_ALGO_DIJKSTRA, false},
+};
+
+#define CORPUS_SIZE ((int)(sizeof(corpus) / sizeof(corpus[0])))
+#define CASE_COUNT ((int)(sizeof(cases) / sizeof(cases[0])))
+
+// one measured (or baseline) case
+typedef struct {
+  char key[64];        // "maze/solver"
+  double median_ms;
+  size_t peak_bytes;   // solver allocations on top of the loaded maze
+  int visited;
+  double* samples;     // runs timings in ms
+  int runs;
+} Result;
+
+typedef struct {
+  size_t live_bytes;
+  size_t peak_bytes;
+} Counter;
+
+static void usage(const char* program) {
+  fprintf(stderr, "Usage: %s [OPTIONS]\n", program);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --runs=N             timed solves per case (default: %d)\n", BENCH_RUNS);
+  fprintf(stderr, "  --filter=TEXT        only cases whose maze/solver name contains TEXT\n");
+  fprintf(stderr, "  --save=FILE          write the results as a baseline (JSON)\n");
+  fprintf(stderr, "  --compare=FILE       fail on regressions against a saved baseline\n");
+  fprintf(stderr, "  --threshold=PCT      slowdown tolerated beyond the noise (default: %g)\n",
+          TIME_THRESHOLD);
+  fprintf(stderr, "  --mem-threshold=PCT  peak memory growth tolerated (default: %g)\n",
+          MEM_THRESHOLD);
+}
+
+// monotonic wall clock in ms
+static double now_ms(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// xorshift64*: the same corpus and resamples everywhere
+static uint32_t rng_next(uint64_t* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (uint32_t)((*state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// ======= CORPUS ======
+
+// depth-first backtracker over the even cells, walls between them
+static bool carve_perfect(char* grid, int w, int h, uint64_t* rng) {
+  static const int step_x[4] = {0, 0, -2, 2};
+  static const int step_y[4] = {-2, 2, 0, 0};
+  int* stack = malloc((size_t)(w / 2 + 1) * (h / 2 + 1) * sizeof(int));
+  int top = 0;
+  int cell, x, y, nx, ny, d, k, open;
+  int options[4];
+
+  if (!stack) {
+    return false;
+  }
+  memset(grid, 'X', (size_t)w * h);
+  grid[0] = '*';
+  stack[top++] = 0;
+  while (top > 0) {
+    cell = stack[top - 1];
+    x = cell % w;
+    y = cell / w;
+    open = 0;
+    for (d = 0; d < 4; d++) {
+      nx = x + step_x[d];
+      ny = y + step_y[d];
+      if (nx >= 0 && nx < w && ny >= 0 && ny < h && grid[IDX(nx, ny, w)] == 'X') {
+        options[open++] = d;
+      }
+    }
+    if (open == 0) {
+      top--;
+      continue;
+    }
+    k = options[rng_next(rng) % open];
+    nx = x + step_x[k];
+    ny = y + step_y[k];
+    grid[IDX(x + step_x[k] / 2, y + step_y[k] / 2, w)] = '*';
+    grid[IDX(nx, ny, w)] = '*';
+    stack[top++] = IDX(nx, ny, w);
+  }
+  free(stack);
+  return true;
+}
+
+// square rooms of side 40 with one door per shared wall, noise inside
+static void carve_rooms(char* grid, int w, int h, int percent, uint64_t* rng) {
+  const int room = 40;
+  int x, y, door;
+
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      grid[IDX(x, y, w)] = x % room == room - 1 || y % room == room - 1 ? 'X'
+                         : (int)(rng_next(rng) % 100) < percent ? 'X' : '*';
+    }
+  }
+  for (y = 0; y < h; y += room) {
+    for (x = 0; x < w; x += room) {
+      door = (int)(rng_next(rng) % (room - 1));
+      if (x + room - 1 < w && y + door < h) {
+        grid[IDX(x + room - 1, y + door, w)] = '*';
+      }
+      door = (int)(rng_next(rng) % (room - 1));
+      if (y + room - 1 < h && x + door < w) {
+        grid[IDX(x + door, y + room - 1, w)] = '*';
+      }
+    }
+  }
+}
+
+// maze text of corpus entry m ('\n' after every row), NULL on failure
+static char* generate(const BenchMaze* m, size_t* size) {
+  uint64_t rng = m->seed * 0x9E3779B97F4A7C15ULL + 1;
+  char* grid = malloc((size_t)m->width * m->height);
+  char* text;
+  int x, y;
+  uint32_t r;
+
+  if (!grid) {
+    return NULL;
+  }
+  if (m->gen == GEN_PERFECT) {
+    if (!carve_perfect(grid, m->width, m->height, &rng)) {
+      free(grid);
+      return NULL;
+    }
+  } else if (m->gen == GEN_ROOMS) {
+    carve_rooms(grid, m->width, m->height, m->percent, &rng);
+  } else {
+    for (y = 0; y < m->height; y++) {
+      for (x = 0; x < m->width; x++) {
+        r = rng_next(&rng) % 100;
+        grid[IDX(x, y, m->width)] = (int)r < m->percent ? 'X'
+                                  : m->gen == GEN_WEIGHTED ? (char)('1' + rng_next(&rng) % 9)
+                                  : '*';
+      }
+    }
+  }
+  grid[0] = '*';
+  grid[(size_t)m->width * m->height - 1] = '*';
+
+  *size = (size_t)(m->width + 1) * m->height;
+  text = malloc(*size);
+  if (text) {
+    for (y = 0; y < m->height; y++) {
+      memcpy(text + (size_t)y * (m->width + 1), grid + (size_t)y * m->width, (size_t)m->width);
+      text[(size_t)y * (m->width + 1) + m->width] = '\n';
+    }
+  }
+  free(grid);
+  return text;
+}
+
+// ======= MEASURING ======
+
+static void* count_alloc(void* ctx, size_t size) {
+  Counter* c = ctx;
+  void* ptr = malloc(size);
+
+  if (ptr) {
+    c->live_bytes += size;
+    if (c->live_bytes > c->peak_bytes) {
+      c->peak_bytes = c->live_bytes;
+    }
+  }
+  return ptr;
+}
+
+static void* count_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+  Counter* c = ctx;
+  void* grown = realloc(ptr, new_size);
+
+  if (grown) {
+    c->live_bytes += new_size - old_size;
+    if (c->live_bytes > c->peak_bytes) {
+      c->peak_bytes = c->live_bytes;
+    }
+  }
+  return grown;
+}
+
+static void count_free(void* ctx, void* ptr, size_t size) {
+  Counter* c = ctx;
+
+  c->live_bytes -= size;
+  free(ptr);
+}
+
+static int compare_double(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+
+  return (x > y) - (x < y);
+}
+
+// median of n values (sorts a copy into scratch)
+static double median(const double* values, int n, double* scratch) {
+  memcpy(scratch, values, (size_t)n * sizeof(double));
+  qsort(scratch, (size_t)n, sizeof(double), compare_double);
+  return n % 2 ? scratch[n / 2] : (scratch[n / 2 - 1] + scratch[n / 2]) / 2;
+}
+
+// visited cells and peak solver memory of one case (the latter on a
+// copy of the maze loaded through the counter), plus one warm-up solve
+static MazeStatus prepare_case(const BenchCase* c, Maze* maze, const char* text, size_t size,
+                               Result* out) {
+  SolverOptions opts = { .diagonal = c->diagonal };
+  Counter counter = { 0, 0 };
+  MazeAllocator alloc = { count_alloc, count_realloc, count_free, &counter };
+  SolverStats stats;
+  MazeStatus status;
+  Maze* counted;
+  size_t loaded_bytes;
+
+  status = maze_load_buffer(text, size, &alloc, &counted);
+  if (status != MAZE_OK) {
+    return status;
+  }
+  loaded_bytes = counter.live_bytes;
+  counter.peak_bytes = loaded_bytes;
+  maze_solve(counted, c->algo, &opts, NULL);
+  out->peak_bytes = counter.peak_bytes - loaded_bytes;
+  maze_free(counted);
+
+  status = maze_solve(maze, c->algo, &opts, &stats);
+  out->visited = stats.cells_visited;
+  return status == MAZE_NO_PATH ? MAZE_OK : status;
+}
+
+// wall time of one solve (default allocator, the path the CLI takes)
+static double time_case(const BenchCase* c, Maze* maze) {
+  SolverOptions opts = { .diagonal = c->diagonal };
+  double start = now_ms();
+
+  maze_solve(maze, c->algo, &opts, NULL);
+  return now_ms() - start;
+}
+
+// ======= BASELINE ======
+
+static void save_results(FILE* out, const Result* results, int count, int runs) {
+  int i, j;
+
+  fprintf(out, "{\n  \"format\": \"maze-bench 1\",\n  \"runs\": %d,\n  \"cases\": [\n", runs);
+  for (i = 0; i < count; i++) {
+    fprintf(out, "    {\"case\": \"%s\", \"median_ms\": %.4f, \"peak_bytes\": %zu, "
+            "\"visited\": %d, \"samples_ms\": [", results[i].key, results[i].median_ms,
+            results[i].peak_bytes, results[i].visited);
+    for (j = 0; j < results[i].runs; j++) {
+      fprintf(out, "%s%.4f", j ? ", " : "", results[i].samples[j]);
+    }
+    fprintf(out, "]}%s\n", i + 1 < count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+// number after "name": on line (false if missing)
+static bool json_number(const char* line, const char* name, double* out) {
+  const char* p = strstr(line, name);
+  char* end;
+
+  if (!p) {
+    return false;
+  }
+  *out = strtod(p + strlen(name), &end);
+  return end != p + strlen(name);
+}
+
+// the case lines written by save_results; count = -1 on a bad file
+static Result* load_baseline(const char* filename, int* count) {
+  FILE* fp = fopen(filename, "r");
+  Result* results = calloc(BASELINE_MAX, sizeof(Result));
+  Result* r;
+  char* line = NULL;
+  size_t line_size = 0;
+  const char* p;
+  char* end;
+  double v;
+  int n = 0;
+  bool bad = false;
+
+  *count = -1;
+  if (!fp || !results) {
+    if (fp) {
+      fclose(fp);
+    }
+    free(results);
+    return NULL;
+  }
+  while (!bad && getline(&line, &line_size, fp) > 0) {
+    p = strstr(line, "{\"case\": \"");
+    if (!p) {
+      continue;
+    }
+    if (n == BASELINE_MAX) {
+      bad = true;
+      break;
+    }
+    r = &results[n];
+    p += 10;
+    end = strchr(p, '"');
+    if (!end || end - p >= (long)sizeof(r->key)) {
+      bad = true;
+      break;
+    }
+    memcpy(r->key, p, (size_t)(end - p));
+    r->key[end - p] = '\0';
+    if (!json_number(line, "\"median_ms\":", &r->median_ms)
+        || !json_number(line, "\"peak_bytes\":", &v)) {
+      bad = true;
+      break;
+    }
+    r->peak_bytes = (size_t)v;
+    r->visited = json_number(line, "\"visited\":", &v) ? (int)v : 0;
+
+    p = strstr(line, "\"samples_ms\": [");
+    r->samples = malloc(BENCH_RUNS_MAX * sizeof(double));
+    if (!p || !r->samples) {
+      bad = true;
+      break;
+    }
+    p += 15;
+    while (r->runs < BENCH_RUNS_MAX) {
+      r->samples[r->runs] = strtod(p, &end);
+      if (end == p) {
+        break;
+      }
+      r->runs++;
+      p = end;
+      while (*p == ',' || *p == ' ') {
+        p++;
+      }
+    }
+    bad = r->runs == 0;
+    n++;
+  }
+  free(line);
+  fclose(fp);
+  *count = bad ? -1 : n;
+  return results;
+}
+
+static void free_results(Result* results, int count) {
+  int i;
+
+  for (i = 0; results && i < count; i++) {
+    free(results[i].samples);
+  }
+  free(results);
+}
+
+// bootstrap 95% interval of median(now) / median(base)
+static void ratio_interval(const Result* now, const Result* base, double* lo, double* hi) {
+  double* ratios = malloc(BOOTSTRAP * sizeof(double));
+  double* a = malloc((size_t)(now->runs + base->runs) * sizeof(double));
+  double* scratch = malloc((size_t)(now->runs + base->runs) * sizeof(double));
+  uint64_t rng = 0x5EED;
+  double base_median;
+  int i, j;
+
+  if (!ratios || !a || !scratch) {
+    *lo = *hi = now->median_ms / base->median_ms;
+  } else {
+    for (i = 0; i < BOOTSTRAP; i++) {
+      for (j = 0; j < base->runs; j++) {
+        a[j] = base->samples[rng_next(&rng) % base->runs];
+      }
+      base_median = median(a, base->runs, scratch);
+      for (j = 0; j < now->runs; j++) {
+        a[j] = now->samples[rng_next(&rng) % now->runs];
+      }
+      ratios[i] = base_median > 0 ? median(a, now->runs, scratch) / base_median : 1.0;
+    }
+    qsort(ratios, BOOTSTRAP, sizeof(double), compare_double);
+    *lo = ratios[(int)(BOOTSTRAP * 0.025)];
+    *hi = ratios[(int)(BOOTSTRAP * 0.975) - 1];
+  }
+  free(ratios);
+  free(a);
+  free(scratch);
+}
+
+// diff table of the cases in only (NULL = all); slow[i] is set for the
+// cases slower beyond the noise, returns the number of memory regressions
+static int compare_results(const Result* now, int count, const Result* base, int base_count,
+                           double threshold, double mem_threshold, const bool* only,
+                           bool* slow) {
+  const Result* b;
+  const char* verdict;
+  double lo, hi;
+  int regressions = 0;
+  int i, j;
+
+  printf("\n%-26s %9s %9s %6s %15s %9s %9s  %s\n", "case", "base ms", "now ms", "ratio",
+         "95% CI", "base MB", "now MB", "verdict");
+  for (i = 0; i < count; i++) {
+    slow[i] = false;
+    if (only && !only[i]) {
+      continue;
+    }
+    for (b = NULL, j = 0; j < base_count && !b; j++) {
+      b = strcmp(base[j].key, now[i].key) == 0 ? &base[j] : NULL;
+    }
+    if (!b) {
+      printf("%-26s %9s %9.2f %6s %15s %9s %9.1f  new\n", now[i].key, "-", now[i].median_ms,
+             "-", "-", "-", now[i].peak_bytes / 1048576.0);
+      continue;
+    }
+    ratio_interval(&now[i], b, &lo, &hi);
+    verdict = "ok";
+    if (now[i].peak_bytes > b->peak_bytes * (1 + mem_threshold / 100)) {
+      verdict = "MORE MEMORY";
+      regressions++;
+    } else if (lo > 1 + threshold / 100) {
+      verdict = "SLOWER";
+      slow[i] = true;
+    } else if (hi < 1 - threshold / 100) {
+      verdict = "faster";
+    }
+    if (now[i].visited != b->visited && strcmp(verdict, "ok") == 0) {
+      verdict = "ok (visits changed)";
+    }
+    printf("%-26s %9.2f %9.2f %6.2f    [%4.2f, %4.2f] %9.1f %9.1f  %s\n", now[i].key,
+           b->median_ms, now[i].median_ms, now[i].median_ms / b->median_ms, lo, hi,
+           b->peak_bytes / 1048576.0, now[i].peak_bytes / 1048576.0, verdict);
+  }
+  return regressions;
+}
+
+int main(int argc, char* argv[]) {
+  const char* filter = NULL;
+  const char* save_file = NULL;
+  const char* compare_file = NULL;
+  double threshold = TIME_THRESHOLD;
+  double mem_threshold = MEM_THRESHOLD;
+  long runs = BENCH_RUNS;
+  Result results[CASE_COUNT];
+  const BenchCase* picked[CASE_COUNT];
+  bool slow[CASE_COUNT];
+  bool again[CASE_COUNT];
+  int regressions, slow_count;
+  Result* base = NULL;
+  int base_count = 0;
+  int count = 0;
+  Maze* mazes[CORPUS_SIZE] = { NULL };
+  char* texts[CORPUS_SIZE] = { NULL };
+  size_t sizes[CORPUS_SIZE] = { 0 };
+  double scratch[BENCH_RUNS_MAX];
+  char key[64];
+  char* end;
+  MazeStatus status;
+  FILE* out;
+  int exit_code = 0;
+  int i, m, r;
+
+  for (i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--runs=", 7) == 0) {
+      runs = strtol(argv[i] + 7, &end, 10);
+      if (end == argv[i] + 7 || *end || runs < 1 || runs > BENCH_RUNS_MAX) {
+        fprintf(stderr, "Invalid run count: %s (1-%d)\n", argv[i] + 7, BENCH_RUNS_MAX);
+        return 2;
+      }
+    } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else if (strncmp(argv[i], "--save=", 7) == 0) {
+      save_file = argv[i] + 7;
+    } else if (strncmp(argv[i], "--compare=", 10) == 0) {
+      compare_file = argv[i] + 10;
+    } else if (strncmp(argv[i], "--threshold=", 12) == 0) {
+      threshold = strtod(argv[i] + 12, &end);
+      if (end == argv[i] + 12 || *end || threshold < 0) {
+        fprintf(stderr, "Invalid threshold: %s\n", argv[i] + 12);
+        return 2;
+      }
+    } else if (strncmp(argv[i], "--mem-threshold=", 16) == 0) {
+      mem_threshold = strtod(argv[i] + 16, &end);
+      if (end == argv[i] + 16 || *end || mem_threshold < 0) {
+        fprintf(stderr, "Invalid memory threshold: %s\n", argv[i] + 16);
+        return 2;
+      }
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[i]);
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  // a missing baseline fails before minutes of benchmarking
+  if (compare_file) {
+    base = load_baseline(compare_file, &base_count);
+    if (base_count < 0) {
+      fprintf(stderr, "[ERROR]: cannot read baseline %s\n", compare_file);
+      free_results(base, BASELINE_MAX);
+      return 2;
+    }
+  }
+
+  // the picked cases, their mazes generated once, memory and warm-up
+  for (i = 0; i < CASE_COUNT; i++) {
+    snprintf(key, sizeof(key), "%s/%s", corpus[cases[i].maze].name, cases[i].solver);
+    if (filter && !strstr(key, filter)) {
+      continue;
+    }
+    m = cases[i].maze;
+    if (!mazes[m]) {
+      texts[m] = generate(&corpus[m], &sizes[m]);
+      status = texts[m] ? maze_load_buffer(texts[m], sizes[m], NULL, &mazes[m]) : MAZE_ERR_NOMEM;
+      if (status != MAZE_OK) {
+        fprintf(stderr, "[ERROR]: %s: %s\n", corpus[m].name, maze_strerror(status));
+        exit_code = 2;
+        break;
+      }
+    }
+
+    memset(&results[count], 0, sizeof(Result));
+    strcpy(results[count].key, key);
+    results[count].runs = (int)runs;
+    results[count].samples = malloc((size_t)runs * sizeof(double));
+    status = results[count].samples
+           ? prepare_case(&cases[i], mazes[m], texts[m], sizes[m], &results[count])
+           : MAZE_ERR_NOMEM;
+    if (status != MAZE_OK) {
+      fprintf(stderr, "[ERROR]: %s: %s\n", key, maze_strerror(status));
+      free(results[count].samples);
+      exit_code = 2;
+      break;
+    }
+    picked[count++] = &cases[i];
+  }
+
+  // timed solves, one round over every case at a time
+  for (r = 0; exit_code == 0 && r < runs; r++) {
+    for (i = 0; i < count; i++) {
+      results[i].samples[r] = time_case(picked[i], mazes[picked[i]->maze]);
+    }
+  }
+  for (i = 0; exit_code == 0 && i < count; i++) {
+    results[i].median_ms = median(results[i].samples, (int)runs, scratch);
+    fprintf(stderr, "  %-26s %9.2f ms %9.1f MB %10d visited\n", results[i].key,
+            results[i].median_ms, results[i].peak_bytes / 1048576.0, results[i].visited);
+  }
+  if (exit_code == 0 && save_file) {
+    out = fopen(save_file, "w");
+    if (!out) {
+      fprintf(stderr, "[ERROR]: cannot write %s\n", save_file);
+      exit_code = 2;
+    } else {
+      save_results(out, results, count, (int)runs);
+      if (fclose(out) != 0) {
+        fprintf(stderr, "[ERROR]: cannot write %s\n", save_file);
+        exit_code = 2;
+      }
+    }
+  }
+  // a slowdown counts only if fresh rounds of the same cases confirm
+  // it: a busy neighbor can slow a whole run down, not two in a row
+  if (exit_code == 0 && compare_file) {
+    regressions = compare_results(results, count, base, base_count, threshold, mem_threshold,
+                                  NULL, slow);
+    for (slow_count = 0, i = 0; i < count; i++) {
+      slow_count += slow[i];
+    }
+    if (slow_count) {
+      printf("\nTiming %d slower cases again...\n", slow_count);
+      memcpy(again, slow, sizeof(slow));
+      for (r = 0; r < runs; r++) {
+        for (i = 0; i < count; i++) {
+          if (again[i]) {
+            results[i].samples[r] = time_case(picked[i], mazes[picked[i]->maze]);
+          }
+        }
+      }
+      for (i = 0; i < count; i++) {
+        results[i].median_ms = median(results[i].samples, (int)runs, scratch);
+      }
+      compare_results(results, count, base, base_count, threshold, mem_threshold, again, slow);
+      for (i = 0; i < count; i++) {
+        regressions += slow[i];
+      }
+    }
+    printf("\n%d of %d cases regressed (time threshold %g%%, memory %g%%)\n", regressions,
+           count, threshold, mem_threshold);
+    exit_code = regressions ? 1 : 0;
+  }
+
+  for (m = 0; m < CORPUS_SIZE; m++) {
+    maze_free(mazes[m]);
+    free(texts[m]);
+  }
+  for (i = 0; i < count; i++) {
+    free(results[i].samples);
+  }
+  free_results(base, base_count > 0 ? base_count : 0);
+  return exit_code;
+}
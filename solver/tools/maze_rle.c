@@ -0,0 +1,304 @@
+#include "solver.h"
+
+// maze-rle: convert maze files between ASCII rows and the run-length
+// text the loader also reads (format in solver.h). The direction comes
+// from the input: run-length text is decoded, anything else encoded.
+//
+// Both directions stream and never hold a row, so files past the
+// solver's 10000x10000 limit convert too. Encoding reads its input
+// twice (the header needs the height first) and so takes a file; decoding
+// also reads stdin. Each encoded row ends with a newline and its runs
+// stop at the row end, so rows can still be told apart by eye.
+//
+// Exit code: 0 done, 1 malformed maze, 2 usage or I/O error.
+
+#define STREAM_BUF (1 << 20)
+
+typedef struct {
+  FILE* fp;
+  unsigned char* buf;
+  size_t pos;
+  size_t len;
+  size_t total;  // bytes read so far
+} Stream;
+
+static void usage(const char* program) {
+  fprintf(stderr, "Usage: %s <maze_file|-> <output_file|->\n", program);
+  fprintf(stderr, "  ASCII input is encoded to run-length text (\"%s W H\" header),\n", RLE_MAGIC);
+  fprintf(stderr, "  run-length input is decoded to ASCII rows. - = stdin/stdout\n");
+  fprintf(stderr, "  (encoding reads its input twice and needs a file)\n");
+}
+
+// ======= INPUT ======
+
+static inline int stream_peek(Stream* s) {
+  if (s->pos == s->len) {
+    s->len = fread(s->buf, 1, STREAM_BUF, s->fp);
+    s->pos = 0;
+    if (s->len == 0) {
+      return EOF;
+    }
+  }
+  return s->buf[s->pos];
+}
+
+static inline int stream_get(Stream* s) {
+  int c = stream_peek(s);
+
+  if (c != EOF) {
+    s->pos++;
+    s->total++;
+  }
+  return c;
+}
+
+static bool is_cell(int c) {
+  return c == '*' || c == 'X' || c == 'E' || (c >= '1' && c <= '9');
+}
+
+// decimal count at the stream (at most 11 digits), false if there is none
+static bool read_count(Stream* s, size_t* out) {
+  size_t n = 0;
+  int digits = 0;
+  int c;
+
+  while ((c = stream_peek(s)) >= '0' && c <= '9') {
+    if (++digits > 11) {
+      return false;
+    }
+    n = n * 10 + (size_t)(c - '0');
+    stream_get(s);
+  }
+  *out = n;
+  return digits > 0;
+}
+
+// ======= ENCODE ======
+
+static void put_run(FILE* out, int symbol, size_t count) {
+  if (count > 1) {
+    fprintf(out, "%zu", count);
+  }
+  if (symbol >= '1' && symbol <= '9') {
+    putc('#', out);
+  }
+  putc(symbol, out);
+}
+
+// pass 1: width, height and a check of every row; false on a bad maze
+static bool measure(Stream* s, size_t* width, size_t* height) {
+  size_t x = 0;
+  size_t row = 0;
+  int c;
+
+  *width = 0;
+  while ((c = stream_get(s)) != EOF) {
+    if (c == '\n') {
+      if (row == 0) {
+        *width = x;
+      }
+      if (x == 0 || x < *width) {
+        fprintf(stderr, "[ERROR]: row %zu: shorter than the first row\n", row + 1);
+        return false;
+      }
+      row++;
+      x = 0;
+      continue;
+    }
+    if ((row == 0 || x < *width) && !is_cell(c)) {
+      fprintf(stderr, "[ERROR]: row %zu: invalid character '%c'\n", row + 1, c);
+      return false;
+    }
+    x++;
+  }
+  // last row without a newline
+  if (x > 0) {
+    if (row == 0) {
+      *width = x;
+    } else if (x < *width) {
+      fprintf(stderr, "[ERROR]: row %zu: shorter than the first row\n", row + 1);
+      return false;
+    }
+    row++;
+  }
+  *height = row;
+  if (row == 0) {
+    fprintf(stderr, "[ERROR]: empty maze\n");
+    return false;
+  }
+  return true;
+}
+
+// pass 2: the first width cells of each row as runs, one line per row
+static void encode(Stream* s, FILE* out, size_t width, size_t height) {
+  size_t x = 0;
+  size_t count = 0;
+  int symbol = 0;
+  int c;
+
+  fprintf(out, "%s %zu %zu\n", RLE_MAGIC, width, height);
+  while ((c = stream_get(s)) != EOF) {
+    if (c == '\n') {
+      put_run(out, symbol, count);
+      putc('\n', out);
+      x = 0;
+      count = 0;
+      continue;
+    }
+    if (x++ >= width) {
+      continue;
+    }
+    if (count && c != symbol) {
+      put_run(out, symbol, count);
+      count = 0;
+    }
+    symbol = c;
+    count++;
+  }
+  if (x > 0) {
+    put_run(out, symbol, count);
+    putc('\n', out);
+  }
+}
+
+// ======= DECODE ======
+
+// the runs after the header as ASCII rows; false on a bad maze
+static bool decode(Stream* s, FILE* out) {
+  char block[4096];
+  size_t width, height, count, n;
+  size_t x = 0;
+  size_t row = 0;
+  int symbol;
+
+  for (n = 0; n < 5; n++) {
+    stream_get(s);
+  }
+  if (!read_count(s, &width) || stream_get(s) != ' ' || !read_count(s, &height)
+      || stream_get(s) != '\n' || width == 0 || height == 0) {
+    fprintf(stderr, "[ERROR]: bad header, expected \"%s <width> <height>\"\n", RLE_MAGIC);
+    return false;
+  }
+
+  while ((symbol = stream_peek(s)) != EOF) {
+    if (symbol == ' ' || symbol == '\n' || symbol == '\r' || symbol == '\t') {
+      stream_get(s);
+      continue;
+    }
+    count = 1;
+    if (symbol >= '0' && symbol <= '9' && (!read_count(s, &count) || count == 0)) {
+      fprintf(stderr, "[ERROR]: byte %zu: bad run length\n", s->total);
+      return false;
+    }
+    symbol = stream_get(s);
+    if (symbol == '#') {
+      symbol = stream_get(s);
+      if (symbol < '1' || symbol > '9') {
+        fprintf(stderr, "[ERROR]: byte %zu: '#' needs a terrain digit\n", s->total);
+        return false;
+      }
+    } else if (symbol != '*' && symbol != 'X' && symbol != 'E') {
+      fprintf(stderr, "[ERROR]: byte %zu: invalid run symbol\n", s->total);
+      return false;
+    }
+    if (count > (height - row) * width - x) {
+      fprintf(stderr, "[ERROR]: byte %zu: runs go past %zux%zu cells\n", s->total, width, height);
+      return false;
+    }
+
+    // split the run at row ends
+    memset(block, symbol, count < sizeof(block) ? count : sizeof(block));
+    while (count > 0) {
+      n = width - x < count ? width - x : count;
+      n = n < sizeof(block) ? n : sizeof(block);
+      fwrite(block, 1, n, out);
+      count -= n;
+      x += n;
+      if (x == width) {
+        putc('\n', out);
+        x = 0;
+        row++;
+      }
+    }
+  }
+  if (row < height) {
+    fprintf(stderr, "[ERROR]: runs end after %zu of %zu rows\n", row, height);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  Stream stream = { 0 };
+  size_t width, height;
+  FILE* out;
+  bool rle;
+  bool bad = false;
+  bool ok = true;
+
+  if (argc != 3) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  stream.fp = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+  stream.buf = malloc(STREAM_BUF);
+  if (!stream.fp || !stream.buf) {
+    fprintf(stderr, "[ERROR]: cannot read maze %s\n", argv[1]);
+    if (stream.fp && stream.fp != stdin) {
+      fclose(stream.fp);
+    }
+    free(stream.buf);
+    return 2;
+  }
+
+  // the header decides the direction (peeking fills the first buffer)
+  stream_peek(&stream);
+  rle = stream.len >= 5 && memcmp(stream.buf, RLE_MAGIC " ", 5) == 0;
+  if (!rle && stream.fp == stdin) {
+    fprintf(stderr, "[ERROR]: encoding reads the maze twice, give a file\n");
+    free(stream.buf);
+    return 2;
+  }
+
+  if (!rle) {
+    if (!measure(&stream, &width, &height)) {
+      fclose(stream.fp);
+      free(stream.buf);
+      return 1;
+    }
+    rewind(stream.fp);
+    stream.pos = 0;
+    stream.len = 0;
+    stream.total = 0;
+  }
+
+  out = strcmp(argv[2], "-") == 0 ? stdout : fopen(argv[2], "wb");
+  if (!out) {
+    fprintf(stderr, "[ERROR]: cannot write %s\n", argv[2]);
+    if (stream.fp != stdin) {
+      fclose(stream.fp);
+    }
+    free(stream.buf);
+    return 2;
+  }
+
+  if (rle) {
+    bad = !decode(&stream, out);
+  } else {
+    encode(&stream, out, width, height);
+  }
+  if (ferror(stream.fp)) {
+    fprintf(stderr, "[ERROR]: cannot read maze %s\n", argv[1]);
+    ok = false;
+  }
+  if ((out == stdout ? fflush(out) : fclose(out)) != 0) {
+    fprintf(stderr, "[ERROR]: cannot write %s\n", argv[2]);
+    ok = false;
+  }
+  if (stream.fp != stdin) {
+    fclose(stream.fp);
+  }
+  free(stream.buf);
+  return bad ? 1 : ok ? 0 : 2;
+}
@@ -0,0 +1,340 @@
+#include "solver.h"
+#include "trace.h"
+
+// maze-trace: read a search trace written with --trace (format in
+// trace.h) and summarize it, or turn one of its searches into a heatmap
+// of the expansion order (binary PGM) or a Chrome trace (JSON for
+// chrome://tracing or Perfetto, one microsecond per expansion).
+//
+// The trace is streamed and never held whole. A first pass checks every
+// search block and sizes the outputs, a second one writes them.
+//
+// Exit code: 0 done, 1 malformed trace, 2 usage or I/O error.
+
+#define STREAM_BUF (1 << 20)
+
+// most counter samples per search in the Chrome trace without --every
+#define CHROME_SAMPLES 100000
+
+static const char* kind_name[] = {"BFS", "A*", "Dijkstra"};
+
+typedef struct {
+  FILE* fp;
+  unsigned char* buf;
+  size_t pos;
+  size_t len;
+} Stream;
+
+// one search block as read from the trace
+typedef struct {
+  uint32_t width, height;
+  int kind;
+  int flags;
+  uint32_t steps;
+  uint32_t max_frontier;
+  uint32_t max_g;
+  uint32_t status;
+} Search;
+
+typedef struct {
+  int cell;
+  uint32_t g, f;
+  uint32_t frontier;
+} Step;
+
+static void usage(const char* program) {
+  fprintf(stderr, "Usage: %s <trace_file> [OPTIONS]\n", program);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --search=N        search of the trace to convert (default: 1)\n");
+  fprintf(stderr, "  --heatmap=FILE    expansion order as a PGM image (early = bright)\n");
+  fprintf(stderr, "  --chrome=FILE     frontier size and g/f per expansion as Chrome trace JSON\n");
+  fprintf(stderr, "  --every=N         one Chrome sample per N expansions (default: at most %d)\n",
+          CHROME_SAMPLES);
+}
+
+// ======= INPUT ======
+
+static inline int stream_peek(Stream* s) {
+  if (s->pos == s->len) {
+    s->len = fread(s->buf, 1, STREAM_BUF, s->fp);
+    s->pos = 0;
+    if (s->len == 0) {
+      return EOF;
+    }
+  }
+  return s->buf[s->pos];
+}
+
+static inline int stream_get(Stream* s) {
+  int c = stream_peek(s);
+
+  if (c != EOF) {
+    s->pos++;
+  }
+  return c;
+}
+
+static void stream_rewind(Stream* s) {
+  rewind(s->fp);
+  s->pos = 0;
+  s->len = 0;
+}
+
+static bool read_u32(Stream* s, uint32_t* out) {
+  uint32_t v = 0;
+  int i, c;
+
+  for (i = 0; i < 4; i++) {
+    if ((c = stream_get(s)) == EOF) {
+      return false;
+    }
+    v |= (uint32_t)c << (8 * i);
+  }
+  *out = v;
+  return true;
+}
+
+static bool read_varint(Stream* s, uint32_t* out) {
+  uint32_t v = 0;
+  int shift, c;
+
+  for (shift = 0; shift < 35; shift += 7) {
+    if ((c = stream_get(s)) == EOF) {
+      return false;
+    }
+    v |= (uint32_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) {
+      *out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+// search header; false at the end of the trace (*bad on a torn header)
+static bool read_header(Stream* s, Search* search, bool* bad) {
+  int kind, flags;
+
+  if (stream_peek(s) == EOF) {
+    return false;
+  }
+  if (!read_u32(s, &search->width) || !read_u32(s, &search->height)
+      || (kind = stream_get(s)) == EOF || (flags = stream_get(s)) == EOF
+      || search->width == 0 || search->height == 0 || kind > TRACE_DIJKSTRA) {
+    *bad = true;
+    return false;
+  }
+  search->kind = kind;
+  search->flags = flags;
+  search->steps = 0;
+  search->max_frontier = 0;
+  search->max_g = 0;
+  search->status = 0;
+  return true;
+}
+
+// next expansion of the search; false at its end record (*bad if torn)
+static bool read_step(Stream* s, Search* search, Step* step, bool* bad) {
+  uint32_t zigzag, h, steps;
+  int32_t delta;
+
+  if (!read_varint(s, &zigzag)) {
+    *bad = true;
+    return false;
+  }
+  if (zigzag == 0) {
+    *bad = !read_varint(s, &search->status) || !read_varint(s, &steps) || steps != search->steps;
+    return false;
+  }
+  delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+  step->cell += delta;
+  if (!read_varint(s, &step->g) || !read_varint(s, &h) || !read_varint(s, &step->frontier)
+      || step->cell < 0 || (uint64_t)step->cell >= (uint64_t)search->width * search->height) {
+    *bad = true;
+    return false;
+  }
+  step->f = step->g + h;
+  search->steps++;
+  return true;
+}
+
+// ======= OUTPUT ======
+
+static void print_search(int n, const Search* search) {
+  printf("search %d: %s%s%s%s %ux%u, %u expansions, max frontier %u, max g %u, %s\n", n,
+         kind_name[search->kind], search->flags & TRACE_LANDMARKS ? " (ALT)" : "",
+         search->flags & TRACE_DIAGONAL ? " diagonal" : "",
+         search->flags & TRACE_MULTI ? " multi-exit" : "", search->width, search->height,
+         search->steps, search->max_frontier, search->max_g,
+         search->status == MAZE_OK ? "path found" : maze_strerror((MazeStatus)search->status));
+}
+
+// shade by expansion order, 255 first down to 64 last, 0 = never expanded
+static bool write_heatmap(FILE* out, Stream* s, Search* search, uint32_t steps) {
+  size_t cells = (size_t)search->width * search->height;
+  unsigned char* image = calloc(cells, 1);
+  Step step = { .cell = -1 };
+  bool bad = false;
+  uint32_t i = 0;
+
+  if (!image) {
+    return false;
+  }
+  while (read_step(s, search, &step, &bad)) {
+    image[step.cell] = (unsigned char)(255 - (uint64_t)191 * i++ / (steps > 1 ? steps - 1 : 1));
+  }
+  fprintf(out, "P5\n%u %u\n255\n", search->width, search->height);
+  fwrite(image, 1, cells, out);
+  free(image);
+  return !bad;
+}
+
+static bool write_chrome(FILE* out, Stream* s, Search* search, uint32_t steps, uint32_t every) {
+  Step step = { .cell = -1 };
+  bool bad = false;
+  uint32_t i = 0;
+
+  fprintf(out, "{\"traceEvents\":[\n");
+  fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s %ux%u\"}},\n",
+          kind_name[search->kind], search->width, search->height);
+  fprintf(out, "{\"name\":\"search\",\"ph\":\"X\",\"ts\":0,\"dur\":%u,\"pid\":1,\"tid\":1}", steps);
+  while (read_step(s, search, &step, &bad)) {
+    if (i % every == 0 || i + 1 == steps) {
+      fprintf(out, ",\n{\"name\":\"frontier\",\"ph\":\"C\",\"ts\":%u,\"pid\":1,\"args\":{\"open\":%u}}",
+              i, step.frontier);
+      fprintf(out, ",\n{\"name\":\"cost\",\"ph\":\"C\",\"ts\":%u,\"pid\":1,\"args\":{\"g\":%u,\"f\":%u}}",
+              i, step.g, step.f);
+    }
+    i++;
+  }
+  fprintf(out, "\n]}\n");
+  return !bad;
+}
+
+int main(int argc, char* argv[]) {
+  Stream stream = { 0 };
+  Search search;
+  Step step;
+  const char* heatmap_file = NULL;
+  const char* chrome_file = NULL;
+  long pick = 1;
+  long every = 0;
+  uint32_t pick_steps = 0;
+  char magic[4];
+  char* end;
+  FILE* out;
+  bool bad = false;
+  bool ok = true;
+  int n, i;
+
+  if (argc < 2) {
+    usage(argv[0]);
+    return 2;
+  }
+  for (i = 2; i < argc; i++) {
+    if (strncmp(argv[i], "--search=", 9) == 0) {
+      pick = strtol(argv[i] + 9, &end, 10);
+      if (end == argv[i] + 9 || *end || pick < 1) {
+        fprintf(stderr, "Invalid search: %s\n", argv[i] + 9);
+        return 2;
+      }
+    } else if (strncmp(argv[i], "--every=", 8) == 0) {
+      every = strtol(argv[i] + 8, &end, 10);
+      if (end == argv[i] + 8 || *end || every < 1) {
+        fprintf(stderr, "Invalid sampling: %s\n", argv[i] + 8);
+        return 2;
+      }
+    } else if (strncmp(argv[i], "--heatmap=", 10) == 0) {
+      heatmap_file = argv[i] + 10;
+    } else if (strncmp(argv[i], "--chrome=", 9) == 0) {
+      chrome_file = argv[i] + 9;
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[i]);
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  stream.fp = fopen(argv[1], "rb");
+  stream.buf = malloc(STREAM_BUF);
+  if (!stream.fp || !stream.buf) {
+    fprintf(stderr, "[ERROR]: cannot read trace %s\n", argv[1]);
+    if (stream.fp) {
+      fclose(stream.fp);
+    }
+    free(stream.buf);
+    return 2;
+  }
+
+  // pass 1: check and summarize every search
+  for (i = 0; i < 4; i++) {
+    magic[i] = (char)stream_get(&stream);
+  }
+  if (memcmp(magic, TRACE_MAGIC, 4) != 0) {
+    printf("INVALID: not a search trace\n");
+    fclose(stream.fp);
+    free(stream.buf);
+    return 1;
+  }
+  for (n = 1; read_header(&stream, &search, &bad); n++) {
+    step.cell = -1;
+    while (read_step(&stream, &search, &step, &bad)) {
+      search.max_frontier = step.frontier > search.max_frontier ? step.frontier : search.max_frontier;
+      search.max_g = step.g > search.max_g ? step.g : search.max_g;
+    }
+    if (bad) {
+      break;
+    }
+    print_search(n, &search);
+    if (n == pick) {
+      pick_steps = search.steps;
+    }
+  }
+  if (bad) {
+    printf("INVALID: search %d is torn or corrupt\n", n);
+    ok = false;
+  } else if ((heatmap_file || chrome_file) && pick >= n) {
+    fprintf(stderr, "[ERROR]: the trace holds %d searches\n", n - 1);
+    fclose(stream.fp);
+    free(stream.buf);
+    return 2;
+  }
+
+  // pass 2: the picked search, once per output
+  for (i = 0; ok && i < 2; i++) {
+    if (!(i == 0 ? heatmap_file : chrome_file)) {
+      continue;
+    }
+    out = fopen(i == 0 ? heatmap_file : chrome_file, "wb");
+    if (!out) {
+      fprintf(stderr, "[ERROR]: cannot write %s\n", i == 0 ? heatmap_file : chrome_file);
+      ok = false;
+      break;
+    }
+    stream_rewind(&stream);
+    for (n = 0; n < 4; n++) {
+      stream_get(&stream);
+    }
+    for (n = 1; n < pick; n++) {
+      read_header(&stream, &search, &bad);
+      step.cell = -1;
+      while (read_step(&stream, &search, &step, &bad)) {
+      }
+    }
+    read_header(&stream, &search, &bad);
+    if (i == 0) {
+      ok = write_heatmap(out, &stream, &search, pick_steps);
+    } else {
+      ok = write_chrome(out, &stream, &search, pick_steps,
+                        every ? (uint32_t)every : pick_steps / CHROME_SAMPLES + 1);
+    }
+    if (fclose(out) != 0 || !ok) {
+      fprintf(stderr, "[ERROR]: cannot write %s\n", i == 0 ? heatmap_file : chrome_file);
+      ok = false;
+    }
+  }
+
+  fclose(stream.fp);
+  free(stream.buf);
+  return ok ? 0 : bad ? 1 : 2;
+}
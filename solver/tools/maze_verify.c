@@ -0,0 +1,559 @@
+#include "solver.h"
+#include "movement.h"
+#include <stdarg.h>
+#include <stdint.h>
+
+// maze-verify: check solver output against the maze it was solved on.
+//
+// The maze goes through the solver's own loader; the solution is
+// streamed in STREAM_BUF chunks and never held whole. Path formats
+// (coords, moves, rle, binary) are replayed move by move with the
+// solver's movement rules. A rendered grid must equal the maze except
+// for 'o' cells on open ground; the 'o' cells must then form one
+// connected set holding start and finish. Optimality is checked against
+// the BFS distance (fewest cells) or the Dijkstra cost.
+//
+// Exit code: 0 valid, 1 invalid, 2 usage or input error.
+
+#define STREAM_BUF (1 << 20)
+
+// move letters by direction index, as written by write_path
+static const char dir_letter[DIRS_DIAGONAL] = {'U', 'D', 'L', 'R', 'Q', 'E', 'Z', 'C'};
+
+typedef enum { OPTIMAL_NONE, OPTIMAL_STEPS, OPTIMAL_COST } Optimal;
+
+typedef struct {
+  FILE* fp;
+  unsigned char* buf;
+  size_t pos;
+  size_t len;
+} Stream;
+
+// replay state of a path
+typedef struct {
+  const Maze* maze;
+  bool diagonal;
+  int x, y;
+  long cells;        // path cells so far, start included
+  long cost;         // terrain cost, in COST_STRAIGHT units when diagonal
+  bool cost_known;   // false for rendered diagonal paths (step order lost)
+  char error[192];
+} Walk;
+
+static void usage(const char* program) {
+  fprintf(stderr, "Usage: %s <maze_file> <solution_file|-> [OPTIONS]\n", program);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --diag            8-directional movement (no corner cutting)\n");
+  fprintf(stderr, "  --format=FORMAT   grid, coords, moves, rle or binary (default: detected)\n");
+  fprintf(stderr, "  --length=N        the path must have N cells (the solver's path length)\n");
+  fprintf(stderr, "  --optimal         the path must have as few cells as the BFS path\n");
+  fprintf(stderr, "  --optimal=cost    the path must cost as little as the Dijkstra path\n");
+}
+
+// ======= INPUT ======
+
+static inline int stream_peek(Stream* s) {
+  if (s->pos == s->len) {
+    s->len = fread(s->buf, 1, STREAM_BUF, s->fp);
+    s->pos = 0;
+    if (s->len == 0) {
+      return EOF;
+    }
+  }
+  return s->buf[s->pos];
+}
+
+static inline int stream_get(Stream* s) {
+  int c = stream_peek(s);
+
+  if (c != EOF) {
+    s->pos++;
+  }
+  return c;
+}
+
+// nothing but whitespace left?
+static bool stream_done(Stream* s) {
+  int c;
+
+  while ((c = stream_get(s)) != EOF) {
+    if (c != '\n' && c != '\r' && c != ' ' && c != '\t') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool fail(Walk* w, const char* fmt, ...) {
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsnprintf(w->error, sizeof(w->error), fmt, ap);
+  va_end(ap);
+  return false;
+}
+
+// ======= ORDERED PATHS ======
+
+// one move in direction d from the current cell
+static bool walk_step(Walk* w, int d) {
+  const Maze* maze = w->maze;
+
+  if (d >= DIRS_ORTHOGONAL && !w->diagonal) {
+    return fail(w, "move %ld: diagonal move %c without --diag", w->cells, dir_letter[d]);
+  }
+  if (!can_move(maze, w->x, w->y, d)) {
+    return fail(w, "move %ld: %c from (%d, %d) hits a wall, leaves the maze or cuts a corner",
+                w->cells, dir_letter[d], w->x, w->y);
+  }
+  w->x += dir_dx[d];
+  w->y += dir_dy[d];
+  w->cells++;
+  w->cost += CELL_COST(maze->grid[IDX(w->x, w->y, maze->width)])
+           * (w->diagonal ? (d < DIRS_ORTHOGONAL ? COST_STRAIGHT : COST_DIAGONAL) : 1);
+  return true;
+}
+
+// moves and rle: direction letters, each optionally preceded by a count
+static bool verify_moves(Stream* s, Walk* w) {
+  long count = 0;
+  long i;
+  int c, d;
+
+  while ((c = stream_get(s)) != EOF && c != '\n') {
+    if (c >= '0' && c <= '9') {
+      count = count * 10 + (c - '0');
+      if (count > (long)w->maze->width * w->maze->height) {
+        return fail(w, "move %ld: run longer than the maze has cells", w->cells);
+      }
+      continue;
+    }
+    for (d = 0; d < DIRS_DIAGONAL && dir_letter[d] != c; d++) {
+    }
+    if (d == DIRS_DIAGONAL) {
+      return fail(w, "move %ld: unexpected character '%c'", w->cells, c);
+    }
+    for (i = count ? count : 1; i > 0; i--) {
+      if (!walk_step(w, d)) {
+        return false;
+      }
+    }
+    count = 0;
+  }
+  if (count) {
+    return fail(w, "run count without a move at the end");
+  }
+  return true;
+}
+
+// next non-negative integer of a coords line, -1 at the end of input
+static long read_int(Stream* s, bool* bad) {
+  long n = 0;
+  int c;
+
+  while ((c = stream_peek(s)) == ' ' || c == '\n' || c == '\r' || c == '\t') {
+    stream_get(s);
+  }
+  if (c == EOF) {
+    return -1;
+  }
+  if (c < '0' || c > '9') {
+    *bad = true;
+    return -1;
+  }
+  while ((c = stream_peek(s)) >= '0' && c <= '9') {
+    n = n * 10 + (stream_get(s) - '0');
+    if (n > INT32_MAX) {
+      *bad = true;
+      return -1;
+    }
+  }
+  return n;
+}
+
+// coords: "x y" per cell, from (0, 0), each next to the one before
+static bool verify_coords(Stream* s, Walk* w) {
+  bool bad = false;
+  long x, y;
+  int d;
+
+  while ((x = read_int(s, &bad)) >= 0) {
+    y = read_int(s, &bad);
+    if (y < 0) {
+      bad = true;
+      break;
+    }
+    if (w->cells == 0) {
+      if (x != 0 || y != 0) {
+        return fail(w, "line 1: path starts at (%ld, %ld), not at (0, 0)", x, y);
+      }
+      w->cells = 1;
+      continue;
+    }
+    for (d = 0; d < DIRS_DIAGONAL; d++) {
+      if (w->x + dir_dx[d] == x && w->y + dir_dy[d] == y) {
+        break;
+      }
+    }
+    if (d == DIRS_DIAGONAL) {
+      return fail(w, "line %ld: (%ld, %ld) is not next to (%d, %d)", w->cells + 1, x, y, w->x,
+                  w->y);
+    }
+    if (!walk_step(w, d)) {
+      return false;
+    }
+  }
+  if (bad) {
+    return fail(w, "line %ld: expected 'x y'", w->cells + 1);
+  }
+  if (w->cells == 0) {
+    return fail(w, "empty path");
+  }
+  return true;
+}
+
+static bool read_u32(Stream* s, uint32_t* out) {
+  uint32_t v = 0;
+  int i, c;
+
+  for (i = 0; i < 4; i++) {
+    if ((c = stream_get(s)) == EOF) {
+      return false;
+    }
+    v |= (uint32_t)c << (8 * i);
+  }
+  *out = v;
+  return true;
+}
+
+// binary: "MZP2", width, height, start x, start y, moves (u32), bits per
+// move (u8), moves
+static bool verify_binary(Stream* s, Walk* w) {
+  uint32_t width, height, start_x, start_y, moves, i;
+  int bits, byte = 0, fill = 8;
+  int c;
+
+  for (i = 0; i < 4; i++) {
+    if (stream_get(s) != "MZP2"[i]) {
+      return fail(w, "binary record without the MZP2 magic");
+    }
+  }
+  if (!read_u32(s, &width) || !read_u32(s, &height) || !read_u32(s, &start_x)
+      || !read_u32(s, &start_y) || !read_u32(s, &moves) || (bits = stream_get(s)) == EOF) {
+    return fail(w, "truncated binary header");
+  }
+  if (width != (uint32_t)w->maze->width || height != (uint32_t)w->maze->height) {
+    return fail(w, "binary record is %ux%u, the maze is %dx%d", width, height, w->maze->width,
+                w->maze->height);
+  }
+  if (start_x != 0 || start_y != 0) {
+    return fail(w, "binary path starts at (%u, %u), not at (0, 0)", start_x, start_y);
+  }
+  if (bits != 2 && bits != 4) {
+    return fail(w, "binary record with %d bits per move", bits);
+  }
+  for (i = 0; i < moves; i++) {
+    if (fill == 8) {
+      if ((c = stream_get(s)) == EOF) {
+        return fail(w, "binary record ends after %u of %u moves", i, moves);
+      }
+      byte = c;
+      fill = 0;
+    }
+    if (!walk_step(w, (byte >> fill) & ((1 << bits) - 1))) {
+      return false;
+    }
+    fill += bits;
+  }
+  if (stream_get(s) != EOF) {
+    return fail(w, "data after the last move");
+  }
+  return true;
+}
+
+// ======= RENDERED GRID ======
+
+static bool verify_grid(Stream* s, Walk* w) {
+  const Maze* maze = w->maze;
+  size_t cells = (size_t)maze->width * maze->height;
+  uint64_t* marked = calloc(cells / 64 + 1, sizeof(uint64_t));
+  int* queue = NULL;
+  long head = 0, tail = 0;
+  int x, y, d, c, m, cell, next, finish;
+  bool ok = false;
+
+  if (!marked) {
+    return fail(w, "out of memory");
+  }
+
+  // the grid must be the maze with some open cells turned into 'o'
+  for (y = 0; y < maze->height; y++) {
+    for (x = 0; x < maze->width; x++) {
+      c = stream_get(s);
+      m = maze->grid[IDX(x, y, maze->width)];
+      if (c == m) {
+        continue;
+      }
+      if (c == 'o' && IS_PASSABLE(m)) {
+        marked[IDX(x, y, maze->width) >> 6] |= (uint64_t)1 << (IDX(x, y, maze->width) & 63);
+        w->cells++;
+        w->cost += CELL_COST(m);
+        continue;
+      }
+      if (c == 'o') {
+        fail(w, "path crosses a wall at (%d, %d)", x, y);
+      } else if (c == EOF || c == '\n') {
+        fail(w, "row %d is %d cells short", y, maze->width - x);
+      } else {
+        fail(w, "(%d, %d) is '%c', the maze has '%c'", x, y, c, m);
+      }
+      goto done;
+    }
+    c = stream_get(s);
+    if (c == '\r') {
+      c = stream_get(s);
+    }
+    if (c != '\n' && !(c == EOF && y == maze->height - 1)) {
+      fail(w, "row %d is longer than the maze", y);
+      goto done;
+    }
+  }
+  if (!stream_done(s)) {
+    fail(w, "data after the last row");
+    goto done;
+  }
+
+  // the start cell is not entered, so it adds no cost
+  w->cost -= CELL_COST(maze->grid[0]);
+  w->cost_known = !w->diagonal;
+  w->x = maze->width - 1;
+  w->y = maze->height - 1;
+  finish = IDX(w->x, w->y, maze->width);
+  if (!(marked[0] & 1)) {
+    fail(w, "start (0, 0) is not on the path");
+    goto done;
+  }
+  if (!((marked[finish >> 6] >> (finish & 63)) & 1)) {
+    fail(w, "finish (%d, %d) is not on the path", w->x, w->y);
+    goto done;
+  }
+
+  // every marked cell reachable from the start through marked cells
+  queue = malloc((size_t)w->cells * sizeof(int));
+  if (!queue) {
+    fail(w, "out of memory");
+    goto done;
+  }
+  marked[0] &= ~(uint64_t)1;
+  queue[tail++] = 0;
+  while (head < tail) {
+    cell = queue[head++];
+    x = cell % maze->width;
+    y = cell / maze->width;
+    for (d = 0; d < (w->diagonal ? DIRS_DIAGONAL : DIRS_ORTHOGONAL); d++) {
+      next = IDX(x + dir_dx[d], y + dir_dy[d], maze->width);
+      if (can_move(maze, x, y, d) && (marked[next >> 6] >> (next & 63)) & 1) {
+        marked[next >> 6] &= ~((uint64_t)1 << (next & 63));
+        queue[tail++] = next;
+      }
+    }
+  }
+  ok = tail == w->cells
+    || fail(w, "%ld marked cells are not connected to the start", w->cells - tail);
+
+done:
+  free(queue);
+  free(marked);
+  return ok;
+}
+
+// ======= DRIVER ======
+
+static bool parse_format(const char* text, PathFormat* out) {
+  static const char* const names[] = {"grid", "coords", "moves", "rle", "binary"};
+  static const PathFormat formats[] = {PATH_GRID, PATH_COORDS, PATH_MOVES, PATH_RLE, PATH_BINARY};
+  int i;
+
+  for (i = 0; i < 5; i++) {
+    if (strcmp(text, names[i]) == 0) {
+      *out = formats[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+// the solver's outputs start differently: 'o' (grid, start is on the
+// path), "0 0" (coords), 'M' (binary), a letter, a count or an empty
+// line (moves and rle)
+static PathFormat detect_format(Stream* s) {
+  int c = stream_peek(s);
+
+  if (c == 'o') {
+    return PATH_GRID;
+  }
+  if (c == '0') {
+    return PATH_COORDS;
+  }
+  if (c == 'M') {
+    return PATH_BINARY;
+  }
+  return PATH_RLE;
+}
+
+// a "no solution found" line instead of a path?
+static bool claims_no_path(Stream* s) {
+  static const char text[] = "no solution found";
+  size_t i;
+
+  if (stream_peek(s) != 'n') {
+    return false;
+  }
+  // the whole line is in the buffer unless the output is broken anyway
+  for (i = 0; i < sizeof(text) - 1; i++) {
+    if (s->pos + i >= s->len || s->buf[s->pos + i] != text[i]) {
+      return false;
+    }
+  }
+  s->pos += sizeof(text) - 1;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  SolverOptions opts = { 0 };
+  PathFormat format = PATH_GRID;
+  bool detect = true;
+  Optimal optimal = OPTIMAL_NONE;
+  long length = -1;
+  Walk walk = { 0 };
+  Stream stream = { 0 };
+  SolverStats stats;
+  MazeStatus status;
+  Maze* maze;
+  char* end;
+  bool ok;
+  int i;
+
+  if (argc < 3) {
+    usage(argv[0]);
+    return 2;
+  }
+  for (i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "--diag") == 0) {
+      opts.diagonal = true;
+    } else if (strncmp(argv[i], "--format=", 9) == 0) {
+      if (!parse_format(argv[i] + 9, &format)) {
+        fprintf(stderr, "Unknown output format: %s\n", argv[i] + 9);
+        return 2;
+      }
+      detect = false;
+    } else if (strncmp(argv[i], "--length=", 9) == 0) {
+      length = strtol(argv[i] + 9, &end, 10);
+      if (end == argv[i] + 9 || *end || length < 0) {
+        fprintf(stderr, "Invalid length: %s\n", argv[i] + 9);
+        return 2;
+      }
+    } else if (strcmp(argv[i], "--optimal") == 0) {
+      optimal = OPTIMAL_STEPS;
+    } else if (strcmp(argv[i], "--optimal=cost") == 0) {
+      optimal = OPTIMAL_COST;
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[i]);
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  status = load_maze(argv[1], NULL, &maze);
+  if (status != MAZE_OK) {
+    fprintf(stderr, "[ERROR]: %s: %s\n", argv[1], maze_strerror(status));
+    return 2;
+  }
+  status = validate_maze(maze);
+  if (status != MAZE_OK && status != MAZE_NO_PATH) {
+    fprintf(stderr, "[ERROR]: %s: %s\n", argv[1], maze_strerror(status));
+    free_maze(maze);
+    return 2;
+  }
+
+  stream.fp = strcmp(argv[2], "-") == 0 ? stdin : fopen(argv[2], "rb");
+  stream.buf = malloc(STREAM_BUF);
+  if (!stream.fp || !stream.buf) {
+    fprintf(stderr, "[ERROR]: cannot read solution %s\n", argv[2]);
+    free(stream.buf);
+    free_maze(maze);
+    return 2;
+  }
+
+  walk.maze = maze;
+  walk.diagonal = opts.diagonal;
+  walk.cells = 1;
+  walk.cost_known = true;
+
+  // "no solution found": only the search can tell whether that is true
+  if (claims_no_path(&stream)) {
+    ok = stream_done(&stream);
+    if (!ok) {
+      fail(&walk, "data after 'no solution found'");
+    } else if (optimal == OPTIMAL_NONE) {
+      printf("OK: no path claimed (unchecked, see --optimal)\n");
+    } else if (solve_bfs_stats(maze, &opts, &stats) == MAZE_OK) {
+      ok = fail(&walk, "no path claimed, but the finish is %d cells away", stats.path_length);
+    } else {
+      printf("OK: no path, confirmed by BFS\n");
+    }
+  } else {
+    if (detect) {
+      format = detect_format(&stream);
+    }
+    if (status == MAZE_NO_PATH) {
+      ok = fail(&walk, "path claimed, but the start or the finish is blocked");
+    } else if (format == PATH_GRID) {
+      walk.cells = 0;
+      ok = verify_grid(&stream, &walk);
+    } else if (format == PATH_COORDS) {
+      walk.cells = 0;
+      ok = verify_coords(&stream, &walk);
+    } else if (format == PATH_BINARY) {
+      ok = verify_binary(&stream, &walk);
+    } else {
+      ok = verify_moves(&stream, &walk) && (stream_done(&stream) || fail(&walk, "data after the moves"));
+    }
+
+    // where the replay ended, what it measured, and what the search says
+    if (ok && (walk.x != maze->width - 1 || walk.y != maze->height - 1)) {
+      ok = fail(&walk, "path ends at (%d, %d), not at the finish", walk.x, walk.y);
+    }
+    if (ok && length >= 0 && walk.cells != length) {
+      ok = fail(&walk, "path has %ld cells, %ld claimed", walk.cells, length);
+    }
+    if (ok && optimal == OPTIMAL_STEPS && solve_bfs_stats(maze, &opts, &stats) == MAZE_OK
+        && walk.cells != stats.path_length) {
+      ok = fail(&walk, "path has %ld cells, the shortest has %d", walk.cells, stats.path_length);
+    }
+    if (ok && optimal == OPTIMAL_COST && !walk.cost_known) {
+      ok = fail(&walk, "the cost of a rendered diagonal path is ambiguous, use a path format");
+    }
+    if (ok && optimal == OPTIMAL_COST && solve_dijkstra_stats(maze, &opts, &stats) == MAZE_OK
+        && (double)walk.cost / (opts.diagonal ? COST_STRAIGHT : 1) != stats.path_cost) {
+      ok = fail(&walk, "path costs %g, the cheapest costs %g",
+                (double)walk.cost / (opts.diagonal ? COST_STRAIGHT : 1), stats.path_cost);
+    }
+    if (ok && walk.cost_known) {
+      printf("OK: %ld cells, cost %g\n", walk.cells,
+             (double)walk.cost / (opts.diagonal ? COST_STRAIGHT : 1));
+    } else if (ok) {
+      printf("OK: %ld cells\n", walk.cells);
+    }
+  }
+
+  if (!ok) {
+    printf("INVALID: %s\n", walk.error);
+  }
+  if (stream.fp != stdin) {
+    fclose(stream.fp);
+  }
+  free(stream.buf);
+  free_maze(maze);
+  return ok ? 0 : 1;
+}